@@ -0,0 +1,27 @@
+#include "base/cpu_affinity.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+int CurrentCpu() {
+#ifdef __linux__
+  return sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
+bool PinToCpu(int cpu) {
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
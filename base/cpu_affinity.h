@@ -0,0 +1,13 @@
+// Pinning the calling thread to a CPU, for stable benchmark timings.
+
+#ifndef BASE_CPU_AFFINITY_H_
+#define BASE_CPU_AFFINITY_H_
+
+// Returns the CPU the calling thread is running on, or -1 if unknown.
+int CurrentCpu();
+
+// Pins the calling thread to `cpu`. Returns false if pinning is not
+// supported on this platform, or the CPU is not allowed.
+bool PinToCpu(int cpu);
+
+#endif /* BASE_CPU_AFFINITY_H_ */
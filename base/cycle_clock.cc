@@ -0,0 +1,32 @@
+#include "base/cycle_clock.h"
+
+namespace {
+
+// Measures the tick rate against steady_clock over a short interval.
+double CalibrateNanosPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+  const auto kCalibrationTime = std::chrono::milliseconds(20);
+
+  auto start_time = std::chrono::steady_clock::now();
+  int64_t start_ticks = CycleClock::Now();
+  std::chrono::steady_clock::time_point now;
+  do {
+    now = std::chrono::steady_clock::now();
+  } while (now - start_time < kCalibrationTime);
+  int64_t ticks = CycleClock::Now() - start_ticks;
+
+  double nanos =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time)
+          .count();
+  return ticks > 0 ? nanos / ticks : 1.0;
+#else
+  return 1.0;
+#endif
+}
+
+} // namespace
+
+double CycleClock::NanosPerTick() {
+  static const double nanos_per_tick = CalibrateNanosPerTick();
+  return nanos_per_tick;
+}
@@ -0,0 +1,32 @@
+// Low-overhead timestamps for latency sampling.
+
+#ifndef BASE_CYCLE_CLOCK_H_
+#define BASE_CYCLE_CLOCK_H_
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// A clock that reads the CPU timestamp counter where available, and falls
+// back to std::chrono::steady_clock otherwise.
+class CycleClock {
+public:
+  // Returns the current tick count.
+  static int64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return static_cast<int64_t>(__rdtsc());
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  // Nanoseconds per tick. Calibrated against steady_clock on first use.
+  static double NanosPerTick();
+};
+
+#endif /* BASE_CYCLE_CLOCK_H_ */
@@ -0,0 +1,326 @@
+// Flat hash map.
+//
+// An open addressing hash map that keeps its entries in one array, for small
+// keys and values such as ids, array positions and pointers. It probes
+// linearly, comparing 16 control bytes at a time (with SSE2 when the compiler
+// targets it), in the style of Abseil's Swiss tables. Each control byte is
+// either kEmpty or 7 bits of the hash of the key in its slot, so most probes
+// never read the keys.
+//
+// Erase() shifts the following entries of the probe run back into the hole
+// instead of leaving a tombstone, so lookups stop at the first empty slot no
+// matter how many keys were erased, and the map never needs a rehash to
+// clean up.
+//
+// The keys and values must be default constructible and cheap to move.
+// Pointers to values are invalidated by Insert(), Set() and Erase().
+
+#ifndef BASE_FLAT_HASH_MAP_H_
+#define BASE_FLAT_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "base/memory.h"
+
+namespace flat_hash_map_internal {
+
+// The number of control bytes compared at a time.
+constexpr size_t kGroupWidth = 16;
+
+// The control byte of an empty slot. Full slots have the top bit clear.
+constexpr uint8_t kEmpty = 0x80;
+
+// A bitmask of the slots in a group, bit i for slot i.
+#ifdef __SSE2__
+inline uint32_t MatchByte(const uint8_t *ctrl, uint8_t byte) {
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<uint32_t>(_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(byte)))));
+}
+
+inline uint32_t MatchEmpty(const uint8_t *ctrl) {
+  // kEmpty is the only control byte with the top bit set.
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl));
+  return static_cast<uint32_t>(_mm_movemask_epi8(group));
+}
+#else
+inline uint32_t MatchByte(const uint8_t *ctrl, uint8_t byte) {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; ++i) {
+    mask |= static_cast<uint32_t>(ctrl[i] == byte) << i;
+  }
+  return mask;
+}
+
+inline uint32_t MatchEmpty(const uint8_t *ctrl) {
+  return MatchByte(ctrl, kEmpty);
+}
+#endif
+
+} // namespace flat_hash_map_internal
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap {
+public:
+  FlatHashMap() : size_(0), mask_(0) {}
+
+  // Returns the number of entries.
+  int size() const { return static_cast<int>(size_); }
+
+  bool empty() const { return size_ == 0; }
+
+  // Returns the value of a key, or nullptr if the key is not in the map.
+  Value *Find(const Key &key) {
+    const size_t slot = FindSlot_(key);
+    return slot == kNotFound ? nullptr : &slots_[slot].second;
+  }
+  const Value *Find(const Key &key) const {
+    const size_t slot = FindSlot_(key);
+    return slot == kNotFound ? nullptr : &slots_[slot].second;
+  }
+
+  // Adds a key with its value. Returns false, and leaves the map unchanged,
+  // if the key is already in the map.
+  bool Insert(const Key &key, Value value);
+
+  // Sets the value of a key, adding the key if it is not in the map.
+  void Set(const Key &key, Value value);
+
+  // Removes a key. Returns false if the key is not in the map.
+  bool Erase(const Key &key);
+
+  // Makes room for `size` entries without growing.
+  void Reserve(int size);
+
+  // Removes all the entries, keeping the allocated slots.
+  void Clear();
+
+  // Calls `fn(key, value)` for each entry.
+  template <typename Fn> void ForEach(Fn fn) const {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      if (ctrl_[i] != flat_hash_map_internal::kEmpty) {
+        fn(slots_[i].first, slots_[i].second);
+      }
+    }
+  }
+
+  // Returns the approximate bytes allocated by the map.
+  long MemoryUsage() const {
+    return ContainerMemoryUsage(ctrl_) + ContainerMemoryUsage(slots_);
+  }
+
+private:
+  static const size_t kNotFound = ~size_t{0};
+
+  // The smallest number of slots: one group, so that a group load never
+  // reads past the cloned control bytes.
+  static const size_t kMinCapacity = flat_hash_map_internal::kGroupWidth;
+
+  // Returns the mixed hash of a key. std::hash of an int is the int itself,
+  // so the bits are spread before they are split into the slot and the
+  // control byte.
+  static size_t Hash_(const Key &key) {
+    uint64_t hash = static_cast<uint64_t>(Hash()(key)) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+  }
+
+  // The home slot of a hash, and its control byte.
+  size_t HomeSlot_(size_t hash) const { return (hash >> 7) & mask_; }
+  static uint8_t ControlByte_(size_t hash) { return hash & 0x7f; }
+
+  // Returns the slot of a key, or kNotFound.
+  size_t FindSlot_(const Key &key) const;
+
+  // Returns the first empty slot at or after `slot`.
+  size_t FindEmpty_(size_t slot) const;
+
+  // Sets the control byte of a slot, and its clone after the last slot.
+  void SetControl_(size_t slot, uint8_t byte);
+
+  // Adds a key that is not in the map, growing the map if needed. Returns
+  // its slot.
+  size_t InsertNew_(const Key &key, Value value);
+
+  // Moves the entries to `capacity` slots.
+  void Rehash_(size_t capacity);
+
+  // Returns true if more than 3/4 of the slots would be full with `size`
+  // entries.
+  bool Overloaded_(size_t size) const {
+    return size * 4 > slots_.size() * 3;
+  }
+
+  size_t size_;
+
+  // The number of slots minus one. The number of slots is a power of 2.
+  size_t mask_;
+
+  // A control byte for each slot, followed by clones of the first
+  // kGroupWidth of them, so that a group starting at any slot can be loaded
+  // at once.
+  std::vector<uint8_t> ctrl_;
+
+  // The entries, valid where the control byte is not kEmpty.
+  std::vector<std::pair<Key, Value>> slots_;
+};
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::FindSlot_(const Key &key) const {
+  if (size_ == 0) {
+    return kNotFound;
+  }
+  const size_t hash = Hash_(key);
+  const uint8_t byte = ControlByte_(hash);
+  size_t slot = HomeSlot_(hash);
+  while (true) {
+    const uint8_t *group = &ctrl_[slot];
+    uint32_t match = flat_hash_map_internal::MatchByte(group, byte);
+    const uint32_t empty = flat_hash_map_internal::MatchEmpty(group);
+    if (empty != 0) {
+      // Entries after the first empty slot belong to other probe runs.
+      match &= (empty & -empty) - 1;
+    }
+    while (match != 0) {
+      const size_t found = (slot + __builtin_ctz(match)) & mask_;
+      if (slots_[found].first == key) {
+        return found;
+      }
+      match &= match - 1;
+    }
+    if (empty != 0) {
+      return kNotFound;
+    }
+    slot = (slot + flat_hash_map_internal::kGroupWidth) & mask_;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::FindEmpty_(size_t slot) const {
+  while (true) {
+    const uint32_t empty = flat_hash_map_internal::MatchEmpty(&ctrl_[slot]);
+    if (empty != 0) {
+      return (slot + __builtin_ctz(empty)) & mask_;
+    }
+    slot = (slot + flat_hash_map_internal::kGroupWidth) & mask_;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::SetControl_(size_t slot, uint8_t byte) {
+  ctrl_[slot] = byte;
+  if (slot < flat_hash_map_internal::kGroupWidth) {
+    ctrl_[slots_.size() + slot] = byte;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+bool FlatHashMap<Key, Value, Hash>::Insert(const Key &key, Value value) {
+  if (FindSlot_(key) != kNotFound) {
+    return false;
+  }
+  InsertNew_(key, std::move(value));
+  return true;
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::Set(const Key &key, Value value) {
+  const size_t slot = FindSlot_(key);
+  if (slot != kNotFound) {
+    slots_[slot].second = std::move(value);
+  } else {
+    InsertNew_(key, std::move(value));
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t FlatHashMap<Key, Value, Hash>::InsertNew_(const Key &key,
+                                                  Value value) {
+  if (slots_.empty() || Overloaded_(size_ + 1)) {
+    size_t capacity = slots_.size() * 2;
+    if (capacity == 0) {
+      capacity = kMinCapacity;
+    }
+    Rehash_(capacity);
+  }
+  const size_t hash = Hash_(key);
+  const size_t slot = FindEmpty_(HomeSlot_(hash));
+  SetControl_(slot, ControlByte_(hash));
+  slots_[slot].first = key;
+  slots_[slot].second = std::move(value);
+  size_++;
+  return slot;
+}
+
+template <typename Key, typename Value, typename Hash>
+bool FlatHashMap<Key, Value, Hash>::Erase(const Key &key) {
+  size_t hole = FindSlot_(key);
+  if (hole == kNotFound) {
+    return false;
+  }
+  // Shift back each following entry of the run that may move into the hole:
+  // one whose home slot is not after the hole, cyclically.
+  size_t slot = (hole + 1) & mask_;
+  while (ctrl_[slot] != flat_hash_map_internal::kEmpty) {
+    const size_t home = HomeSlot_(Hash_(slots_[slot].first));
+    if (((slot - home) & mask_) >= ((slot - hole) & mask_)) {
+      SetControl_(hole, ctrl_[slot]);
+      slots_[hole] = std::move(slots_[slot]);
+      hole = slot;
+    }
+    slot = (slot + 1) & mask_;
+  }
+  SetControl_(hole, flat_hash_map_internal::kEmpty);
+  slots_[hole] = std::pair<Key, Value>();
+  size_--;
+  return true;
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::Reserve(int size) {
+  size_t capacity = slots_.size();
+  if (capacity == 0) {
+    capacity = kMinCapacity;
+  }
+  while (capacity * 3 < static_cast<size_t>(size) * 4) {
+    capacity *= 2;
+  }
+  if (capacity != slots_.size()) {
+    Rehash_(capacity);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::Clear() {
+  std::fill(ctrl_.begin(), ctrl_.end(), flat_hash_map_internal::kEmpty);
+  std::fill(slots_.begin(), slots_.end(), std::pair<Key, Value>());
+  size_ = 0;
+}
+
+template <typename Key, typename Value, typename Hash>
+void FlatHashMap<Key, Value, Hash>::Rehash_(size_t capacity) {
+  std::vector<uint8_t> old_ctrl(capacity + flat_hash_map_internal::kGroupWidth,
+                                flat_hash_map_internal::kEmpty);
+  std::vector<std::pair<Key, Value>> old_slots(capacity);
+  old_ctrl.swap(ctrl_);
+  old_slots.swap(slots_);
+  mask_ = capacity - 1;
+  for (size_t i = 0; i < old_slots.size(); ++i) {
+    if (old_ctrl[i] != flat_hash_map_internal::kEmpty) {
+      const size_t hash = Hash_(old_slots[i].first);
+      const size_t slot = FindEmpty_(HomeSlot_(hash));
+      SetControl_(slot, ControlByte_(hash));
+      slots_[slot] = std::move(old_slots[i]);
+    }
+  }
+}
+
+#endif /* BASE_FLAT_HASH_MAP_H_ */
@@ -0,0 +1,80 @@
+#include "base/histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Index of the most significant set bit. `value` must be positive.
+int HighestBit(uint64_t value) { return 63 - __builtin_clzll(value); }
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(BucketIndex_(std::numeric_limits<int64_t>::max()) + 1, 0),
+      count_(0), sum_(0), min_(std::numeric_limits<int64_t>::max()), max_(0) {
+}
+
+int LatencyHistogram::BucketIndex_(int64_t value) {
+  if (value < 2 * kSubBuckets) {
+    return static_cast<int>(value);
+  }
+  // Keep the top (kSubBucketBits + 1) bits of the value. The sub-bucket is in
+  // [kSubBuckets, 2 * kSubBuckets), and each shift adds kSubBuckets buckets.
+  int shift = HighestBit(value) - kSubBucketBits;
+  int sub_bucket = static_cast<int>(value >> shift);
+  return shift * kSubBuckets + sub_bucket;
+}
+
+int64_t LatencyHistogram::BucketHighestValue_(int index) {
+  if (index < 2 * kSubBuckets) {
+    return index;
+  }
+  int shift = index / kSubBuckets - 1;
+  int64_t sub_bucket = index % kSubBuckets + kSubBuckets;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(int64_t value) {
+  if (value < 0) {
+    value = 0;
+  }
+  counts_[BucketIndex_(value)]++;
+  count_++;
+  sum_ += value;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+  for (int i = 0; i < counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::Mean() const {
+  return count_ > 0 ? static_cast<double>(sum_) / count_ : 0;
+}
+
+int64_t LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  int64_t target =
+      static_cast<int64_t>(std::ceil(percentile / 100 * count_));
+  target = std::max<int64_t>(1, std::min(target, count_));
+
+  int64_t seen = 0;
+  for (int i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= target) {
+      return std::min(BucketHighestValue_(i), max_);
+    }
+  }
+  return max_;
+}
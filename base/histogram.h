@@ -0,0 +1,57 @@
+// HDR-style histogram for latency measurements.
+
+#ifndef BASE_HISTOGRAM_H_
+#define BASE_HISTOGRAM_H_
+
+#include <cstdint>
+#include <vector>
+
+// A histogram of non-negative values with bounded relative error.
+//
+// Values below 2 * kSubBuckets are counted exactly. Above that, each
+// power-of-two range is split into kSubBuckets linear sub-buckets, so any
+// recorded value is reported within 1/kSubBuckets (~3%) of its true value.
+// Recording is a few shifts and an increment; no allocation.
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  // Records a value. Negative values are clamped to 0.
+  void Record(int64_t value);
+
+  // Adds all the values recorded in `other`.
+  void Merge(const LatencyHistogram &other);
+
+  // Number of recorded values.
+  int64_t count() const { return count_; }
+
+  // Smallest and largest recorded values. Exact, not bucketed.
+  int64_t min() const { return count_ > 0 ? min_ : 0; }
+  int64_t max() const { return max_; }
+
+  // Mean of the recorded values.
+  double Mean() const;
+
+  // Returns the value at or below which `percentile` (0 to 100) percent of
+  // the recorded values fall.
+  int64_t Percentile(double percentile) const;
+
+private:
+  // Number of linear sub-buckets in each power-of-two range.
+  static const int kSubBucketBits = 5;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+
+  // Returns the bucket index for a value.
+  static int BucketIndex_(int64_t value);
+
+  // Returns the largest value that maps to the bucket index.
+  static int64_t BucketHighestValue_(int index);
+
+  std::vector<int64_t> counts_;
+  int64_t count_;
+  int64_t sum_;
+  int64_t min_;
+  int64_t max_;
+};
+
+#endif /* BASE_HISTOGRAM_H_ */
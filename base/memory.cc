@@ -0,0 +1,108 @@
+#include "base/memory.h"
+
+#include <atomic>
+#include <cstdio>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<bool> tracking_enabled(false);
+std::atomic<long> allocated_bytes(0);
+std::atomic<long> peak_allocated_bytes(0);
+
+} // namespace
+
+long PeakRssBytes() {
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return -1;
+  }
+#ifdef __APPLE__
+  // Reported in bytes on macOS.
+  return usage.ru_maxrss;
+#else
+  // Reported in kilobytes on Linux.
+  return usage.ru_maxrss * 1024L;
+#endif
+#else
+  return -1;
+#endif
+}
+
+long CurrentRssBytes() {
+#ifdef __linux__
+  // The second field of /proc/self/statm is the resident set size in pages.
+  FILE *statm = std::fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return -1;
+  }
+  long total_pages, resident_pages;
+  int num_read = std::fscanf(statm, "%ld %ld", &total_pages, &resident_pages);
+  std::fclose(statm);
+  if (num_read != 2) {
+    return -1;
+  }
+  return resident_pages * sysconf(_SC_PAGESIZE);
+#else
+  return -1;
+#endif
+}
+
+long PhysicalMemoryBytes() {
+#if defined(__linux__) || defined(__APPLE__)
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (pages < 0 || page_size < 0) {
+    return -1;
+  }
+  return pages * page_size;
+#else
+  return -1;
+#endif
+}
+
+long AllocatedBytes() {
+  if (!tracking_enabled.load(std::memory_order_relaxed)) {
+    return -1;
+  }
+  return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+long PeakAllocatedBytes() {
+  if (!tracking_enabled.load(std::memory_order_relaxed)) {
+    return -1;
+  }
+  return peak_allocated_bytes.load(std::memory_order_relaxed);
+}
+
+void ResetPeakAllocatedBytes() {
+  peak_allocated_bytes.store(allocated_bytes.load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+}
+
+namespace memory_internal {
+
+void EnableAllocationTracking() {
+  tracking_enabled.store(true, std::memory_order_relaxed);
+}
+
+void RecordAllocation(long bytes) {
+  long allocated =
+      allocated_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  long peak = peak_allocated_bytes.load(std::memory_order_relaxed);
+  while (allocated > peak &&
+         !peak_allocated_bytes.compare_exchange_weak(
+             peak, allocated, std::memory_order_relaxed)) {
+  }
+}
+
+void RecordDeallocation(long bytes) {
+  allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+} // namespace memory_internal
@@ -0,0 +1,132 @@
+// Process memory usage, and memory accounting for data structures.
+
+#ifndef BASE_MEMORY_H_
+#define BASE_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+// Returns the peak resident set size of the process in bytes, or -1 if it is
+// not available on this platform.
+long PeakRssBytes();
+
+// Returns the current resident set size of the process in bytes, or -1 if it
+// is not available on this platform.
+long CurrentRssBytes();
+
+// Returns the physical memory of the machine in bytes, or -1 if unknown.
+long PhysicalMemoryBytes();
+
+// Returns the bytes currently allocated with operator new, or -1 if
+// allocations are not tracked. They are only tracked in binaries that link
+// in //base:memory_tracking.
+long AllocatedBytes();
+
+// Returns the most bytes allocated at once since the last call to
+// ResetPeakAllocatedBytes(), or -1 if allocations are not tracked.
+long PeakAllocatedBytes();
+
+// Resets the peak to the bytes currently allocated.
+void ResetPeakAllocatedBytes();
+
+// Approximate size of the malloc chunk that holds an allocation of `bytes`:
+// 8 bytes of header, rounded up to 16 bytes, and at least 32 bytes.
+inline long AllocationSize(long bytes) {
+  long size = (bytes + 8 + 15) & ~15L;
+  return size < 32 ? 32 : size;
+}
+
+// An allocator of blocks aligned to kAlignment bytes, a power of 2, e.g.
+// to start an array on a VM page. It takes kAlignment bytes more from
+// operator new than it returns, and keeps the allocated pointer just before
+// the aligned block.
+template <typename T, size_t kAlignment> class AlignedAllocator {
+public:
+  static_assert((kAlignment & (kAlignment - 1)) == 0 &&
+                    kAlignment >= sizeof(void *),
+                "The alignment must be a power of 2, at least a pointer");
+
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, kAlignment>;
+  };
+
+  AlignedAllocator() {}
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, kAlignment> &) {}
+
+  T *allocate(size_t n) {
+    char *allocated =
+        static_cast<char *>(::operator new(n * sizeof(T) + kAlignment));
+    const uintptr_t aligned =
+        (reinterpret_cast<uintptr_t>(allocated) + kAlignment) &
+        ~(uintptr_t{kAlignment} - 1);
+    reinterpret_cast<char **>(aligned)[-1] = allocated;
+    return reinterpret_cast<T *>(aligned);
+  }
+
+  void deallocate(T *p, size_t) {
+    ::operator delete(reinterpret_cast<char **>(p)[-1]);
+  }
+};
+
+template <typename T, typename U, size_t kAlignment>
+bool operator==(const AlignedAllocator<T, kAlignment> &,
+                const AlignedAllocator<U, kAlignment> &) {
+  return true;
+}
+
+template <typename T, typename U, size_t kAlignment>
+bool operator!=(const AlignedAllocator<T, kAlignment> &,
+                const AlignedAllocator<U, kAlignment> &) {
+  return false;
+}
+
+// Approximate bytes allocated by a vector, excluding the vector itself.
+template <typename T, typename Allocator>
+long ContainerMemoryUsage(const std::vector<T, Allocator> &container) {
+  if (container.capacity() == 0) {
+    return 0;
+  }
+  return AllocationSize(container.capacity() * sizeof(T));
+}
+
+// Approximate bytes allocated by a vector with an AlignedAllocator, which
+// pads each block by the alignment.
+template <typename T, size_t kAlignment>
+long ContainerMemoryUsage(
+    const std::vector<T, AlignedAllocator<T, kAlignment>> &container) {
+  if (container.capacity() == 0) {
+    return 0;
+  }
+  return AllocationSize(container.capacity() * sizeof(T) + kAlignment);
+}
+
+// Approximate bytes allocated by an unordered_map: the bucket array, and one
+// node per element holding the value and a next pointer.
+template <typename Key, typename Value, typename Hash, typename KeyEqual,
+          typename Allocator>
+long ContainerMemoryUsage(const std::unordered_map<Key, Value, Hash, KeyEqual,
+                                                   Allocator> &container) {
+  using ValueType =
+      typename std::unordered_map<Key, Value, Hash, KeyEqual,
+                                  Allocator>::value_type;
+  return AllocationSize(container.bucket_count() * sizeof(void *)) +
+         container.size() * AllocationSize(sizeof(void *) + sizeof(ValueType));
+}
+
+namespace memory_internal {
+
+// Called by the operator new and delete hooks in //base:memory_tracking.
+void EnableAllocationTracking();
+void RecordAllocation(long bytes);
+void RecordDeallocation(long bytes);
+
+} // namespace memory_internal
+
+#endif /* BASE_MEMORY_H_ */
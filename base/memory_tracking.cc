@@ -0,0 +1,80 @@
+// Replaces the global operator new and delete to count the bytes allocated,
+// for AllocatedBytes() and PeakAllocatedBytes() in base/memory.h.
+// Link this into a binary to enable tracking; it has no header.
+//
+// Each allocation counts as the usable size of its malloc block plus one word
+// of header, to match AllocationSize() in base/memory.h.
+
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__)
+#include <malloc.h>
+#define MEMORY_TRACKING_USABLE_SIZE(p) malloc_usable_size(p)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define MEMORY_TRACKING_USABLE_SIZE(p) malloc_size(p)
+#endif
+
+#include "base/memory.h"
+
+#ifdef MEMORY_TRACKING_USABLE_SIZE
+
+namespace {
+
+long BlockSize(void *p) {
+  return static_cast<long>(MEMORY_TRACKING_USABLE_SIZE(p) + sizeof(void *));
+}
+
+void *Allocate(std::size_t size) {
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p != nullptr) {
+    memory_internal::RecordAllocation(BlockSize(p));
+  }
+  return p;
+}
+
+void Deallocate(void *p) {
+  if (p != nullptr) {
+    memory_internal::RecordDeallocation(BlockSize(p));
+    std::free(p);
+  }
+}
+
+const bool kTrackingEnabled =
+    (memory_internal::EnableAllocationTracking(), true);
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  void *p = Allocate(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void *p) noexcept { Deallocate(p); }
+void operator delete[](void *p) noexcept { Deallocate(p); }
+void operator delete(void *p, std::size_t) noexcept { Deallocate(p); }
+void operator delete[](void *p, std::size_t) noexcept { Deallocate(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  Deallocate(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  Deallocate(p);
+}
+
+#endif // MEMORY_TRACKING_USABLE_SIZE
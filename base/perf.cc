@@ -1,19 +1,59 @@
 #include "base/perf.h"
 
-PerfTimer::PerfTimer() : started_(false), total_ms_(0) {}
+#include <cassert>
+#include <iostream>
+
+PerfTimer::PerfTimer()
+    : started_(false), latencies_enabled_(true), total_us_(0) {}
 
 void PerfTimer::Start() {
   assert(!started_);
+  counters_.Start();
   start_time_ = clock_.now();
 }
 
 void PerfTimer::Stop() {
   stop_time_ = clock_.now();
+  counters_.Stop();
   started_ = false;
 
-  total_ms_ += std::chrono::duration_cast<std::chrono::microseconds>(
+  total_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
                    stop_time_ - start_time_)
                    .count();
 }
 
 void PerfTimer::Report(const std::string &report) { report_ = report; }
+
+LatencyHistogram *PerfTimer::OperationLatency(const std::string &operation) {
+  if (!latencies_enabled_) {
+    return nullptr;
+  }
+  return &operation_latencies_[operation];
+}
+
+long PerfTimer::NumOperations() const {
+  long num_operations = 0;
+  for (const auto &entry : operation_latencies_) {
+    num_operations += entry.second.count();
+  }
+  return num_operations;
+}
+
+void PrintOperationLatencies(
+    const std::map<std::string, LatencyHistogram> &operation_latencies,
+    std::ostream &out) {
+  const double nanos_per_tick = CycleClock::NanosPerTick();
+  auto nanos = [nanos_per_tick](int64_t ticks) -> long {
+    return static_cast<long>(ticks * nanos_per_tick);
+  };
+
+  for (const auto &entry : operation_latencies) {
+    const LatencyHistogram &latency = entry.second;
+    out << "  " << entry.first << " latency (ns): p50 "
+        << nanos(latency.Percentile(50)) << ", p99 "
+        << nanos(latency.Percentile(99)) << ", p999 "
+        << nanos(latency.Percentile(99.9)) << ", max "
+        << nanos(latency.max()) << " (" << latency.count() << " ops)"
+        << std::endl;
+  }
+}
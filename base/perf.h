@@ -2,9 +2,17 @@
 #define BASE_PERF_H_
 
 #include <chrono>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
-// Timer for performance measurement.
+#include "base/cycle_clock.h"
+#include "base/histogram.h"
+#include "base/perf_counters.h"
+
+// Timer for performance measurement. Hardware counters, where available, are
+// read around each Start and Stop.
 class PerfTimer {
 public:
   PerfTimer();
@@ -15,8 +23,8 @@ public:
   // Stop the timer.
   void Stop();
 
-  // Time taken between Start and Stop.
-  long TotalDurationMs() const { return total_ms_; }
+  // Time taken between Start and Stop, in microseconds.
+  long TotalDurationUs() const { return total_us_; }
 
   // Returns a report tagged with the timing.
   std::string Report() const { return report_; }
@@ -24,19 +32,80 @@ public:
   // An optional report can be tagged with the timing.
   void Report(const std::string &report);
 
+  // Optional named statistics can be tagged with the timing.
+  void AddStat(const std::string &name, double value) {
+    stats_.emplace_back(name, value);
+  }
+  const std::vector<std::pair<std::string, double>> &stats() const {
+    return stats_;
+  }
+
+  // Returns the latency histogram for an operation type, e.g. "Add".
+  // Latencies are recorded in CycleClock ticks. The pointer stays valid for
+  // the lifetime of the timer. Returns nullptr once latencies are disabled.
+  LatencyHistogram *OperationLatency(const std::string &operation);
+
+  // Stops recording operation latencies, so that timed runs don't pay for
+  // the clock reads. Call before the first OperationLatency.
+  void DisableOperationLatencies() { latencies_enabled_ = false; }
+
+  // Latency histograms for all operation types, by name.
+  const std::map<std::string, LatencyHistogram> &operation_latencies() const {
+    return operation_latencies_;
+  }
+
+  // Total number of operations recorded in the latency histograms.
+  long NumOperations() const;
+
+  // Hardware counts accumulated between Start and Stop.
+  const PerfCounterValues &counter_values() const {
+    return counters_.values();
+  }
+
 private:
   std::chrono::steady_clock clock_;
   std::chrono::time_point<std::chrono::steady_clock> start_time_;
   std::chrono::time_point<std::chrono::steady_clock> stop_time_;
 
   bool started_;
-  long total_ms_;
+  bool latencies_enabled_;
+  long total_us_;
   std::string report_;
+  std::vector<std::pair<std::string, double>> stats_;
+  std::map<std::string, LatencyHistogram> operation_latencies_;
+  PerfCounterGroup counters_;
 };
 
+// Records the latency of the enclosing scope into a histogram. Does nothing
+// if the histogram is null.
+class ScopedLatency {
+public:
+  explicit ScopedLatency(LatencyHistogram *histogram)
+      : histogram_(histogram),
+        start_(histogram != nullptr ? CycleClock::Now() : 0) {}
+  ~ScopedLatency() {
+    if (histogram_ != nullptr) {
+      histogram_->Record(CycleClock::Now() - start_);
+    }
+  }
+
+private:
+  LatencyHistogram *histogram_;
+  int64_t start_;
+};
+
+// Prints the p50/p99/p999/max latencies of each operation type, in
+// nanoseconds.
+void PrintOperationLatencies(
+    const std::map<std::string, LatencyHistogram> &operation_latencies,
+    std::ostream &out);
+
 // A Performance test.
 template <typename T> class PerfTestRunner {
 public:
+  // Name of the test, used to identify its results.
+  virtual std::string Name() const = 0;
+
   virtual void Run(PerfTimer *timer, const T &params) const = 0;
 };
 
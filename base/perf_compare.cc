@@ -0,0 +1,122 @@
+// Compares two benchmark result files, written as CSV by PerfReport, and
+// flags regressions.
+//
+// Usage:
+//   perf_compare --baseline=old.csv --candidate=new.csv [--threshold=0.05]
+//
+// A benchmark regresses if its median run time grew by more than the
+// threshold, and the Mann-Whitney U test says the difference is significant.
+// Exits with status 1 if any benchmark regressed. The test needs enough runs
+// on each side to reach the significance level: at least 4 each for 0.05.
+// Benchmarks with fewer are reported as "too few runs", with a warning.
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/check.h"
+#include "absl/log/flags.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+
+#include "base/perf_report.h"
+#include "base/statistics.h"
+
+ABSL_FLAG(std::string, baseline, "", "CSV results of the baseline version");
+ABSL_FLAG(std::string, candidate, "", "CSV results of the candidate version");
+ABSL_FLAG(double, threshold, 0.05,
+          "relative change in median run time that counts as a regression");
+ABSL_FLAG(double, alpha, 0.05, "significance level of the Mann-Whitney test");
+
+namespace {
+
+// Reads the results in a CSV file.
+std::vector<PerfResult> ReadResults(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    LOG(FATAL) << "Cannot open " << path;
+  }
+  std::vector<PerfResult> results;
+  if (!PerfReport::ReadCsv(in, &results)) {
+    LOG(FATAL) << "Malformed results file " << path;
+  }
+  return results;
+}
+
+// Compares the results, and returns the number of regressions.
+int CompareResults(const std::vector<PerfResult> &baseline,
+                   const std::vector<PerfResult> &candidate, double threshold,
+                   double alpha) {
+  std::map<std::string, const PerfResult *> baseline_by_key;
+  for (const auto &result : baseline) {
+    baseline_by_key[result.Key()] = &result;
+  }
+
+  int num_regressions = 0;
+  int num_too_few_runs = 0;
+  std::printf("%-60s %12s %12s %8s %8s  %s\n", "benchmark", "base (us)",
+              "new (us)", "change", "p-value", "verdict");
+  for (const auto &result : candidate) {
+    auto it = baseline_by_key.find(result.Key());
+    if (it == baseline_by_key.end()) {
+      std::printf("%-60s %12s %12.0f %8s %8s  new\n", result.Key().c_str(), "-",
+                  Median(result.run_times_us), "-", "-");
+      continue;
+    }
+
+    double base_median = Median(it->second->run_times_us);
+    double new_median = Median(result.run_times_us);
+    double change = base_median > 0 ? new_median / base_median - 1 : 0;
+    double p_value =
+        MannWhitneyPValue(it->second->run_times_us, result.run_times_us);
+
+    const char *verdict = "same";
+    if (MannWhitneyMinPValue(it->second->run_times_us.size(),
+                             result.run_times_us.size()) >= alpha) {
+      verdict = "too few runs";
+      num_too_few_runs++;
+    } else if (p_value < alpha && change > threshold) {
+      verdict = "REGRESSION";
+      num_regressions++;
+    } else if (p_value < alpha && change < -threshold) {
+      verdict = "improvement";
+    }
+    std::printf("%-60s %12.0f %12.0f %+7.1f%% %8.4f  %s\n",
+                result.Key().c_str(), base_median, new_median, change * 100,
+                p_value, verdict);
+  }
+  if (num_too_few_runs > 0) {
+    LOG(WARNING) << num_too_few_runs
+                 << " benchmark(s) have too few runs for the Mann-Whitney "
+                    "test to reach --alpha="
+                 << alpha << ", so no regression can be flagged for them. "
+                 << "Rerun with more runs on each side.";
+  }
+  return num_regressions;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+
+  std::string baseline_path = absl::GetFlag(FLAGS_baseline);
+  std::string candidate_path = absl::GetFlag(FLAGS_candidate);
+  if (baseline_path.empty() || candidate_path.empty()) {
+    LOG(FATAL) << "Both --baseline and --candidate are required";
+  }
+
+  int num_regressions = CompareResults(
+      ReadResults(baseline_path), ReadResults(candidate_path),
+      absl::GetFlag(FLAGS_threshold), absl::GetFlag(FLAGS_alpha));
+  if (num_regressions > 0) {
+    std::cout << num_regressions << " regression(s) found." << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,201 @@
+#include "base/perf_counters.h"
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *PerfCounterName(PerfCounterType type) {
+  switch (type) {
+  case kCycles:
+    return "cycles";
+  case kInstructions:
+    return "instructions";
+  case kL1dMisses:
+    return "L1D misses";
+  case kLlcMisses:
+    return "LLC misses";
+  case kBranchMisses:
+    return "branch misses";
+  case kDtlbMisses:
+    return "dTLB misses";
+  default:
+    return "unknown";
+  }
+}
+
+PerfCounterValues::PerfCounterValues() {
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    values_[i] = -1;
+  }
+}
+
+void PerfCounterValues::Add(PerfCounterType type, int64_t count) {
+  if (values_[type] < 0) {
+    values_[type] = 0;
+  }
+  values_[type] += count;
+}
+
+void PerfCounterValues::Add(const PerfCounterValues &other) {
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    if (other.values_[i] >= 0) {
+      Add(static_cast<PerfCounterType>(i), other.values_[i]);
+    }
+  }
+}
+
+bool PerfCounterValues::any() const {
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    if (values_[i] >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PerfCounterValues::PrintPerOperation(long num_operations,
+                                          std::ostream &out) const {
+  if (!any() || num_operations <= 0) {
+    out << "  Counters: unavailable" << std::endl;
+    return;
+  }
+
+  out << "  Counters per op:";
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    if (values_[i] >= 0) {
+      out << " " << PerfCounterName(static_cast<PerfCounterType>(i)) << " "
+          << static_cast<double>(values_[i]) / num_operations << ",";
+    }
+  }
+  if (has(kCycles) && has(kInstructions) && get(kCycles) > 0) {
+    out << " IPC " << static_cast<double>(get(kInstructions)) / get(kCycles);
+  }
+  out << std::endl;
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Fills in the perf_event_attr type and config for a counter type.
+void SetEventConfig(PerfCounterType type, perf_event_attr *attr) {
+  const auto kCacheMiss = [](uint64_t cache, uint64_t op) {
+    return cache | (op << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  };
+
+  switch (type) {
+  case kCycles:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case kInstructions:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case kL1dMisses:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config =
+        kCacheMiss(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ);
+    break;
+  case kLlcMisses:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  case kBranchMisses:
+    attr->type = PERF_TYPE_HARDWARE;
+    attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  case kDtlbMisses:
+    attr->type = PERF_TYPE_HW_CACHE;
+    attr->config =
+        kCacheMiss(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ);
+    break;
+  default:
+    break;
+  }
+}
+
+// Opens a counter for the calling thread on any cpu. Returns -1 on failure.
+//
+// Each counter is opened on its own rather than as a perf group: six events
+// may not fit on the PMU at once, and a group that does not fit is never
+// scheduled. Independent events are multiplexed and scaled instead.
+int OpenEvent(PerfCounterType type) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  SetEventConfig(type, &attr);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+} // namespace
+
+PerfCounterGroup::PerfCounterGroup() {
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    auto type = static_cast<PerfCounterType>(i);
+    int fd = OpenEvent(type);
+    if (fd >= 0) {
+      events_.push_back(Event{type, fd});
+    }
+  }
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+  for (const auto &event : events_) {
+    close(event.fd);
+  }
+}
+
+bool PerfCounterGroup::Read_(std::vector<double> *counts) const {
+  counts->resize(events_.size());
+  for (int i = 0; i < events_.size(); ++i) {
+    // Layout: value, time_enabled, time_running.
+    uint64_t buffer[3];
+    if (read(events_[i].fd, buffer, sizeof(buffer)) != sizeof(buffer)) {
+      return false;
+    }
+
+    // Scale up if the counter was multiplexed off the PMU part of the time.
+    double scale = buffer[2] > 0 ? static_cast<double>(buffer[1]) / buffer[2]
+                                 : 0;
+    (*counts)[i] = buffer[0] * scale;
+  }
+  return true;
+}
+
+void PerfCounterGroup::Start() {
+  if (available() && !Read_(&start_counts_)) {
+    start_counts_.clear();
+  }
+}
+
+void PerfCounterGroup::Stop() {
+  std::vector<double> stop_counts;
+  if (!available() || start_counts_.empty() || !Read_(&stop_counts)) {
+    return;
+  }
+  for (int i = 0; i < events_.size(); ++i) {
+    values_.Add(events_[i].type,
+                static_cast<int64_t>(stop_counts[i] - start_counts_[i]));
+  }
+}
+
+#else // !__linux__
+
+PerfCounterGroup::PerfCounterGroup() {}
+PerfCounterGroup::~PerfCounterGroup() {}
+bool PerfCounterGroup::Read_(std::vector<double> *counts) const {
+  return false;
+}
+void PerfCounterGroup::Start() {}
+void PerfCounterGroup::Stop() {}
+
+#endif // __linux__
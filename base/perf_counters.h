@@ -0,0 +1,93 @@
+// Hardware performance counters, read with Linux perf_event_open.
+
+#ifndef BASE_PERF_COUNTERS_H_
+#define BASE_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// The hardware events that are counted.
+enum PerfCounterType {
+  kCycles = 0,
+  kInstructions,
+  kL1dMisses,
+  kLlcMisses,
+  kBranchMisses,
+  kDtlbMisses,
+  kNumPerfCounters,
+};
+
+// Returns a printable name for the counter type.
+const char *PerfCounterName(PerfCounterType type);
+
+// Accumulated counter values, indexed by PerfCounterType.
+class PerfCounterValues {
+public:
+  PerfCounterValues();
+
+  // Returns true if the counter was available.
+  bool has(PerfCounterType type) const { return values_[type] >= 0; }
+
+  // Returns the count, or -1 if the counter was not available.
+  int64_t get(PerfCounterType type) const { return values_[type]; }
+
+  // Adds `count` to the counter, marking it available.
+  void Add(PerfCounterType type, int64_t count);
+
+  // Adds all available counters in `other`.
+  void Add(const PerfCounterValues &other);
+
+  // Returns true if any counter is available.
+  bool any() const;
+
+  // Prints the counts divided by `num_operations`.
+  void PrintPerOperation(long num_operations, std::ostream &out) const;
+
+private:
+  int64_t values_[kNumPerfCounters];
+};
+
+// A group of hardware counters for the calling thread.
+//
+// Counters that cannot be opened (no PMU access in containers, a restrictive
+// perf_event_paranoid setting, events the CPU lacks, or a non-Linux build)
+// are skipped; if none can be opened, Start and Stop do nothing and the
+// accumulated values report every counter as unavailable.
+class PerfCounterGroup {
+public:
+  PerfCounterGroup();
+  ~PerfCounterGroup();
+
+  PerfCounterGroup(const PerfCounterGroup &) = delete;
+  PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+  // Returns true if at least one counter is being counted.
+  bool available() const { return !events_.empty(); }
+
+  // Starts counting.
+  void Start();
+
+  // Stops counting, and adds the counts since Start to values().
+  void Stop();
+
+  // The counts accumulated across all the Start/Stop intervals.
+  const PerfCounterValues &values() const { return values_; }
+
+private:
+  // A counter that was opened.
+  struct Event {
+    PerfCounterType type;
+    int fd;
+  };
+
+  // Reads the current (multiplexing-scaled) counts into `counts`, in the
+  // order of `events_`. Returns false if the read failed.
+  bool Read_(std::vector<double> *counts) const;
+
+  std::vector<Event> events_;
+  std::vector<double> start_counts_;
+  PerfCounterValues values_;
+};
+
+#endif /* BASE_PERF_COUNTERS_H_ */
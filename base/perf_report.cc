@@ -0,0 +1,272 @@
+#include "base/perf_report.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "base/cycle_clock.h"
+#include "base/statistics.h"
+
+namespace {
+
+// Latency percentiles reported for each operation type.
+const std::pair<const char *, double> kPercentiles[] = {
+    {"p50", 50}, {"p99", 99}, {"p999", 99.9}};
+
+// Writes a JSON string literal.
+void WriteJsonString(const std::string &value, std::ostream &out) {
+  out << '"';
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    default:
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+// Writes a CSV field, quoting it if necessary.
+void WriteCsvField(const std::string &value, std::ostream &out) {
+  if (value.find_first_of(",\"\n") == std::string::npos) {
+    out << value;
+    return;
+  }
+  out << '"';
+  for (char c : value) {
+    if (c == '"') {
+      out << '"';
+    }
+    out << c;
+  }
+  out << '"';
+}
+
+// Splits a CSV line into fields. Returns false if a quote is unterminated.
+bool SplitCsvLine(const std::string &line, std::vector<std::string> *fields) {
+  fields->clear();
+  std::string field;
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        field += '"';
+        ++i;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        field += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields->push_back(std::move(field));
+      field.clear();
+    } else {
+      field += c;
+    }
+  }
+  fields->push_back(std::move(field));
+  return !quoted;
+}
+
+// Parses "name=value;name=value" parameters.
+std::vector<std::pair<std::string, std::string>>
+ParseParams(const std::string &params) {
+  std::vector<std::pair<std::string, std::string>> result;
+  std::stringstream in(params);
+  std::string param;
+  while (std::getline(in, param, ';')) {
+    size_t equals = param.find('=');
+    if (equals != std::string::npos) {
+      result.emplace_back(param.substr(0, equals), param.substr(equals + 1));
+    }
+  }
+  return result;
+}
+
+// Calls `emit(metric, value)` for each summary metric of a result, other than
+// the individual run times.
+template <typename Fn> void ForEachMetric(const PerfResult &result, Fn emit) {
+  emit("runs", result.run_times_us.size());
+  emit("mean_us", Mean(result.run_times_us));
+  emit("stddev_us", StdDev(result.run_times_us));
+
+  const double nanos_per_tick = CycleClock::NanosPerTick();
+  for (const auto &entry : result.operation_latencies) {
+    const LatencyHistogram &latency = entry.second;
+    emit(entry.first + ".count", latency.count());
+    for (const auto &percentile : kPercentiles) {
+      emit(entry.first + "." + percentile.first + "_ns",
+           latency.Percentile(percentile.second) * nanos_per_tick);
+    }
+    emit(entry.first + ".max_ns", latency.max() * nanos_per_tick);
+  }
+
+  if (result.num_operations > 0) {
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      auto type = static_cast<PerfCounterType>(i);
+      if (result.counter_values.has(type)) {
+        emit(std::string(PerfCounterName(type)) + "_per_op",
+             static_cast<double>(result.counter_values.get(type)) /
+                 result.num_operations);
+      }
+    }
+  }
+
+  for (const auto &stat : result.stats) {
+    emit(stat.first, stat.second);
+  }
+}
+
+} // namespace
+
+std::string PerfResult::ParamsString() const {
+  std::string result;
+  for (const auto &param : params) {
+    if (!result.empty()) {
+      result += ';';
+    }
+    result += param.first + "=" + param.second;
+  }
+  return result;
+}
+
+std::string PerfResult::Key() const {
+  return binary + "/" + benchmark + "/" + implementation + "/" +
+         ParamsString();
+}
+
+void PerfReport::WriteJson(std::ostream &out) const {
+  out << "{\"results\": [";
+  for (int i = 0; i < results_.size(); ++i) {
+    const PerfResult &result = results_[i];
+    out << (i > 0 ? "," : "") << "\n  {";
+
+    out << "\"binary\": ";
+    WriteJsonString(result.binary, out);
+    out << ", \"benchmark\": ";
+    WriteJsonString(result.benchmark, out);
+    out << ", \"implementation\": ";
+    WriteJsonString(result.implementation, out);
+
+    out << ", \"params\": {";
+    for (int j = 0; j < result.params.size(); ++j) {
+      out << (j > 0 ? ", " : "");
+      WriteJsonString(result.params[j].first, out);
+      out << ": ";
+      WriteJsonString(result.params[j].second, out);
+    }
+    out << "}";
+
+    out << ", \"run_times_us\": [";
+    for (int j = 0; j < result.run_times_us.size(); ++j) {
+      out << (j > 0 ? ", " : "") << result.run_times_us[j];
+    }
+    out << "]";
+
+    out << ", \"metrics\": {";
+    bool first = true;
+    ForEachMetric(result, [&out, &first](const std::string &metric,
+                                         double value) {
+      out << (first ? "" : ", ");
+      WriteJsonString(metric, out);
+      out << ": " << value;
+      first = false;
+    });
+    out << "}}";
+  }
+  out << "\n]}" << std::endl;
+}
+
+void PerfReport::WriteCsv(std::ostream &out) const {
+  out << "binary,benchmark,implementation,params,metric,value" << std::endl;
+  for (const PerfResult &result : results_) {
+    auto write_row = [&out, &result](const std::string &metric,
+                                     double value) {
+      WriteCsvField(result.binary, out);
+      out << ',';
+      WriteCsvField(result.benchmark, out);
+      out << ',';
+      WriteCsvField(result.implementation, out);
+      out << ',';
+      WriteCsvField(result.ParamsString(), out);
+      out << ',';
+      WriteCsvField(metric, out);
+      out << ',' << value << std::endl;
+    };
+    for (double run_time : result.run_times_us) {
+      write_row("run_time_us", run_time);
+    }
+    ForEachMetric(result, write_row);
+  }
+}
+
+bool PerfReport::WriteFiles(const std::string &json_path,
+                            const std::string &csv_path) const {
+  if (!json_path.empty()) {
+    std::ofstream out(json_path);
+    WriteJson(out);
+    if (!out) {
+      return false;
+    }
+  }
+  if (!csv_path.empty()) {
+    std::ofstream out(csv_path);
+    WriteCsv(out);
+    if (!out) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PerfReport::ReadCsv(std::istream &in, std::vector<PerfResult> *results) {
+  std::map<std::string, int> key_to_index;
+  std::vector<std::string> fields;
+  std::string line;
+
+  // Skip the header.
+  if (!std::getline(in, line)) {
+    return false;
+  }
+
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    if (!SplitCsvLine(line, &fields) || fields.size() != 6) {
+      return false;
+    }
+    if (fields[4] != "run_time_us") {
+      continue;
+    }
+
+    PerfResult result;
+    result.binary = fields[0];
+    result.benchmark = fields[1];
+    result.implementation = fields[2];
+    result.params = ParseParams(fields[3]);
+
+    auto it = key_to_index.emplace(result.Key(), results->size());
+    if (it.second) {
+      results->push_back(std::move(result));
+    }
+    char *end;
+    double run_time = std::strtod(fields[5].c_str(), &end);
+    if (end == fields[5].c_str()) {
+      return false;
+    }
+    (*results)[it.first->second].run_times_us.push_back(run_time);
+  }
+  return true;
+}
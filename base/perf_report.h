@@ -0,0 +1,87 @@
+// Machine-readable benchmark results.
+
+#ifndef BASE_PERF_REPORT_H_
+#define BASE_PERF_REPORT_H_
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/histogram.h"
+#include "base/perf_counters.h"
+
+// The result of running one benchmark several times.
+struct PerfResult {
+  PerfResult() : num_operations(0) {}
+
+  // Name of the benchmark binary, e.g. "heap_perf_test".
+  std::string binary;
+
+  // Name of the benchmark, e.g. "PopMinimum".
+  std::string benchmark;
+
+  // Name of the implementation under test, e.g. "Pairing Heap".
+  std::string implementation;
+
+  // Parameters of the benchmark, as (name, value) pairs.
+  std::vector<std::pair<std::string, std::string>> params;
+
+  // Wall time of each run, in microseconds.
+  std::vector<double> run_times_us;
+
+  // Latencies of each operation type, in CycleClock ticks.
+  std::map<std::string, LatencyHistogram> operation_latencies;
+
+  // Number of operations across all runs.
+  long num_operations;
+
+  // Hardware counts across all runs.
+  PerfCounterValues counter_values;
+
+  // Other statistics, as (name, value) pairs.
+  std::vector<std::pair<std::string, double>> stats;
+
+  // Identifies the benchmark across result files:
+  // "binary/benchmark/implementation/params".
+  std::string Key() const;
+
+  // Parameters formatted as "name=value;name=value".
+  std::string ParamsString() const;
+};
+
+// Collects benchmark results and writes them as JSON or CSV.
+//
+// The CSV output is in long form, with one metric per row:
+//   binary,benchmark,implementation,params,metric,value
+// where each run contributes a "run_time_us" row. It loads directly into
+// plotting tools, and is the input format of perf_compare.
+class PerfReport {
+public:
+  // Adds a result.
+  void Add(PerfResult result) { results_.push_back(std::move(result)); }
+
+  const std::vector<PerfResult> &results() const { return results_; }
+
+  // Writes all the results as a JSON document.
+  void WriteJson(std::ostream &out) const;
+
+  // Writes all the results as CSV.
+  void WriteCsv(std::ostream &out) const;
+
+  // Writes JSON and CSV to the given paths, skipping empty paths. Returns
+  // false if a file could not be written.
+  bool WriteFiles(const std::string &json_path,
+                  const std::string &csv_path) const;
+
+  // Reads the run times from CSV written by WriteCsv. Only the identifying
+  // fields and `run_times_us` of each result are filled in. Returns false
+  // if the input is malformed.
+  static bool ReadCsv(std::istream &in, std::vector<PerfResult> *results);
+
+private:
+  std::vector<PerfResult> results_;
+};
+
+#endif /* BASE_PERF_REPORT_H_ */
@@ -0,0 +1,175 @@
+#include "base/statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Largest sample size for which the exact U distribution is used.
+const int kMaxExactSampleSize = 20;
+
+// Returns P(U <= u) for sample sizes n1, n2 under the null hypothesis, by
+// counting the rank arrangements that yield each value of U.
+double ExactUCdf(int n1, int n2, double u) {
+  // counts[i][j][k] is the number of arrangements of i + j items with U = k;
+  // only the last two layers of i are kept.
+  const int max_u = n1 * n2;
+  std::vector<std::vector<double>> prev(n2 + 1,
+                                        std::vector<double>(max_u + 1, 0));
+  std::vector<std::vector<double>> curr = prev;
+  for (int j = 0; j <= n2; ++j) {
+    prev[j][0] = 1;
+  }
+  for (int i = 1; i <= n1; ++i) {
+    for (int j = 0; j <= n2; ++j) {
+      std::fill(curr[j].begin(), curr[j].end(), 0);
+      for (int k = 0; k <= max_u; ++k) {
+        // The largest item is either from the first sample (adding j to U)
+        // or from the second.
+        double count = k >= j ? prev[j][k - j] : 0;
+        if (j > 0) {
+          count += curr[j - 1][k];
+        }
+        curr[j][k] = count;
+      }
+    }
+    std::swap(prev, curr);
+  }
+
+  double total = 0;
+  double below = 0;
+  for (int k = 0; k <= max_u; ++k) {
+    total += prev[n2][k];
+    if (k <= u) {
+      below += prev[n2][k];
+    }
+  }
+  return below / total;
+}
+
+// Standard normal survival function.
+double NormalSf(double z) { return 0.5 * std::erfc(z / std::sqrt(2.0)); }
+
+} // namespace
+
+double Mean(const std::vector<double> &samples) {
+  if (samples.empty()) {
+    return 0;
+  }
+  double sum = 0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  return sum / samples.size();
+}
+
+double StdDev(const std::vector<double> &samples) {
+  if (samples.size() < 2) {
+    return 0;
+  }
+  double mean = Mean(samples);
+  double sum_squares = 0;
+  for (double sample : samples) {
+    sum_squares += (sample - mean) * (sample - mean);
+  }
+  return std::sqrt(sum_squares / (samples.size() - 1));
+}
+
+double RelativeStandardError(const std::vector<double> &samples) {
+  double mean = Mean(samples);
+  if (samples.size() < 2 || mean == 0) {
+    return 0;
+  }
+  return StdDev(samples) / std::sqrt(samples.size()) / std::abs(mean);
+}
+
+bool Converged(const std::vector<double> &samples, double elapsed_seconds,
+               const ConvergenceCriteria &criteria) {
+  const int num_runs = static_cast<int>(samples.size());
+  if (num_runs < criteria.min_runs) {
+    return false;
+  }
+  return num_runs >= criteria.max_runs ||
+         elapsed_seconds >= criteria.max_seconds ||
+         RelativeStandardError(samples) <= criteria.max_relative_error;
+}
+
+double Median(std::vector<double> samples) {
+  if (samples.empty()) {
+    return 0;
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t mid = samples.size() / 2;
+  if (samples.size() % 2 == 1) {
+    return samples[mid];
+  }
+  return (samples[mid - 1] + samples[mid]) / 2;
+}
+
+double MannWhitneyPValue(const std::vector<double> &a,
+                         const std::vector<double> &b) {
+  const int n1 = static_cast<int>(a.size());
+  const int n2 = static_cast<int>(b.size());
+  if (n1 == 0 || n2 == 0) {
+    return 1;
+  }
+
+  // Rank all the samples together, averaging the ranks of ties.
+  std::vector<std::pair<double, int>> all;
+  for (double sample : a) {
+    all.emplace_back(sample, 0);
+  }
+  for (double sample : b) {
+    all.emplace_back(sample, 1);
+  }
+  std::sort(all.begin(), all.end());
+
+  const int n = n1 + n2;
+  double rank_sum_a = 0;
+  double tie_correction = 0;
+  for (int i = 0; i < n;) {
+    int j = i;
+    while (j < n && all[j].first == all[i].first) {
+      j++;
+    }
+    double rank = (i + 1 + j) / 2.0;
+    for (int k = i; k < j; ++k) {
+      if (all[k].second == 0) {
+        rank_sum_a += rank;
+      }
+    }
+    double ties = j - i;
+    tie_correction += ties * ties * ties - ties;
+    i = j;
+  }
+
+  double u = rank_sum_a - n1 * (n1 + 1) / 2.0;
+  double u_min = std::min(u, n1 * static_cast<double>(n2) - u);
+
+  if (tie_correction == 0 && n1 <= kMaxExactSampleSize &&
+      n2 <= kMaxExactSampleSize) {
+    return std::min(1.0, 2 * ExactUCdf(n1, n2, u_min));
+  }
+
+  double mean_u = n1 * static_cast<double>(n2) / 2;
+  double variance_u = n1 * static_cast<double>(n2) / 12 *
+                      ((n + 1) - tie_correction / (n * (n - 1.0)));
+  if (variance_u <= 0) {
+    return 1;
+  }
+  double z = (mean_u - u_min - 0.5) / std::sqrt(variance_u);
+  return std::min(1.0, 2 * NormalSf(std::max(0.0, z)));
+}
+
+double MannWhitneyMinPValue(int n1, int n2) {
+  if (n1 == 0 || n2 == 0) {
+    return 1;
+  }
+  // C(n1 + n2, n1), computed as a product of ratios.
+  double combinations = 1;
+  for (int i = 1; i <= n1; ++i) {
+    combinations = combinations * (n2 + i) / i;
+  }
+  return std::min(1.0, 2 / combinations);
+}
@@ -0,0 +1,54 @@
+// Statistics for comparing benchmark samples.
+
+#ifndef BASE_STATISTICS_H_
+#define BASE_STATISTICS_H_
+
+#include <vector>
+
+// Mean of the samples. Returns 0 if empty.
+double Mean(const std::vector<double> &samples);
+
+// Sample standard deviation. Returns 0 if there are fewer than 2 samples.
+double StdDev(const std::vector<double> &samples);
+
+// Median of the samples. Returns 0 if empty.
+double Median(std::vector<double> samples);
+
+// Standard error of the mean, relative to the mean. Returns 0 if there are
+// fewer than 2 samples or the mean is 0.
+double RelativeStandardError(const std::vector<double> &samples);
+
+// When to stop repeating a measurement.
+struct ConvergenceCriteria {
+  // Always take at least `min_runs` and at most `max_runs` samples.
+  int min_runs = 5;
+  int max_runs = 30;
+
+  // Stop once the relative standard error is below this.
+  double max_relative_error = 0.02;
+
+  // Stop once the samples took this long in total, even if not converged.
+  double max_seconds = 10;
+};
+
+// Returns true if no more samples are needed: at least `min_runs` samples
+// whose relative standard error is small enough, or the run or time limit is
+// reached. `elapsed_seconds` is the total time taken by the samples so far.
+bool Converged(const std::vector<double> &samples, double elapsed_seconds,
+               const ConvergenceCriteria &criteria);
+
+// Two-sided p-value of the Mann-Whitney U test, i.e. the probability that
+// samples `a` and `b` come from distributions with the same median.
+//
+// Uses the exact distribution of U for small samples without ties, and the
+// normal approximation with tie and continuity corrections otherwise.
+double MannWhitneyPValue(const std::vector<double> &a,
+                         const std::vector<double> &b);
+
+// The smallest two-sided p-value that MannWhitneyPValue can return for
+// samples of sizes `n1` and `n2`: 2 / C(n1 + n2, n1), when one sample is
+// entirely below the other. If it is not below the significance level, the
+// test cannot find any difference significant, e.g. with 3 samples each.
+double MannWhitneyMinPValue(int n1, int n2);
+
+#endif /* BASE_STATISTICS_H_ */
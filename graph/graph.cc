@@ -2,6 +2,8 @@
 
 #include "absl/log/check.h"
 
+#include "base/memory.h"
+
 namespace {
 
 // Generates sequential int ids starting from 0.
@@ -76,6 +78,15 @@ void Graph::Validate() {
   }
 }
 
+long Graph::MemoryUsage() const {
+  long bytes = ContainerMemoryUsage(vertices_);
+  for (const auto &vertex : vertices_) {
+    bytes += AllocationSize(sizeof(std::vector<Edge>)) +
+             ContainerMemoryUsage(vertex.edges());
+  }
+  return bytes;
+}
+
 std::unique_ptr<GraphBuilder> GraphBuilder::Builder(const std::string &name) {
   return std::make_unique<GraphBuilderImpl>(name);
 }
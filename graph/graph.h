@@ -80,6 +80,10 @@ public:
   // Check the invariants.
   void Validate();
 
+  // Returns the approximate bytes allocated by the graph: the vertices and
+  // each vertex's edge list.
+  long MemoryUsage() const;
+
 private:
   std::vector<Vertex> vertices_;
   int num_edges_;
@@ -0,0 +1,134 @@
+#include "graph/graph_generators.h"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "absl/log/log.h"
+
+namespace {
+
+std::unique_ptr<WeightedGraph<int>>
+BuildWeightedGraph(std::unique_ptr<GraphBuilder> builder,
+                   std::unique_ptr<Properties<int>> weights) {
+  std::unique_ptr<Graph> graph = builder->Build();
+  return std::make_unique<WeightedGraph<int>>(std::move(graph),
+                                              std::move(weights));
+}
+
+} // namespace
+
+std::unique_ptr<WeightedGraph<int>> GenerateRandomGraph(int num_vertices,
+                                                        int edges_per_vertex,
+                                                        int max_weight,
+                                                        unsigned seed) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> random_vertex(0, num_vertices - 1);
+  std::uniform_int_distribution<int> random_weight(1, max_weight);
+
+  std::unique_ptr<GraphBuilder> builder = GraphBuilder::Builder(
+      "random(" + std::to_string(num_vertices) + "x" +
+      std::to_string(edges_per_vertex) + ")");
+  auto weights = std::make_unique<Properties<int>>(0);
+
+  for (int i = 0; i < num_vertices; ++i) {
+    builder->AddVertex();
+  }
+  for (VertexId from_id = 0; from_id < num_vertices; ++from_id) {
+    for (int j = 0; j < edges_per_vertex; ++j) {
+      EdgeId edge_id = builder->AddEdge(from_id, random_vertex(random));
+      weights->Set(edge_id, random_weight(random));
+    }
+  }
+
+  return BuildWeightedGraph(std::move(builder), std::move(weights));
+}
+
+std::unique_ptr<WeightedGraph<int>>
+GenerateGridGraph(int width, int height, int max_weight, unsigned seed) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> random_weight(1, max_weight);
+
+  std::unique_ptr<GraphBuilder> builder = GraphBuilder::Builder(
+      "grid(" + std::to_string(width) + "x" + std::to_string(height) + ")");
+  auto weights = std::make_unique<Properties<int>>(0);
+
+  // Vertex (x, y) has id y * width + x.
+  for (int i = 0; i < width * height; ++i) {
+    builder->AddVertex();
+  }
+  auto add_edges = [&](VertexId a, VertexId b) {
+    weights->Set(builder->AddEdge(a, b), random_weight(random));
+    weights->Set(builder->AddEdge(b, a), random_weight(random));
+  };
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      VertexId id = y * width + x;
+      if (x + 1 < width) {
+        add_edges(id, id + 1);
+      }
+      if (y + 1 < height) {
+        add_edges(id, id + width);
+      }
+    }
+  }
+
+  return BuildWeightedGraph(std::move(builder), std::move(weights));
+}
+
+std::unique_ptr<WeightedGraph<int>> ReadDimacsGraph(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    LOG(ERROR) << "Failed to open " << path;
+    return nullptr;
+  }
+
+  std::unique_ptr<GraphBuilder> builder = GraphBuilder::Builder(path);
+  std::unique_ptr<Properties<int>> weights;
+  int num_vertices = -1;
+
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (line.empty() || line[0] == 'c') {
+      continue;
+    }
+
+    std::istringstream fields(line);
+    std::string type;
+    fields >> type;
+    if (type == "p") {
+      std::string format;
+      long num_edges;
+      if (!(fields >> format >> num_vertices >> num_edges) ||
+          num_vertices < 0 || weights != nullptr) {
+        LOG(ERROR) << path << ":" << line_number << ": bad problem line";
+        return nullptr;
+      }
+      for (int i = 0; i < num_vertices; ++i) {
+        builder->AddVertex();
+      }
+      weights = std::make_unique<Properties<int>>(0);
+    } else if (type == "a") {
+      VertexId from_id, to_id;
+      int weight;
+      if (!(fields >> from_id >> to_id >> weight) || weights == nullptr ||
+          from_id < 1 || from_id > num_vertices || to_id < 1 ||
+          to_id > num_vertices || weight < 0) {
+        LOG(ERROR) << path << ":" << line_number << ": bad arc line";
+        return nullptr;
+      }
+      weights->Set(builder->AddEdge(from_id - 1, to_id - 1), weight);
+    } else {
+      LOG(ERROR) << path << ":" << line_number << ": unknown line type";
+      return nullptr;
+    }
+  }
+
+  if (weights == nullptr) {
+    LOG(ERROR) << path << ": missing problem line";
+    return nullptr;
+  }
+  return BuildWeightedGraph(std::move(builder), std::move(weights));
+}
@@ -0,0 +1,29 @@
+#ifndef GRAPH_GRAPH_GENERATORS_H_
+#define GRAPH_GRAPH_GENERATORS_H_
+
+#include <memory>
+#include <string>
+
+#include "graph/weighted_graph.h"
+
+// Generates a graph where each vertex has `edges_per_vertex` directed edges
+// to uniformly random vertices, with weights in [1, max_weight].
+std::unique_ptr<WeightedGraph<int>> GenerateRandomGraph(int num_vertices,
+                                                        int edges_per_vertex,
+                                                        int max_weight,
+                                                        unsigned seed);
+
+// Generates a `width` x `height` grid, where each vertex has edges in both
+// directions to its horizontal and vertical neighbours, with weights in
+// [1, max_weight]. Resembles a road network: sparse, with a large diameter.
+std::unique_ptr<WeightedGraph<int>>
+GenerateGridGraph(int width, int height, int max_weight, unsigned seed);
+
+// Reads a graph in the DIMACS shortest path challenge format (".gr"), e.g.
+//   p sp <num_vertices> <num_edges>
+//   a <from> <to> <weight>
+// Vertices are numbered from 1 in the file and from 0 in the graph.
+// Returns null if the file can't be read or parsed.
+std::unique_ptr<WeightedGraph<int>> ReadDimacsGraph(const std::string &path);
+
+#endif /* GRAPH_GRAPH_GENERATORS_H_ */
@@ -1,6 +1,7 @@
 #ifndef GRAPH_PROPERTIES_H_
 #define GRAPH_PROPERTIES_H_
 
+#include "base/memory.h"
 #include "graph/graph.h"
 
 // A set of T values keyed by an int key.
@@ -28,6 +29,9 @@ public:
     return default_value_;
   }
 
+  // Returns the approximate bytes allocated for the values.
+  long MemoryUsage() const { return ContainerMemoryUsage(properties_); }
+
 private:
   std::vector<T> properties_;
   T default_value_;
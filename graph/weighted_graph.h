@@ -14,6 +14,11 @@ public:
   // Print the graph, for debugging.
   void PrintGraph(std::ostream &out) const;
 
+  // Returns the approximate bytes allocated by the graph and its weights.
+  long MemoryUsage() const {
+    return graph->MemoryUsage() + edge_weights->MemoryUsage();
+  }
+
   std::unique_ptr<Graph> graph;
 
   // Weights on the edges.
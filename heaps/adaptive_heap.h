@@ -0,0 +1,304 @@
+// Adaptive Heap.
+//
+// Picks between a Binary Heap and a Pairing Heap from the observed workload.
+
+#ifndef HEAPS_ADAPTIVE_HEAP_H_
+#define HEAPS_ADAPTIVE_HEAP_H_
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "heaps/binary_heap.h"
+#include "heaps/heap.h"
+#include "heaps/pairing_heap.h"
+
+// When an AdaptiveHeap switches implementation. The default table is the
+// output of `heap_perf_test --calibrate_adaptive_heap` on an x86-64 Linux
+// machine: there, the Pairing Heap wins up to 10000 elements even without
+// ReduceKey, and the Binary Heap wins at 100000 at every fraction. With its
+// fractions of 0 and 2, the fraction of ReduceKey never changes the choice,
+// and the heap switches on its size alone. Run the calibration on the target
+// machine to get values where the operation mix matters.
+struct AdaptiveHeapThresholds {
+  // Number of operations in each sample of the operation mix.
+  int sample_interval = 1024;
+
+  // Switch after this many samples in a row favour the other heap.
+  int samples_to_switch = 2;
+
+  // Pairs of (heap size, fraction of ReduceKey operations), sorted by size.
+  // The Pairing Heap is favoured when the fraction of ReduceKey operations
+  // in a sample is at least the fraction paired with the size closest to the
+  // heap's size, on a log scale. A fraction above 1 never favours it.
+  std::vector<std::pair<int, double>> pairing_reduce_key_fractions = {
+      {100, 0}, {1000, 0}, {10000, 0}, {100000, 2}};
+
+  // Returns true if the Pairing Heap is favoured for a heap of `size`
+  // elements, with `reduce_key_fraction` of the operations being ReduceKey.
+  bool FavourPairingHeap(int size, double reduce_key_fraction) const;
+
+  // Formats as "name=value" pairs, separated by spaces, as read by Parse().
+  std::string ToString() const;
+
+  // Parses the output of ToString(). Names that are left out keep their
+  // current values. Returns false on a malformed string.
+  bool Parse(const std::string &text);
+};
+
+inline bool
+AdaptiveHeapThresholds::FavourPairingHeap(int size,
+                                          double reduce_key_fraction) const {
+  if (pairing_reduce_key_fractions.empty()) {
+    return false;
+  }
+  // Sizes are compared by their ratio, i.e. on a log scale.
+  const double x = std::max(size, 1);
+  const auto *closest = &pairing_reduce_key_fractions.front();
+  for (const auto &entry : pairing_reduce_key_fractions) {
+    double ratio = x > entry.first ? x / entry.first : entry.first / x;
+    double closest_ratio =
+        x > closest->first ? x / closest->first : closest->first / x;
+    if (ratio < closest_ratio) {
+      closest = &entry;
+    }
+  }
+  return reduce_key_fraction >= closest->second;
+}
+
+inline std::string AdaptiveHeapThresholds::ToString() const {
+  std::stringstream out;
+  out << "sample_interval=" << sample_interval
+      << " samples_to_switch=" << samples_to_switch
+      << " pairing_reduce_key_fractions=";
+  for (int i = 0; i < pairing_reduce_key_fractions.size(); ++i) {
+    out << (i > 0 ? "," : "") << pairing_reduce_key_fractions[i].first << ":"
+        << pairing_reduce_key_fractions[i].second;
+  }
+  return out.str();
+}
+
+inline bool AdaptiveHeapThresholds::Parse(const std::string &text) {
+  std::stringstream in(text);
+  std::string pair;
+  while (in >> pair) {
+    auto equals = pair.find('=');
+    if (equals == std::string::npos) {
+      return false;
+    }
+    std::string name = pair.substr(0, equals);
+    std::stringstream value(pair.substr(equals + 1));
+    if (name == "sample_interval") {
+      value >> sample_interval;
+    } else if (name == "samples_to_switch") {
+      value >> samples_to_switch;
+    } else if (name == "pairing_reduce_key_fractions") {
+      // A comma separated list of size:fraction.
+      pairing_reduce_key_fractions.clear();
+      std::string entry;
+      while (std::getline(value, entry, ',')) {
+        std::stringstream entry_in(entry);
+        int size;
+        double fraction;
+        char colon;
+        if (!(entry_in >> size >> colon >> fraction) || colon != ':' ||
+            !(entry_in >> std::ws).eof()) {
+          return false;
+        }
+        pairing_reduce_key_fractions.emplace_back(size, fraction);
+      }
+      std::sort(pairing_reduce_key_fractions.begin(),
+                pairing_reduce_key_fractions.end());
+      continue;
+    } else {
+      return false;
+    }
+    if (value.fail() || !value.eof()) {
+      return false;
+    }
+  }
+  return sample_interval > 0 && samples_to_switch > 0;
+}
+
+// A heap that starts as a Binary Heap, and samples its own operation mix and
+// size. When the thresholds favour the Pairing Heap for a few samples in a
+// row, it rebuilds itself as a Pairing Heap, and the other way around.
+//
+// A switch moves every element, so pointers returned by LookUp are only valid
+// until the next operation. Both heaps order the keys by Compare.
+template <typename T, typename Compare = std::less<T>>
+class AdaptiveHeap : public Heap<T> {
+public:
+  explicit AdaptiveHeap(
+      const AdaptiveHeapThresholds &thresholds = AdaptiveHeapThresholds())
+      : thresholds_(thresholds), binary_heap_(new BinaryHeapType()),
+        heap_(binary_heap_.get()), num_sampled_(0), num_sampled_reduce_keys_(0),
+        num_samples_favouring_switch_(0), num_switches_(0) {}
+
+  // A factory for this heap.
+  static Factory<Heap<T>> factory(
+      const AdaptiveHeapThresholds &thresholds = AdaptiveHeapThresholds()) {
+    return Factory<Heap<T>>("Adaptive Heap", [thresholds]() {
+      return new AdaptiveHeap<T, Compare>{thresholds};
+    });
+  }
+
+  // Returns number of elements.
+  virtual int size() const override { return heap_->size(); }
+
+  // Adds an element with given key and unique id.
+  virtual void Add(T key, int id) override {
+    heap_->Add(std::move(key), id);
+    Sample_(false);
+  }
+
+  // Updates a element with a lower key.
+  virtual void ReduceKey(T new_key, int id) override {
+    heap_->ReduceKey(std::move(new_key), id);
+    Sample_(true);
+  }
+
+  // Updates a element with a higher key.
+  virtual void IncreaseKey(T new_key, int id) override {
+    heap_->IncreaseKey(std::move(new_key), id);
+    Sample_(false);
+  }
+
+  // Removes an element by its id.
+  virtual void Remove(int id) override {
+    heap_->Remove(id);
+    Sample_(false);
+  }
+
+  // Looks up a key by its id. Returns nullptr if not found.
+  virtual const T *LookUp(int id) const override { return heap_->LookUp(id); }
+
+  // Returns the minimum element.
+  virtual HeapElement<T> Min() const override { return heap_->Min(); }
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T> PopMinimum() override {
+    HeapElement<T> min = heap_->PopMinimum();
+    Sample_(false);
+    return min;
+  }
+
+  // Print for debugging.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override {
+    heap_->PrintTree(out, label);
+  }
+
+  // Validate the structure of the heap.
+  virtual void Validate() const override {
+    CHECK((binary_heap_ == nullptr) != (pairing_heap_ == nullptr));
+    heap_->Validate();
+  }
+
+  // Returns the operation counters and shape of the current heap.
+  virtual HeapStats Stats() const override { return heap_->Stats(); }
+
+  // Returns the approximate bytes allocated by the current heap.
+  virtual long MemoryUsage() const override { return heap_->MemoryUsage(); }
+
+  // Returns true if it's currently a Pairing Heap.
+  bool is_pairing_heap() const { return pairing_heap_ != nullptr; }
+
+  // Number of times the implementation was switched.
+  int num_switches() const { return num_switches_; }
+
+private:
+  using BinaryHeapType = BinaryHeap<T, false, HeapIds<>, Compare>;
+  using PairingHeapType =
+      PairingHeap<T, TwoPassPairing, false, HeapIds<>, Compare>;
+
+  // Counts an operation, and switches implementation at the end of a sample
+  // if the thresholds are crossed.
+  void Sample_(bool is_reduce_key);
+
+  // Moves all the elements to a new Pairing Heap.
+  void SwitchToPairingHeap_();
+
+  // Moves all the elements to a new Binary Heap.
+  void SwitchToBinaryHeap_();
+
+  AdaptiveHeapThresholds thresholds_;
+
+  // Exactly one of these is set.
+  std::unique_ptr<BinaryHeapType> binary_heap_;
+  std::unique_ptr<PairingHeapType> pairing_heap_;
+
+  // The heap that is set.
+  Heap<T> *heap_;
+
+  // Operations in the current sample.
+  int num_sampled_;
+  int num_sampled_reduce_keys_;
+
+  // Samples in a row that favoured the other heap.
+  int num_samples_favouring_switch_;
+
+  int num_switches_;
+};
+
+template <typename T, typename Compare>
+void AdaptiveHeap<T, Compare>::Sample_(bool is_reduce_key) {
+  num_sampled_++;
+  if (is_reduce_key) {
+    num_sampled_reduce_keys_++;
+  }
+  if (num_sampled_ < thresholds_.sample_interval) {
+    return;
+  }
+
+  const double reduce_key_fraction =
+      static_cast<double>(num_sampled_reduce_keys_) / num_sampled_;
+  num_sampled_ = 0;
+  num_sampled_reduce_keys_ = 0;
+
+  if (thresholds_.FavourPairingHeap(size(), reduce_key_fraction) ==
+      is_pairing_heap()) {
+    num_samples_favouring_switch_ = 0;
+    return;
+  }
+  if (++num_samples_favouring_switch_ < thresholds_.samples_to_switch) {
+    return;
+  }
+
+  num_samples_favouring_switch_ = 0;
+  if (is_pairing_heap()) {
+    SwitchToBinaryHeap_();
+  } else {
+    SwitchToPairingHeap_();
+  }
+}
+
+template <typename T, typename Compare>
+void AdaptiveHeap<T, Compare>::SwitchToPairingHeap_() {
+  // A Pairing Heap adds in O(1), so the elements can go in any order.
+  pairing_heap_.reset(new PairingHeapType());
+  for (auto &element : binary_heap_->TakeElements()) {
+    pairing_heap_->Add(std::move(element.first), element.second);
+  }
+  binary_heap_.reset();
+  heap_ = pairing_heap_.get();
+  num_switches_++;
+}
+
+template <typename T, typename Compare>
+void AdaptiveHeap<T, Compare>::SwitchToBinaryHeap_() {
+  // Moving the nodes out and heapifying them both take O(n).
+  binary_heap_.reset(new BinaryHeapType(pairing_heap_->TakeElements()));
+  pairing_heap_.reset();
+  heap_ = binary_heap_.get();
+  num_switches_++;
+}
+
+#endif /* HEAPS_ADAPTIVE_HEAP_H_ */
@@ -0,0 +1,406 @@
+// B-Heap.
+//
+// See Poul-Henning Kamp, "You're Doing It Wrong", ACM Queue 8(6), 2010.
+//
+// A binary heap laid out in pages, so that sifting through a heap much
+// larger than the caches touches about one page per page height levels,
+// instead of one per level.
+//
+// The array is split into pages of 2^kPageHeight slots. Slot 0 of each page
+// is unused, and slots 1 .. 2^kPageHeight - 1 hold a complete binary tree,
+// with the children of slot o at 2o and 2o + 1. The children of the leaves
+// of a page are the roots of its child pages, and the pages themselves form
+// a 2^kPageHeight-ary heap: the children of page p are pages
+// p * 2^kPageHeight + 1 to p * 2^kPageHeight + 2^kPageHeight. Elements are
+// added at the end of the array, so the heap never has holes.
+//
+// The array starts on a 4 KiB VM page, so that a page of the heap, 4 KiB by
+// default, lies in one VM page rather than straddling two.
+
+#ifndef HEAPS_B_HEAP_H_
+#define HEAPS_B_HEAP_H_
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+
+// Returns the height of the largest page of slots of `slot_bytes` bytes
+// that fits in `page_bytes`.
+constexpr int BHeapPageHeight(long page_bytes, long slot_bytes) {
+  return page_bytes < 2 * slot_bytes
+             ? 0
+             : 1 + BHeapPageHeight(page_bytes / 2, slot_bytes);
+}
+
+template <typename T,
+          int kPageHeight = BHeapPageHeight(4096, sizeof(HeapElement<T>)),
+          typename Ids = HeapIds<>,
+          typename Compare = std::less<T>>
+class BHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  static_assert(kPageHeight >= 2, "A page must hold at least 3 elements");
+
+  // A factory for this heap.
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "B-Heap (" + std::to_string(kPageSlots) + "-slot pages)",
+        []() { return new BHeap<T, kPageHeight, Ids, Compare>{}; });
+  }
+
+  // Returns number of elements.
+  virtual int size() const override {
+    return static_cast<int>(id_to_index_.size());
+  }
+
+  // Adds an element with given key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Updates a element with a lower key.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates an element with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by its id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Returns the minimum element.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Print for debugging.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override;
+
+  // Validate the structure of the heap.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return ContainerMemoryUsage(elements_) +
+           id_to_index_.MemoryUsage();
+  }
+
+private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // The alignment of `elements_`: the size of a VM page.
+  static const size_t kVmPageBytes = 4096;
+
+  // Slots per page.
+  static const int kPageSlots = 1 << kPageHeight;
+
+  // The first slot of the bottom level of a page.
+  static const int kFirstLeaf = kPageSlots / 2;
+
+  // The slot of the root.
+  static const int kRoot = 1;
+
+  // Returns the slot of the parent of slot `pos`, which must not be the
+  // root.
+  static int Parent_(int pos);
+
+  // Returns the slot of the first child of slot `pos`. The second child is
+  // in the next slot, except for the bottom level of a page, where it is in
+  // the next page. The children of the bottom level of a page are far beyond
+  // it, and may be past the int range.
+  static long FirstChild_(int pos);
+
+  // Returns the slot of the second child, given the first.
+  static long SecondChild_(long first_child) {
+    return (first_child & (kPageSlots - 1)) == kRoot
+               ? first_child + kPageSlots
+               : first_child + 1;
+  }
+
+  // Move element at `pos` upwards until its parent is smaller.
+  void SiftUp_(int pos);
+
+  // Move element at `pos` downwards until it's smaller than the children.
+  void SiftDown_(int pos);
+
+  // Set an element at particular position and update id_to_index_ map.
+  void SetElement_(int pos, HeapElement<T, Id> &&element);
+
+  // Print the heap.
+  void Print_(int pos, std::ostream &out, int level) const;
+
+  // Elements by slot. The unused slot 0 of each page holds a default
+  // element, and the last page may be partly filled.
+  std::vector<HeapElement<T, Id>,
+              AlignedAllocator<HeapElement<T, Id>, kVmPageBytes>>
+      elements_;
+
+  // A map from the element id to its slot in `elements_`.
+  typename Ids::template Index<int> id_to_index_;
+};
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+int BHeap<T, kPageHeight, Ids, Compare>::Parent_(int pos) {
+  const int slot = pos & (kPageSlots - 1);
+  if (slot != kRoot) {
+    return pos - slot + slot / 2;
+  }
+
+  // The root of a page: its parent is a leaf of the parent page.
+  const int page = pos >> kPageHeight;
+  const int parent_page = (page - 1) >> kPageHeight;
+  const int child_page_index = (page - 1) & (kPageSlots - 1);
+  return (parent_page << kPageHeight) + kFirstLeaf + child_page_index / 2;
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+long BHeap<T, kPageHeight, Ids, Compare>::FirstChild_(int pos) {
+  const int slot = pos & (kPageSlots - 1);
+  if (slot < kFirstLeaf) {
+    return pos + slot;
+  }
+
+  // A leaf of a page: its children are the roots of two child pages.
+  const long page = pos >> kPageHeight;
+  const long child_page = (page << kPageHeight) + 1 + (slot - kFirstLeaf) * 2;
+  return (child_page << kPageHeight) + kRoot;
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::Add(T key, Id id) {
+  // Skip the unused slot at the start of a page.
+  if ((elements_.size() & (kPageSlots - 1)) == 0) {
+    elements_.emplace_back();
+  }
+  int pos = static_cast<int>(elements_.size());
+  elements_.emplace_back(std::move(key), id);
+  CHECK(id_to_index_.Insert(id, pos));
+  this->AddStat_(&HeapStats::adds);
+  SiftUp_(pos);
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(elements_[index].first, new_key));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+  SiftUp_(index);
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(new_key, elements_[index].first));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(index);
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::Remove(Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the last element into the hole, and sift it up or down.
+  auto last = std::move(elements_.back());
+  const int last_index = static_cast<int>(elements_.size()) - 1;
+  elements_.pop_back();
+  if ((elements_.size() & (kPageSlots - 1)) == kRoot) {
+    elements_.pop_back();
+  }
+  if (index == last_index) {
+    return;
+  }
+  SetElement_(index, std::move(last));
+  if (index != kRoot &&
+      Less_(elements_[index].first, elements_[Parent_(index)].first)) {
+    SiftUp_(index);
+  } else {
+    SiftDown_(index);
+  }
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+const T *BHeap<T, kPageHeight, Ids, Compare>::LookUp(Id id) const {
+  const int *found = id_to_index_.Find(id);
+  if (found == nullptr) {
+    return nullptr;
+  }
+  return &elements_[*found].first;
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+BHeap<T, kPageHeight, Ids, Compare>::Min() const {
+  DCHECK(size() > 0);
+  return elements_[kRoot];
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+BHeap<T, kPageHeight, Ids, Compare>::PopMinimum() {
+  DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  id_to_index_.Erase(elements_[kRoot].second);
+  auto min = std::move(elements_[kRoot]);
+
+  // Move last element to the head of the heap and sift down.
+  auto last = std::move(elements_.back());
+  elements_.pop_back();
+  if ((elements_.size() & (kPageSlots - 1)) == kRoot) {
+    elements_.pop_back();
+  }
+  if (size() > 0) {
+    SetElement_(kRoot, std::move(last));
+    SiftDown_(kRoot);
+  }
+  return min;
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::SiftUp_(int pos) {
+  auto element = std::move(elements_[pos]);
+
+  while (pos != kRoot) {
+    // Done if parent is smaller.
+    int parent = Parent_(pos);
+    if (!Less_(element.first, elements_[parent].first)) {
+      break;
+    }
+
+    // Move the parent down.
+    SetElement_(pos, std::move(elements_[parent]));
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = parent;
+  }
+
+  // Finally place element at pos.
+  SetElement_(pos, std::move(element));
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::SiftDown_(int pos) {
+  auto element = std::move(elements_[pos]);
+  const long end = static_cast<long>(elements_.size());
+  long child;
+  while ((child = FirstChild_(pos)) < end) {
+    // If the second child is smaller, then set child to it.
+    long second_child = SecondChild_(child);
+    if (second_child < end &&
+        Less_(elements_[second_child].first, elements_[child].first)) {
+      child = second_child;
+    }
+
+    // Done if the child element is not smaller.
+    if (!Less_(elements_[child].first, element.first)) {
+      break;
+    }
+
+    // Move child element up to parent pos.
+    SetElement_(pos, std::move(elements_[child]));
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = child;
+  }
+
+  // Finally place element at pos.
+  SetElement_(pos, std::move(element));
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::SetElement_(
+    int pos, HeapElement<T, Id> &&element) {
+  id_to_index_.Set(element.second, pos);
+  elements_[pos] = std::move(element);
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+HeapStats BHeap<T, kPageHeight, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  stats.num_trees = size() > 0 ? 1 : 0;
+  if (size() > 0) {
+    // The last element is on the lowest level.
+    int pos = static_cast<int>(elements_.size()) - 1;
+    for (stats.max_height = 1; pos != kRoot; pos = Parent_(pos)) {
+      stats.max_height++;
+    }
+  }
+  return stats;
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << "Heap(" << label << "):" << std::endl;
+  if (size() > 0) {
+    Print_(kRoot, out, 1);
+  }
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::Validate() const {
+  const int end = static_cast<int>(elements_.size());
+  CHECK(end == 0 || (end & (kPageSlots - 1)) != kRoot);
+  CHECK(reinterpret_cast<uintptr_t>(elements_.data()) % kVmPageBytes == 0 ||
+        elements_.capacity() == 0);
+  int num_elements = 0;
+  for (int pos = kRoot; pos < end; ++pos) {
+    if ((pos & (kPageSlots - 1)) == 0) {
+      continue;
+    }
+    num_elements++;
+    if (pos != kRoot) {
+      const int parent = Parent_(pos);
+      CHECK(parent < pos);
+      const long first_child = FirstChild_(parent);
+      CHECK(first_child == pos || SecondChild_(first_child) == pos);
+      CHECK(!Less_(elements_[pos].first, elements_[parent].first));
+    }
+    CHECK(*id_to_index_.Find(elements_[pos].second) == pos);
+  }
+  CHECK(num_elements == size());
+}
+
+template <typename T, int kPageHeight, typename Ids, typename Compare>
+void BHeap<T, kPageHeight, Ids, Compare>::Print_(int pos, std::ostream &out,
+                                                 int level) const {
+  for (int i = 0; i < level; ++i) {
+    out << "| ";
+  }
+  const auto &element = elements_[pos];
+  out << "[" << element.first << ",id:" << element.second << "] " << std::endl;
+
+  const long end = static_cast<long>(elements_.size());
+  const long child = FirstChild_(pos);
+  if (child < end) {
+    Print_(child, out, level + 1);
+  }
+  if (SecondChild_(child) < end) {
+    Print_(SecondChild_(child), out, level + 1);
+  }
+}
+
+#endif /* HEAPS_B_HEAP_H_ */
@@ -5,42 +5,82 @@
 #ifndef HEAPS_BINARY_HEAP_H_
 #define HEAPS_BINARY_HEAP_H_
 
+#include <functional>
 #include <iostream>
-#include <unordered_map>
 #include <vector>
 
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
 
 // A Binary Heap that keeps track of the elements by their ids, allowing
 // lookup by id, and reducing the keys.
-template <typename T> class BinaryHeap : public Heap<T> {
+//
+// With kBottomUp, sifting down first moves the hole at `pos` down the path
+// of smaller children to a leaf, with one comparison per level, then sifts
+// the element up from there (Wegener, "Bottom-up heapsort", 1993). An
+// element moved from the end of the heap usually belongs near the bottom,
+// so this saves about half the comparisons, which pays off when comparing
+// is expensive.
+template <typename T, bool kBottomUp = false, typename Ids = HeapIds<>,
+          typename Compare = std::less<T>>
+class BinaryHeap : public Heap<T, typename Ids::Id> {
 public:
+  using Id = typename Ids::Id;
+
   // A factory for this heap.
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Binary Heap",
-                            []() { return new BinaryHeap<T>{}; });
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        kBottomUp ? "Binary Heap (bottom-up)" : "Binary Heap",
+        []() { return new BinaryHeap<T, kBottomUp, Ids, Compare>{}; });
   };
 
+  BinaryHeap() {}
+
+  // Builds a heap from unordered elements in O(n) time.
+  explicit BinaryHeap(std::vector<HeapElement<T, Id>> elements);
+
   // Returns number of elements.
   virtual int size() const override {
     return static_cast<int>(elements_.size());
   }
 
+  // Returns all the elements, in heap order.
+  const std::vector<HeapElement<T, Id>> &elements() const { return elements_; }
+
+  // Moves out all the elements, in heap order, and leaves the heap empty.
+  std::vector<HeapElement<T, Id>> TakeElements() {
+    // Erase each id, so that a HandleIdIndex marks its handle out of the heap.
+    for (const auto &element : elements_) {
+      id_to_index_.Erase(element.second);
+    }
+    id_to_index_ = typename Ids::template Index<int>();
+    std::vector<HeapElement<T, Id>> elements;
+    elements.swap(elements_);
+    return elements;
+  }
+
   // Adds an element with given key and unique id.
-  virtual void Add(T key, int id) override;
+  virtual void Add(T key, Id id) override;
 
   // Updates a element with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates an element with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by its id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the minimum element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out,
@@ -49,57 +89,129 @@ public:
   // Validate the structure of the heap.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return ContainerMemoryUsage(elements_) + id_to_index_.MemoryUsage();
+  }
+
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   // Move element at `pos` upwards until its parent is smaller.
   void SiftUp_(int pos);
 
   // Move element at `pos` downwards until it's smaller than the child.
   void SiftDown_(int pos);
 
+  // Same as SiftDown_, bottom-up.
+  void SiftDownBottomUp_(int pos);
+
   // Set an element at particular position and update id_to_index_ map.
-  void SetElement_(int pos, HeapElement<T> element);
+  void SetElement_(int pos, HeapElement<T, Id> element);
 
   // Print the heap.
   void Print_(int pos, std::ostream &out, int level) const;
 
-  // Vector containing {T, int id} pairs.
-  std::vector<HeapElement<T>> elements_;
+  // Vector containing {T, id} pairs.
+  std::vector<HeapElement<T, Id>> elements_;
 
-  // A map from the element int id to its index in `elements_` vector.
-  std::unordered_map<int, int> id_to_index_;
+  // A map from the element id to its index in `elements_` vector.
+  typename Ids::template Index<int> id_to_index_;
 };
 
-template <typename T> void BinaryHeap<T>::Add(T key, int id) {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+BinaryHeap<T, kBottomUp, Ids, Compare>::BinaryHeap(
+    std::vector<HeapElement<T, Id>> elements)
+    : elements_(std::move(elements)) {
+  id_to_index_.Reserve(elements_.size());
+  for (int pos = 0; pos < elements_.size(); ++pos) {
+    CHECK(id_to_index_.Insert(elements_[pos].second, pos));
+  }
+  // Sift down each parent, from the last one up to the root.
+  for (int pos = size() / 2 - 1; pos >= 0; --pos) {
+    SiftDown_(pos);
+  }
+}
+
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::Add(T key, Id id) {
   int pos = static_cast<int>(elements_.size());
-  elements_.emplace_back(HeapElement<T>{key, id});
-  CHECK(id_to_index_.emplace(id, pos).second);
+  elements_.emplace_back(std::move(key), id);
+  CHECK(id_to_index_.Insert(id, pos));
+  this->AddStat_(&HeapStats::adds);
   SiftUp_(pos);
 }
 
-template <typename T> void BinaryHeap<T>::ReduceKey(T new_key, int id) {
-  auto it = id_to_index_.find(id);
-  CHECK(it != id_to_index_.end());
-  int index = it->second;
-  CHECK(!(elements_[index].first < new_key));
-  elements_[index].first = new_key;
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  const int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(elements_[index].first, new_key));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
   SiftUp_(index);
 }
 
-template <typename T> const T *BinaryHeap<T>::LookUp(int id) const {
-  const auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  const int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(new_key, elements_[index].first));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(index);
+}
+
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::Remove(Id id) {
+  const int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the last element into the hole, and sift it up or down.
+  auto last = std::move(elements_.back());
+  elements_.pop_back();
+  if (index == size()) {
+    return;
+  }
+  SetElement_(index, std::move(last));
+  if (index > 0 &&
+      Less_(elements_[index].first, elements_[(index - 1) / 2].first)) {
+    SiftUp_(index);
+  } else {
+    SiftDown_(index);
+  }
+}
+
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+const T *BinaryHeap<T, kBottomUp, Ids, Compare>::LookUp(Id id) const {
+  const int *index = id_to_index_.Find(id);
+  if (index == nullptr) {
     return nullptr;
   }
-  return &elements_[it->second].first;
+  return &elements_[*index].first;
 }
 
-template <typename T> HeapElement<T> BinaryHeap<T>::Min() const {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+BinaryHeap<T, kBottomUp, Ids, Compare>::Min() const {
   return elements_.front();
 }
 
-template <typename T> HeapElement<T> BinaryHeap<T>::PopMinimum() {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+BinaryHeap<T, kBottomUp, Ids, Compare>::PopMinimum() {
   DCHECK(!elements_.empty());
-  id_to_index_.erase(elements_[0].second);
+  this->AddStat_(&HeapStats::pops);
+  id_to_index_.Erase(elements_[0].second);
   auto min = std::move(elements_[0]);
 
   if (elements_.size() == 1) {
@@ -114,39 +226,52 @@ template <typename T> HeapElement<T> BinaryHeap<T>::PopMinimum() {
   return std::move(min);
 }
 
-template <typename T>
-void BinaryHeap<T>::PrintTree(std::ostream &out,
-                              const std::string &label) const {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
   out << "Heap(" << label << "):" << std::endl;
   Print_(0, out, 1);
 }
 
-template <typename T> void BinaryHeap<T>::Validate() const {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::Validate() const {
   for (int pos = 1; pos < elements_.size(); ++pos) {
     int parent = (pos - 1) / 2;
-    CHECK(!(elements_[pos].first < elements_[parent].first));
+    CHECK(!Less_(elements_[pos].first, elements_[parent].first));
   }
   for (int pos = 0; pos < elements_.size(); ++pos) {
     const auto &element = elements_[pos];
-    CHECK(id_to_index_.find(element.second)->second == pos);
+    CHECK(*id_to_index_.Find(element.second) == pos);
   }
   CHECK(id_to_index_.size() == elements_.size());
 }
 
-template <typename T> void BinaryHeap<T>::SiftUp_(int pos) {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+HeapStats BinaryHeap<T, kBottomUp, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  stats.num_trees = elements_.empty() ? 0 : 1;
+  for (int n = size(); n > 0; n /= 2) {
+    stats.max_height++;
+  }
+  return stats;
+}
+
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::SiftUp_(int pos) {
   auto element = std::move(elements_[pos]);
 
   while (pos > 0) {
     int parent = (pos - 1) / 2;
-    const auto &parent_element = elements_[parent];
+    auto &parent_element = elements_[parent];
 
     // Done if parent is smaller.
-    if (!(element.first < parent_element.first)) {
+    if (!Less_(element.first, parent_element.first)) {
       break;
     }
 
     // Move the parent down.
     SetElement_(pos, std::move(parent_element));
+    this->AddStat_(&HeapStats::sift_steps);
     pos = parent;
   }
 
@@ -154,41 +279,87 @@ template <typename T> void BinaryHeap<T>::SiftUp_(int pos) {
   SetElement_(pos, std::move(element));
 }
 
-template <typename T> void BinaryHeap<T>::SiftDown_(int pos) {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::SiftDown_(int pos) {
+  if (kBottomUp) {
+    SiftDownBottomUp_(pos);
+    return;
+  }
+
   auto element = std::move(elements_[pos]);
+  const int last = size() - 1;
   int child = pos * 2 + 1;
-  while (child < elements_.size()) {
-    // If right is smaller, then set child to right.
-    if (child + 1 < elements_.size() &&
-        elements_[child + 1].first < elements_[child].first) {
-      child++;
+  while (child <= last) {
+    // If right is smaller, then set child to right. Adding the comparison,
+    // rather than branching on it, avoids mispredicting half the levels.
+    if (child < last) {
+      child += Less_(elements_[child + 1].first, elements_[child].first);
     }
 
     // Done if the child element is not smaller.
     auto &child_element = elements_[child];
-    if (!(child_element.first < element.first)) {
+    if (!Less_(child_element.first, element.first)) {
       break;
     }
 
     // Move child element up to parent pos.
     SetElement_(pos, std::move(child_element));
+    this->AddStat_(&HeapStats::sift_steps);
+
+    pos = child;
+    child = child * 2 + 1;
+  }
+
+  // Finally place element at pos.
+  SetElement_(pos, std::move(element));
+}
+
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::SiftDownBottomUp_(int pos) {
+  auto element = std::move(elements_[pos]);
+  const int top = pos;
+  const int last = size() - 1;
 
+  // Move the smaller child up into the hole, down to a leaf.
+  int child = pos * 2 + 1;
+  while (child < last) {
+    child += Less_(elements_[child + 1].first, elements_[child].first);
+    SetElement_(pos, std::move(elements_[child]));
+    this->AddStat_(&HeapStats::sift_steps);
     pos = child;
     child = child * 2 + 1;
   }
+  if (child == last) {
+    SetElement_(pos, std::move(elements_[child]));
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = child;
+  }
+
+  // Move the hole back up until the parent is not larger than the element.
+  while (pos > top) {
+    int parent = (pos - 1) / 2;
+    if (!Less_(element.first, elements_[parent].first)) {
+      break;
+    }
+    SetElement_(pos, std::move(elements_[parent]));
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = parent;
+  }
 
   // Finally place element at pos.
   SetElement_(pos, std::move(element));
 }
 
-template <typename T>
-void BinaryHeap<T>::SetElement_(int pos, HeapElement<T> element) {
-  id_to_index_[element.second] = pos;
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::SetElement_(
+    int pos, HeapElement<T, Id> element) {
+  id_to_index_.Set(element.second, pos);
   elements_[pos] = std::move(element);
 }
 
-template <typename T>
-void BinaryHeap<T>::Print_(int pos, std::ostream &out, int level) const {
+template <typename T, bool kBottomUp, typename Ids, typename Compare>
+void BinaryHeap<T, kBottomUp, Ids, Compare>::Print_(int pos, std::ostream &out,
+                                                    int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -5,6 +5,7 @@
 #ifndef HEAPS_BINOMIAL_HEAP_H_
 #define HEAPS_BINOMIAL_HEAP_H_
 
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <unordered_set>
@@ -12,43 +13,50 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
 
 // A node used in Binomial Heaps.
-template <typename T> class BinomialHeapNode {
+template <typename T, typename Id = int,
+          typename Compare = std::less<T>>
+class BinomialHeapNode {
 public:
-  BinomialHeapNode(T key, int id)
-      : key_(key), id_(id), dimension_(0), parent_(nullptr), child_(nullptr),
-        right_(nullptr) {}
+  BinomialHeapNode(T key, Id id)
+      : key_(std::move(key)), id_(id), dimension_(0), parent_(nullptr),
+        child_(nullptr), right_(nullptr) {}
 
   // Used as a sentinal node only.
   BinomialHeapNode() : right_(nullptr) {}
 
   const T &key() const { return key_; }
-  void set_key(T key) { key_ = key; }
+  void set_key(T key) { key_ = std::move(key); }
 
-  int id() const { return id_; }
-  void set_id(int id) { id_ = id; }
+  // Moves the key out of the node.
+  T take_key() { return std::move(key_); }
+
+  Id id() const { return id_; }
+  void set_id(Id id) { id_ = id; }
 
   short dimension() const { return dimension_; }
 
-  BinomialHeapNode<T> *parent() const { return parent_; }
+  BinomialHeapNode<T, Id, Compare> *parent() const { return parent_; }
 
   // Returns true if this is one of the root nodes.
   bool is_root() const { return parent_ == nullptr; }
 
   // Returns the highest dimension child (with dimension = dimension() - 1).
-  BinomialHeapNode<T> *child() const { return child_; }
+  BinomialHeapNode<T, Id, Compare> *child() const { return child_; }
   void clear_child() { child_ = nullptr; }
 
   // Returns the next sibling.
   // The sibling has a lower dimesion, except the root list which has ascending
   // dimensions.
-  BinomialHeapNode<T> *right() const { return right_; }
-  void set_right(BinomialHeapNode<T> *right) { right_ = right; }
+  BinomialHeapNode<T, Id, Compare> *right() const { return right_; }
+  void set_right(BinomialHeapNode<T, Id, Compare> *right) { right_ = right; }
 
   // Delete the entire tree rooted at this node.
-  static void DeleteTree(BinomialHeapNode<T> *node) {
+  static void DeleteTree(BinomialHeapNode<T, Id, Compare> *node) {
     if (node != nullptr) {
       DeleteTree(node->child_);
       DeleteTree(node->right_);
@@ -58,7 +66,7 @@ public:
 
   // Remove the children of this node and return them in a list in ascending
   // dimension order. Used for merging with root node list.
-  BinomialHeapNode<T> *DetachChildren();
+  BinomialHeapNode<T, Id, Compare> *DetachChildren();
 
   // Debug information about this node.
   std::string DebugString() const;
@@ -70,44 +78,49 @@ public:
   void PrintTree(std::ostream &out, int level) const;
 
   // Validate the fields.
-  void Validate(std::unordered_set<int> *seen_ids) const;
+  void Validate(std::unordered_set<Id> *seen_ids) const;
 
   // Merge two trees a and b.
-  static BinomialHeapNode<T> *MergeTrees(BinomialHeapNode<T> *a,
-                                         BinomialHeapNode<T> *b);
+  static BinomialHeapNode<T, Id, Compare> *MergeTrees(
+      BinomialHeapNode<T, Id, Compare> *a, BinomialHeapNode<T, Id, Compare> *b);
 
   // Merge two list of trees and their siblings (in ascending dimension).
-  static BinomialHeapNode<T> *MergeTreeLists(BinomialHeapNode<T> *a,
-                                             BinomialHeapNode<T> *b);
+  static BinomialHeapNode<T, Id, Compare> *MergeTreeLists(
+      BinomialHeapNode<T, Id, Compare> *a, BinomialHeapNode<T, Id, Compare> *b);
 
-  static BinomialHeapNode<T> *AddToTreeList(BinomialHeapNode<T> *tree,
-                                            BinomialHeapNode<T> *tree_list);
+    static BinomialHeapNode<T, Id, Compare> *
+  AddToTreeList(BinomialHeapNode<T, Id, Compare> *tree,
+                BinomialHeapNode<T, Id, Compare> *tree_list);
 
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   T key_;
 
-  // An int id that uniquely identifies this node.
-  int id_;
+  // An id that uniquely identifies this node.
+  Id id_;
 
   // Dimension of the tree at this node.
   short dimension_;
 
   // Points to the parent node.
-  BinomialHeapNode<T> *parent_;
+  BinomialHeapNode<T, Id, Compare> *parent_;
 
   // Points to the highest dimension child.
-  BinomialHeapNode<T> *child_;
+  BinomialHeapNode<T, Id, Compare> *child_;
 
   // Points to next sibling.
-  BinomialHeapNode<T> *right_;
+  BinomialHeapNode<T, Id, Compare> *right_;
 };
 
-template <typename T>
-BinomialHeapNode<T> *BinomialHeapNode<T>::MergeTrees(BinomialHeapNode<T> *a,
-                                                     BinomialHeapNode<T> *b) {
+template <typename T, typename Id, typename Compare>
+BinomialHeapNode<T, Id, Compare> *
+BinomialHeapNode<T, Id, Compare>::MergeTrees(
+    BinomialHeapNode<T, Id, Compare> *a, BinomialHeapNode<T, Id, Compare> *b) {
   DCHECK(a->dimension_ == b->dimension_);
 
-  if (b->key_ < a->key_) {
+  if (Less_(b->key_, a->key_)) {
     auto *temp = b;
     b = a;
     a = temp;
@@ -121,16 +134,17 @@ BinomialHeapNode<T> *BinomialHeapNode<T>::MergeTrees(BinomialHeapNode<T> *a,
   return a;
 }
 
-template <typename T>
-BinomialHeapNode<T> *
-BinomialHeapNode<T>::AddToTreeList(BinomialHeapNode<T> *tree,
-                                   BinomialHeapNode<T> *tree_list) {
+template <typename T, typename Id, typename Compare>
+BinomialHeapNode<T, Id, Compare> *
+BinomialHeapNode<T, Id, Compare>::AddToTreeList(
+    BinomialHeapNode<T, Id, Compare> *tree,
+    BinomialHeapNode<T, Id, Compare> *tree_list) {
   auto dim = tree->dimension();
 
   // Iterate through the tree list until we find the place to insert or
   // merge the `tree` node.
-  BinomialHeapNode<T> *prev_root = nullptr;
-  BinomialHeapNode<T> *next_root;
+  BinomialHeapNode<T, Id, Compare> *prev_root = nullptr;
+  BinomialHeapNode<T, Id, Compare> *next_root;
   for (auto *curr_root = tree_list; curr_root != nullptr;
        curr_root = next_root) {
     next_root = curr_root->right_;
@@ -149,7 +163,7 @@ BinomialHeapNode<T>::AddToTreeList(BinomialHeapNode<T> *tree,
 
       // Merging yields a carry tree of a higher dimension.
       // Continue to merge the tree.
-      tree = BinomialHeapNode<T>::MergeTrees(curr_root, tree);
+      tree = BinomialHeapNode<T, Id, Compare>::MergeTrees(curr_root, tree);
       dim++;
     } else {
       // Insert tree into this list.
@@ -166,15 +180,15 @@ BinomialHeapNode<T>::AddToTreeList(BinomialHeapNode<T> *tree,
   }
 }
 
-template <typename T>
-BinomialHeapNode<T> *
-BinomialHeapNode<T>::MergeTreeLists(BinomialHeapNode<T> *a,
-                                    BinomialHeapNode<T> *b) {
-  BinomialHeapNode<T> *node_a = a;
-  BinomialHeapNode<T> *node_b = b;
+template <typename T, typename Id, typename Compare>
+BinomialHeapNode<T, Id, Compare> *
+BinomialHeapNode<T, Id, Compare>::MergeTreeLists(
+    BinomialHeapNode<T, Id, Compare> *a, BinomialHeapNode<T, Id, Compare> *b) {
+  BinomialHeapNode<T, Id, Compare> *node_a = a;
+  BinomialHeapNode<T, Id, Compare> *node_b = b;
 
-  BinomialHeapNode<T> *result;
-  BinomialHeapNode<T> **merge_tail = &result;
+  BinomialHeapNode<T, Id, Compare> *result;
+  BinomialHeapNode<T, Id, Compare> **merge_tail = &result;
 
   while (true) {
     if (node_a == nullptr) {
@@ -196,8 +210,8 @@ BinomialHeapNode<T>::MergeTreeLists(BinomialHeapNode<T> *a,
 
       // Merging yields a carry tree of a higher dimension.
       // Merge the carry tree with either a or b.
-      BinomialHeapNode<T> *carry =
-          BinomialHeapNode<T>::MergeTrees(node_a, node_b);
+      BinomialHeapNode<T, Id, Compare> *carry =
+          BinomialHeapNode<T, Id, Compare>::MergeTrees(node_a, node_b);
       if (next_node_a == nullptr) {
         node_a = carry;
         node_b = next_node_b;
@@ -226,10 +240,11 @@ BinomialHeapNode<T>::MergeTreeLists(BinomialHeapNode<T> *a,
   return result;
 }
 
-template <typename T>
-BinomialHeapNode<T> *BinomialHeapNode<T>::DetachChildren() {
-  BinomialHeapNode<T> *prev_child = nullptr;
-  BinomialHeapNode<T> *child = child_;
+template <typename T, typename Id, typename Compare>
+BinomialHeapNode<T, Id, Compare> *
+BinomialHeapNode<T, Id, Compare>::DetachChildren() {
+  BinomialHeapNode<T, Id, Compare> *prev_child = nullptr;
+  BinomialHeapNode<T, Id, Compare> *child = child_;
   while (child != nullptr) {
     auto *next = child->right_;
     child->parent_ = nullptr;
@@ -240,15 +255,16 @@ BinomialHeapNode<T> *BinomialHeapNode<T>::DetachChildren() {
   return prev_child;
 }
 
-template <typename T>
-void BinomialHeapNode<T>::PrintTree(std::ostream &out,
-                                    const std::string &label) const {
+template <typename T, typename Id, typename Compare>
+void BinomialHeapNode<T, Id, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
   out << label << ":" << std::endl;
   PrintTree(out, 0);
   out << std::endl;
 }
 
-template <typename T> std::string BinomialHeapNode<T>::DebugString() const {
+template <typename T, typename Id, typename Compare>
+std::string BinomialHeapNode<T, Id, Compare>::DebugString() const {
   std::stringstream out;
   out << key_ << " [id:" << id_ << "][dim:" << dimension_ << "]";
 
@@ -268,8 +284,9 @@ template <typename T> std::string BinomialHeapNode<T>::DebugString() const {
   return out.str();
 }
 
-template <typename T>
-void BinomialHeapNode<T>::PrintTree(std::ostream &out, int level) const {
+template <typename T, typename Id, typename Compare>
+void BinomialHeapNode<T, Id, Compare>::PrintTree(std::ostream &out,
+                                                 int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -284,8 +301,9 @@ void BinomialHeapNode<T>::PrintTree(std::ostream &out, int level) const {
   }
 }
 
-template <typename T>
-void BinomialHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
+template <typename T, typename Id, typename Compare>
+void BinomialHeapNode<T, Id, Compare>::Validate(
+    std::unordered_set<Id> *seen_ids) const {
   if (seen_ids != nullptr) {
     CHECK(seen_ids->insert(id_).second);
   }
@@ -308,14 +326,17 @@ void BinomialHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
   }
 }
 
-template <typename T> class BinomialHeap : public Heap<T> {
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class BinomialHeap : public Heap<T, typename Ids::Id> {
 public:
+  using Id = typename Ids::Id;
+
   BinomialHeap() : root_(nullptr) {}
-  ~BinomialHeap() { BinomialHeapNode<T>::DeleteTree(root_); }
+  ~BinomialHeap() { BinomialHeapNode<T, Id, Compare>::DeleteTree(root_); }
 
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Binomial Heap",
-                            []() { return new BinomialHeap<T>{}; });
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Binomial Heap", []() { return new BinomialHeap<T, Ids, Compare>{}; });
   }
 
   // Returns number of elements.
@@ -324,19 +345,25 @@ public:
   }
 
   // Adds an elementn with given key and unique int key.
-  virtual void Add(T key, int id) override;
+  virtual void Add(T key, Id id) override;
 
   // Updates with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the min element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out,
@@ -345,63 +372,128 @@ public:
   // Validate the invariants.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return size() * AllocationSize(sizeof(BinomialHeapNode<T, Id, Compare>)) +
+           id_to_node_.MemoryUsage();
+  }
+
 private:
-  void SiftUp_(BinomialHeapNode<T> *node);
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Moves the element at `node` up until its parent is smaller, or to the
+  // root if `to_root`. Returns the node where the element is placed.
+  BinomialHeapNode<T, Id, Compare> *SiftUp_(
+      BinomialHeapNode<T, Id, Compare> *node, bool to_root = false);
+
+  // Moves the element at `node` down until its children are larger.
+  void SiftDown_(BinomialHeapNode<T, Id, Compare> *node);
+
+  // Removes `root`, whose previous sibling is `prev_node`, from the root list,
+  // merges its children into the root list and returns its element.
+  HeapElement<T, Id> RemoveRoot_(BinomialHeapNode<T, Id, Compare> *root,
+                                 BinomialHeapNode<T, Id, Compare> *prev_node);
+
+  // Returns the number of trees in the root list.
+  int NumRoots_() const;
 
   // Returns the minimum element, and sets the previous sibling of the min
   // element.
-  BinomialHeapNode<T> *Min_(BinomialHeapNode<T> **prev_node) const;
+  BinomialHeapNode<T, Id, Compare> *Min_(
+      BinomialHeapNode<T, Id, Compare> **prev_node) const;
 
   // Linked list of root nodes starting from lowest dimension.
-  BinomialHeapNode<T> *root_;
+  BinomialHeapNode<T, Id, Compare> *root_;
 
   // Map of each id to the node.
-  std::unordered_map<int, BinomialHeapNode<T> *> id_to_node_;
+  typename Ids::template Index<BinomialHeapNode<T, Id, Compare> *> id_to_node_;
 };
 
-template <typename T> void BinomialHeap<T>::Add(T key, int id) {
-  BinomialHeapNode<T> *node = new BinomialHeapNode<T>{key, id};
-  CHECK(id_to_node_.emplace(id, node).second);
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::Add(T key, Id id) {
+    auto *node = new BinomialHeapNode<T, Id, Compare>{std::move(key), id};
+  CHECK(id_to_node_.Insert(id, node));
+  this->AddStat_(&HeapStats::adds);
 
   // If no root. Make this the root.
   if (root_ == nullptr) {
     root_ = node;
+  } else if (kEnableHeapStats) {
+    // Each link merges two trees into one.
+    int num_trees = NumRoots_() + 1;
+    root_ = BinomialHeapNode<T, Id, Compare>::AddToTreeList(node, root_);
+    this->AddStat_(&HeapStats::links, num_trees - NumRoots_());
   } else {
-    root_ = BinomialHeapNode<T>::AddToTreeList(node, root_);
+    root_ = BinomialHeapNode<T, Id, Compare>::AddToTreeList(node, root_);
   }
 }
 
-template <typename T> void BinomialHeap<T>::ReduceKey(T new_key, int id) {
-  auto *node = id_to_node_[id];
-  node->set_key(new_key);
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  auto *node = *id_to_node_.Find(id);
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::reduce_keys);
   SiftUp_(node);
 }
 
-template <typename T> const T *BinomialHeap<T>::LookUp(int id) const {
-  const auto it = id_to_node_.find(id);
-  if (it == id_to_node_.end()) {
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  BinomialHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  CHECK(!Less_(new_key, node->key()));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(node);
+}
+
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::Remove(Id id) {
+  BinomialHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the element to the root of its tree, and remove the root.
+  auto *root = SiftUp_(*found, /*to_root=*/true);
+  BinomialHeapNode<T, Id, Compare> *prev_node = nullptr;
+  for (auto *node = root_; node != root; node = node->right()) {
+    prev_node = node;
+  }
+  RemoveRoot_(root, prev_node);
+}
+
+template <typename T, typename Ids, typename Compare>
+const T *BinomialHeap<T, Ids, Compare>::LookUp(Id id) const {
+  auto *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
     return nullptr;
   }
-  return &it->second->key();
+  return &(*node)->key();
 }
 
-template <typename T> HeapElement<T> BinomialHeap<T>::Min() const {
-  BinomialHeapNode<T> *unused_node;
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> BinomialHeap<T, Ids, Compare>::Min() const {
+  BinomialHeapNode<T, Id, Compare> *unused_node;
   const auto *min_node = Min_(&unused_node);
   return std::make_pair(min_node->key(), min_node->id());
 }
 
-template <typename T>
-BinomialHeapNode<T> *
-BinomialHeap<T>::Min_(BinomialHeapNode<T> **prev_node) const {
+template <typename T, typename Ids, typename Compare>
+BinomialHeapNode<T, typename Ids::Id, Compare> *
+BinomialHeap<T, Ids, Compare>::Min_(
+    BinomialHeapNode<T, Id, Compare> **prev_node) const {
   DCHECK(size() > 0);
 
-  BinomialHeapNode<T> *prev = root_;
-  BinomialHeapNode<T> *min_root = root_;
-  BinomialHeapNode<T> *min_root_prev = nullptr;
+  BinomialHeapNode<T, Id, Compare> *prev = root_;
+  BinomialHeapNode<T, Id, Compare> *min_root = root_;
+  BinomialHeapNode<T, Id, Compare> *min_root_prev = nullptr;
   for (auto *root = root_->right(); root != nullptr;
        prev = root, root = root->right()) {
-    if (root->key() < min_root->key()) {
+    if (Less_(root->key(), min_root->key())) {
       min_root = root;
       min_root_prev = prev;
     }
@@ -410,53 +502,129 @@ BinomialHeap<T>::Min_(BinomialHeapNode<T> **prev_node) const {
   return min_root;
 }
 
-template <typename T> HeapElement<T> BinomialHeap<T>::PopMinimum() {
-  BinomialHeapNode<T> *prev_node;
-  BinomialHeapNode<T> *min_root = Min_(&prev_node);
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> BinomialHeap<T, Ids, Compare>::PopMinimum() {
+  BinomialHeapNode<T, Id, Compare> *prev_node;
+  BinomialHeapNode<T, Id, Compare> *min_root = Min_(&prev_node);
+  this->AddStat_(&HeapStats::pops);
+  return RemoveRoot_(min_root, prev_node);
+}
 
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+BinomialHeap<T, Ids, Compare>::RemoveRoot_(
+    BinomialHeapNode<T, Id, Compare> *root,
+    BinomialHeapNode<T, Id, Compare> *prev_node) {
   if (prev_node != nullptr) {
-    prev_node->set_right(min_root->right());
+    prev_node->set_right(root->right());
   } else {
-    root_ = min_root->right();
+    root_ = root->right();
   }
 
-  auto *children = min_root->DetachChildren();
-  root_ = BinomialHeapNode<T>::MergeTreeLists(root_, children);
+  this->AddStat_(&HeapStats::consolidations);
+  int num_trees = kEnableHeapStats ? NumRoots_() + root->dimension() : 0;
+
+  auto *children = root->DetachChildren();
+  root_ = BinomialHeapNode<T, Id, Compare>::MergeTreeLists(root_, children);
 
-  auto result = std::make_pair(min_root->key(), min_root->id());
-  id_to_node_.erase(min_root->id());
-  delete min_root;
+  if (kEnableHeapStats) {
+    this->AddStat_(&HeapStats::links, num_trees - NumRoots_());
+  }
+
+  auto result = std::make_pair(root->take_key(), root->id());
+  id_to_node_.Erase(root->id());
+  delete root;
   return result;
 }
 
-template <typename T> void BinomialHeap<T>::SiftUp_(BinomialHeapNode<T> *node) {
-  T key = node->key();
-  int id = node->id();
+template <typename T, typename Ids, typename Compare>
+BinomialHeapNode<T, typename Ids::Id, Compare> *
+BinomialHeap<T, Ids, Compare>::SiftUp_(BinomialHeapNode<T, Id, Compare> *node,
+                                       bool to_root) {
+  T key = node->take_key();
+  Id id = node->id();
   while (true) {
     auto *parent = node->parent();
 
     // Done if parent is root or has smaller key.
-    if (parent == nullptr || !(key < parent->key())) {
+    if (parent == nullptr || (!to_root && !Less_(key, parent->key()))) {
       break;
     }
 
     // Move the parent down.
-    node->set_key(parent->key());
+    node->set_key(parent->take_key());
     node->set_id(parent->id());
-    id_to_node_[parent->id()] = node;
+    id_to_node_.Set(parent->id(), node);
+    this->AddStat_(&HeapStats::sift_steps);
 
     node = parent;
   }
 
   // Finally place element at pos.
-  node->set_key(key);
+  node->set_key(std::move(key));
   node->set_id(id);
-  id_to_node_[id] = node;
+  id_to_node_.Set(id, node);
+  return node;
 }
 
-template <typename T>
-void BinomialHeap<T>::PrintTree(std::ostream &out,
-                                const std::string &label) const {
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::SiftDown_(
+    BinomialHeapNode<T, Id, Compare> *node) {
+  T key = node->take_key();
+  Id id = node->id();
+  while (node->child() != nullptr) {
+    // Find the child with the smallest key.
+    auto *min_child = node->child();
+    for (auto *child = min_child->right(); child != nullptr;
+         child = child->right()) {
+      if (Less_(child->key(), min_child->key())) {
+        min_child = child;
+      }
+    }
+
+    // Done if all children are larger.
+    if (!Less_(min_child->key(), key)) {
+      break;
+    }
+
+    // Move the child up.
+    node->set_key(min_child->take_key());
+    node->set_id(min_child->id());
+    id_to_node_.Set(min_child->id(), node);
+    this->AddStat_(&HeapStats::sift_steps);
+
+    node = min_child;
+  }
+
+  // Finally place element at node.
+  node->set_key(std::move(key));
+  node->set_id(id);
+  id_to_node_.Set(id, node);
+}
+
+template <typename T, typename Ids, typename Compare>
+int BinomialHeap<T, Ids, Compare>::NumRoots_() const {
+  int num_roots = 0;
+  for (const auto *root = root_; root != nullptr; root = root->right()) {
+    num_roots++;
+  }
+  return num_roots;
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats BinomialHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  for (const auto *root = root_; root != nullptr; root = root->right()) {
+    // A binomial tree of dimension d has height d + 1.
+    stats.num_trees++;
+    stats.max_height = std::max(stats.max_height, root->dimension() + 1);
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::PrintTree(std::ostream &out,
+                                              const std::string &label) const {
   out << std::endl
       << "-- Heap (" << size() << ") " << label << " --" << std::endl;
   for (const auto *root = root_; root != nullptr; root = root->right()) {
@@ -466,9 +634,10 @@ void BinomialHeap<T>::PrintTree(std::ostream &out,
   out << std::endl;
 }
 
-template <typename T> void BinomialHeap<T>::Validate() const {
+template <typename T, typename Ids, typename Compare>
+void BinomialHeap<T, Ids, Compare>::Validate() const {
   int prev_dimension = -1;
-  std::unordered_set<int> seen_ids;
+  std::unordered_set<Id> seen_ids;
   for (auto *root = root_; root != nullptr; root = root->right()) {
     CHECK(root->is_root());
     CHECK(root->dimension() > prev_dimension);
@@ -476,13 +645,9 @@ template <typename T> void BinomialHeap<T>::Validate() const {
     prev_dimension = root->dimension();
   }
 
-  if (seen_ids.size() != size()) {
-    for (const auto &entry : id_to_node_) {
-      if (seen_ids.find(entry.first) == seen_ids.end()) {
-        LOG(ERROR) << "Id not seen: " << entry.first << std::endl;
-      }
-    }
-    LOG(FATAL) << "Some ids are missing";
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
   }
 }
 
@@ -0,0 +1,410 @@
+// Compact Pairing Heap.
+//
+// A Pairing Heap whose nodes live in a NodePool and link to each other with
+// 32-bit indices. Same algorithm as PairingHeap with two-pass pairing, in
+// about half the memory per node, and without an allocation per Add.
+
+#ifndef HEAPS_COMPACT_PAIRING_HEAP_H_
+#define HEAPS_COMPACT_PAIRING_HEAP_H_
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/node_pool.h"
+
+// A node used in Compact Pairing Heaps. Links are indices in the heap's
+// NodePool, or kNullNodeIndex for none.
+template <typename T, typename Id = int> struct CompactPairingHeapNode {
+  CompactPairingHeapNode(T key, Id id)
+      : key(std::move(key)), id(id), child(kNullNodeIndex),
+        left(kNullNodeIndex), right(kNullNodeIndex) {}
+
+  T key;
+
+  // An id that uniquely identifies this node.
+  Id id;
+
+  // The first child.
+  uint32_t child;
+
+  // The previous sibling. If it has no previous sibling, the parent.
+  uint32_t left;
+
+  // The next sibling.
+  uint32_t right;
+};
+
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class CompactPairingHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  CompactPairingHeap() : root_(kNullNodeIndex) {}
+
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Compact Pairing Heap",
+        []() { return new CompactPairingHeap<T, Ids, Compare>{}; });
+  }
+
+  // Returns number of elements.
+  virtual int size() const override { return nodes_.size(); }
+
+  // Adds an element with key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Updates with a lower key.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Returns the min element.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Print for debugging.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override;
+
+  // Validate the invariants.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return nodes_.MemoryUsage() + id_to_index_.MemoryUsage();
+  }
+
+private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  using Node = CompactPairingHeapNode<T, Id>;
+
+  // Add a child to a node.
+  void AddChild_(uint32_t parent, uint32_t child);
+
+  // Remove a node from its parent.
+  void DetachFromParent_(uint32_t index);
+
+  // Merge two trees, and return the new root.
+  uint32_t MergeTrees_(uint32_t a, uint32_t b);
+
+  // Merge a list of trees: pairs from left to right, then the pairs from
+  // right to left.
+  uint32_t MergeTreeList_(uint32_t tree_list);
+
+  // Detaches the children of a node, and merges them into one tree. Returns
+  // kNullNodeIndex if it has no children.
+  uint32_t MergeChildren_(uint32_t index);
+
+  // Print the subtree under a node.
+  void PrintTree_(std::ostream &out, uint32_t index, int level) const;
+
+  NodePool<Node> nodes_;
+
+  // The min root node. Maybe kNullNodeIndex.
+  uint32_t root_;
+
+  // Map of each id to the node index.
+  typename Ids::template Index<uint32_t> id_to_index_;
+};
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::AddChild_(uint32_t parent,
+                                                    uint32_t child) {
+  Node &parent_node = nodes_[parent];
+  Node &child_node = nodes_[child];
+  if (parent_node.child != kNullNodeIndex) {
+    nodes_[parent_node.child].left = child;
+  }
+  child_node.left = parent;
+  child_node.right = parent_node.child;
+  parent_node.child = child;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::DetachFromParent_(uint32_t index) {
+  Node &node = nodes_[index];
+  Node &left = nodes_[node.left];
+  if (left.child == index) {
+    // This is the first child. left is the parent.
+    left.child = node.right;
+  } else {
+    left.right = node.right;
+  }
+  if (node.right != kNullNodeIndex) {
+    nodes_[node.right].left = node.left;
+  }
+  node.left = kNullNodeIndex;
+  node.right = kNullNodeIndex;
+}
+
+template <typename T, typename Ids, typename Compare>
+uint32_t CompactPairingHeap<T, Ids, Compare>::MergeTrees_(uint32_t a,
+                                                          uint32_t b) {
+  if (Less_(nodes_[a].key, nodes_[b].key)) {
+    AddChild_(a, b);
+    return a;
+  } else {
+    AddChild_(b, a);
+    return b;
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+uint32_t CompactPairingHeap<T, Ids, Compare>::MergeTreeList_(
+    uint32_t tree_list) {
+  if (tree_list == kNullNodeIndex) {
+    return kNullNodeIndex;
+  }
+
+  // Merge pairs from left to right.
+  uint32_t merged_head = kNullNodeIndex;
+  uint32_t node = tree_list;
+  do {
+    uint32_t next = nodes_[node].right;
+
+    if (next == kNullNodeIndex) {
+      nodes_[node].right = merged_head;
+      merged_head = node;
+      break;
+    }
+
+    uint32_t next_next = nodes_[next].right;
+    uint32_t merged = MergeTrees_(node, next);
+    nodes_[merged].right = merged_head;
+    merged_head = merged;
+
+    node = next_next;
+  } while (node != kNullNodeIndex);
+
+  // Merge pairs from right to left.
+  node = nodes_[merged_head].right;
+  nodes_[merged_head].right = kNullNodeIndex;
+  while (node != kNullNodeIndex) {
+    uint32_t next = nodes_[node].right;
+    nodes_[node].right = kNullNodeIndex;
+    merged_head = MergeTrees_(node, merged_head);
+    node = next;
+  }
+
+  nodes_[merged_head].left = kNullNodeIndex;
+  return merged_head;
+}
+
+template <typename T, typename Ids, typename Compare>
+uint32_t CompactPairingHeap<T, Ids, Compare>::MergeChildren_(uint32_t index) {
+  const uint32_t children = nodes_[index].child;
+  nodes_[index].child = kNullNodeIndex;
+  this->AddStat_(&HeapStats::consolidations);
+  if (kEnableHeapStats && children != kNullNodeIndex) {
+    // Merging a list of trees takes one link less than the number of trees.
+    for (uint32_t child = nodes_[children].right; child != kNullNodeIndex;
+         child = nodes_[child].right) {
+      this->AddStat_(&HeapStats::links);
+    }
+  }
+  return MergeTreeList_(children);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::Add(T key, Id id) {
+  uint32_t index = nodes_.Allocate(Node{std::move(key), id});
+  CHECK(id_to_index_.Insert(id, index));
+  this->AddStat_(&HeapStats::adds);
+
+  // If no root. Make this the root.
+  if (root_ == kNullNodeIndex) {
+    root_ = index;
+  } else {
+    root_ = MergeTrees_(root_, index);
+    this->AddStat_(&HeapStats::links);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  uint32_t index = *id_to_index_.Find(id);
+  DCHECK(!Less_(nodes_[index].key, new_key));
+  nodes_[index].key = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+
+  if (index == root_) {
+    return;
+  }
+  DetachFromParent_(index);
+  root_ = MergeTrees_(root_, index);
+  this->AddStat_(&HeapStats::cuts);
+  this->AddStat_(&HeapStats::links);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  uint32_t *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  const uint32_t index = *found;
+  CHECK(!Less_(new_key, nodes_[index].key));
+  nodes_[index].key = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Merge them into a tree of their own,
+  // and link it with the root.
+  const uint32_t children = MergeChildren_(index);
+  if (children == kNullNodeIndex) {
+    return;
+  }
+  root_ = MergeTrees_(root_, children);
+  this->AddStat_(&HeapStats::links);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::Remove(Id id) {
+  uint32_t *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  const uint32_t index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  const uint32_t children = MergeChildren_(index);
+  if (index == root_) {
+    root_ = children;
+  } else {
+    DetachFromParent_(index);
+    this->AddStat_(&HeapStats::cuts);
+    if (children != kNullNodeIndex) {
+      root_ = MergeTrees_(root_, children);
+      this->AddStat_(&HeapStats::links);
+    }
+  }
+  nodes_.Free(index);
+}
+
+template <typename T, typename Ids, typename Compare>
+const T *CompactPairingHeap<T, Ids, Compare>::LookUp(Id id) const {
+  const uint32_t *found = id_to_index_.Find(id);
+  if (found == nullptr) {
+    return nullptr;
+  }
+  return &nodes_[*found].key;
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+CompactPairingHeap<T, Ids, Compare>::Min() const {
+  DCHECK(size() > 0);
+  return std::make_pair(nodes_[root_].key, nodes_[root_].id);
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+CompactPairingHeap<T, Ids, Compare>::PopMinimum() {
+  DCHECK(size() > 0);
+
+  const uint32_t min_root = root_;
+  this->AddStat_(&HeapStats::pops);
+  root_ = MergeChildren_(min_root);
+
+  auto result =
+      std::make_pair(std::move(nodes_[min_root].key), nodes_[min_root].id);
+  id_to_index_.Erase(result.second);
+  nodes_.Free(min_root);
+  return result;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::PrintTree_(std::ostream &out,
+                                                     uint32_t index,
+                                                     int level) const {
+  for (; index != kNullNodeIndex; index = nodes_[index].right) {
+    const Node &node = nodes_[index];
+    for (int i = 0; i < level; ++i) {
+      out << "| ";
+    }
+    out << node.key << " [id:" << node.id << "][index:" << index << "]"
+        << std::endl;
+    PrintTree_(out, node.child, level + 1);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << std::endl
+      << "-- Heap (" << size() << ") " << label << " --" << std::endl;
+  PrintTree_(out, root_, 1);
+  out << std::endl;
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats CompactPairingHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  if (root_ == kNullNodeIndex) {
+    return stats;
+  }
+  stats.num_trees = 1;
+
+  // Walk the tree with an explicit stack, as it may be deep.
+  std::vector<std::pair<uint32_t, int>> stack{{root_, 1}};
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    stats.max_height = std::max(stats.max_height, entry.second);
+    for (uint32_t child = nodes_[entry.first].child; child != kNullNodeIndex;
+         child = nodes_[child].right) {
+      stack.emplace_back(child, entry.second + 1);
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactPairingHeap<T, Ids, Compare>::Validate() const {
+  if (root_ == kNullNodeIndex) {
+    CHECK(size() == 0);
+    return;
+  }
+  CHECK(nodes_[root_].left == kNullNodeIndex);
+  CHECK(nodes_[root_].right == kNullNodeIndex);
+
+  // Walk the tree with an explicit stack, as it may be deep.
+  std::unordered_set<Id> seen_ids;
+  std::vector<uint32_t> stack{root_};
+  while (!stack.empty()) {
+    const uint32_t index = stack.back();
+    stack.pop_back();
+    const Node &node = nodes_[index];
+    CHECK(seen_ids.insert(node.id).second);
+    CHECK(*id_to_index_.Find(node.id) == index);
+
+    uint32_t left = index;
+    for (uint32_t child = node.child; child != kNullNodeIndex;
+         child = nodes_[child].right) {
+      CHECK(nodes_[child].left == left);
+      CHECK(!Less_(nodes_[child].key, node.key));
+      stack.push_back(child);
+      left = child;
+    }
+  }
+  CHECK(seen_ids.size() == size());
+}
+
+#endif /* HEAPS_COMPACT_PAIRING_HEAP_H_ */
@@ -0,0 +1,360 @@
+// Compact Weak Heap.
+//
+// A Weak Heap that keeps the keys and the ids in separate arrays, and the
+// reverse bits packed 64 to a word. Sifting only compares keys, so it reads
+// one dense array. AddAll builds the heap bottom-up with n - 1 comparisons.
+
+#ifndef HEAPS_COMPACT_WEAK_HEAP_H_
+#define HEAPS_COMPACT_WEAK_HEAP_H_
+
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/weak_heapsort.h"
+
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class CompactWeakHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  // A factory for this heap.
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Compact Weak Heap",
+        []() { return new CompactWeakHeap<T, Ids, Compare>{}; });
+  }
+
+  // Returns number of elements.
+  virtual int size() const override { return static_cast<int>(keys_.size()); }
+
+  // Adds an element with key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Adds elements with unique ids, moving their keys in. Into an empty heap,
+  // builds the heap bottom-up.
+  void AddAll(std::vector<HeapElement<T, Id>> elements);
+
+  // Updates an element with a lower key.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates an element with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by its id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Returns the minimum element.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Print the subtree under this node.
+  void PrintTree(std::ostream &out, const std::string &label) const override;
+
+  // Validate the structure of the heap.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return ContainerMemoryUsage(keys_) + ContainerMemoryUsage(ids_) +
+           reverse_children_.MemoryUsage() +
+           id_to_index_.MemoryUsage();
+  }
+
+private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Move element at `pos` upwards until its parent is smaller.
+  void SiftUp_(int pos);
+
+  // Move the element at `pos` downwards until the constraints are satisfied.
+  void SiftDown_(int pos);
+
+  // Set an element at particular position and update index.
+  void SetElement_(int pos, T &&key, Id id);
+
+  // Print the heap recursively.
+  void PrintTree_(int pos, std::ostream &out, int level) const;
+
+  // The keys and ids of the elements, in heap order.
+  std::vector<T> keys_;
+  std::vector<Id> ids_;
+
+  // Whether to reverse the left/right child of each element.
+  WeakHeapBits reverse_children_;
+
+  // A map from the element id to its index in the arrays.
+  typename Ids::template Index<int> id_to_index_;
+};
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::Add(T key, Id id) {
+  int pos = size();
+  CHECK(id_to_index_.Insert(id, pos));
+  keys_.push_back(std::move(key));
+  ids_.push_back(id);
+  reverse_children_.PushBack();
+  this->AddStat_(&HeapStats::adds);
+  SiftUp_(pos);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::AddAll(
+    std::vector<HeapElement<T, Id>> elements) {
+  if (size() > 0) {
+    for (auto &element : elements) {
+      Add(std::move(element.first), element.second);
+    }
+    return;
+  }
+
+  keys_.reserve(elements.size());
+  ids_.reserve(elements.size());
+  for (auto &element : elements) {
+    keys_.push_back(std::move(element.first));
+    ids_.push_back(element.second);
+  }
+  this->AddStat_(&HeapStats::adds, elements.size());
+  WeakHeapify(
+      size(), &reverse_children_,
+      [this](int i, int j) { return Less_(keys_[i], keys_[j]); },
+      [this](int i, int j) {
+        std::swap(keys_[i], keys_[j]);
+        std::swap(ids_[i], ids_[j]);
+        this->AddStat_(&HeapStats::sift_steps);
+      });
+
+  id_to_index_.Reserve(elements.size());
+  for (int pos = 0; pos < size(); ++pos) {
+    CHECK(id_to_index_.Insert(ids_[pos], pos));
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::SiftUp_(int pos) {
+  T key = std::move(keys_[pos]);
+  Id id = ids_[pos];
+
+  while (pos > 0) {
+    // Done if parent is smaller.
+    int ancestor = WeakHeapAncestor(reverse_children_, pos);
+    if (!Less_(key, keys_[ancestor])) {
+      break;
+    }
+
+    // Move the parent down.
+    SetElement_(pos, std::move(keys_[ancestor]), ids_[ancestor]);
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = ancestor;
+  }
+
+  // Finally place the element at pos.
+  SetElement_(pos, std::move(key), id);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::SiftDown_(int pos) {
+  const int n = size();
+  int child = pos * 2 + 1 - reverse_children_[pos];
+  if (child >= n) {
+    return;
+  }
+  T top_key = std::move(keys_[pos]);
+  Id top_id = ids_[pos];
+
+  // Traverse to the last child of pos.
+  do {
+    child = child * 2 + reverse_children_[child];
+  } while (child < n);
+
+  // Traverse the siblings up to pos, joining each with pos.
+  for (child /= 2; child != pos; child /= 2) {
+    this->AddStat_(&HeapStats::links);
+    if (!Less_(keys_[child], top_key)) {
+      continue;
+    }
+
+    // Swap the element at child with the top element.
+    std::swap(keys_[child], top_key);
+    std::swap(ids_[child], top_id);
+    id_to_index_.Set(ids_[child], child);
+
+    // Reverse the left/right children.
+    reverse_children_.Flip(child);
+    this->AddStat_(&HeapStats::sift_steps);
+  }
+
+  SetElement_(pos, std::move(top_key), top_id);
+}
+
+template <typename T, typename Ids, typename Compare>
+const T *CompactWeakHeap<T, Ids, Compare>::LookUp(Id id) const {
+  const int *found = id_to_index_.Find(id);
+  if (found == nullptr) {
+    return nullptr;
+  }
+  return &keys_[*found];
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> CompactWeakHeap<T, Ids, Compare>::Min() const {
+  DCHECK(size() > 0);
+  return std::make_pair(keys_[0], ids_[0]);
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+CompactWeakHeap<T, Ids, Compare>::PopMinimum() {
+  DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  id_to_index_.Erase(ids_[0]);
+  auto min_element = std::make_pair(std::move(keys_[0]), ids_[0]);
+
+  // Move last element to the head of the heap and sift down.
+  if (size() > 1) {
+    SetElement_(0, std::move(keys_.back()), ids_.back());
+  }
+  keys_.pop_back();
+  ids_.pop_back();
+  reverse_children_.PopBack();
+  if (size() > 0) {
+    SiftDown_(0);
+  }
+  return min_element;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(keys_[index], new_key));
+  keys_[index] = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+  SiftUp_(index);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(new_key, keys_[index]));
+  keys_[index] = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(index);
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::Remove(Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the last element into the hole, and sift it up or down.
+  const int last = size() - 1;
+  if (index < last) {
+    SetElement_(index, std::move(keys_[last]), ids_[last]);
+  }
+  keys_.pop_back();
+  ids_.pop_back();
+  reverse_children_.PopBack();
+  if (index == last) {
+    return;
+  }
+  if (index > 0 &&
+      Less_(keys_[index], keys_[WeakHeapAncestor(reverse_children_, index)])) {
+    SiftUp_(index);
+  } else {
+    SiftDown_(index);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats CompactWeakHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  stats.num_trees = keys_.empty() ? 0 : 1;
+  for (int n = size(); n > 0; n /= 2) {
+    stats.max_height++;
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::SetElement_(int pos, T &&key, Id id) {
+  id_to_index_.Set(id, pos);
+  keys_[pos] = std::move(key);
+  ids_[pos] = id;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << std::endl
+      << "-- Heap (" << size() << ") " << label << " --" << std::endl;
+
+  if (size() > 0) {
+    out << keys_[0] << " [pos: 0][id:" << ids_[0] << "]" << std::endl;
+    if (size() > 1) {
+      PrintTree_(1, out, 1);
+    }
+  }
+  out << std::endl;
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::PrintTree_(int pos, std::ostream &out,
+                                                  int level) const {
+  for (int i = 0; i < level; ++i) {
+    out << "| ";
+  }
+  out << keys_[pos] << " [pos: " << pos << "][id:" << ids_[pos]
+      << "][reverse: " << reverse_children_[pos] << "]" << std::endl;
+
+  int child_pos = pos * 2 + 1 - reverse_children_[pos];
+  int sibling_pos = pos * 2 + reverse_children_[pos];
+  if (child_pos < size()) {
+    PrintTree_(child_pos, out, level + 1);
+  }
+  if (sibling_pos < size()) {
+    PrintTree_(sibling_pos, out, level);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void CompactWeakHeap<T, Ids, Compare>::Validate() const {
+  CHECK(ids_.size() == keys_.size());
+  CHECK(reverse_children_.size() == size());
+  if (size() > 0) {
+    CHECK(reverse_children_[0] == 0);
+  }
+
+  for (int pos = 1; pos < size(); ++pos) {
+    int ancestor = WeakHeapAncestor(reverse_children_, pos);
+    CHECK(!Less_(keys_[pos], keys_[ancestor]));
+  }
+  for (int pos = 0; pos < size(); ++pos) {
+    CHECK(*id_to_index_.Find(ids_[pos]) == pos);
+  }
+
+  CHECK(id_to_index_.size() == keys_.size());
+}
+
+#endif /* HEAPS_COMPACT_WEAK_HEAP_H_ */
@@ -0,0 +1,391 @@
+// D-ary Heap.
+//
+// See https://en.wikipedia.org/wiki/D-ary_heap
+//
+// An array heap where each node has kArity children, with the keys and the
+// ids in separate arrays, so that the children's keys are contiguous. The
+// minimum child is found without branches: with SSE4.1 or AVX2 min-reduction
+// for int keys in the default order when the compiler targets them, and with
+// conditional moves otherwise. The SIMD versions are off by default, since
+// the default build targets neither; build with --config=avx2 to turn them
+// on. heap_test_avx2 runs the heap tests with them.
+
+#ifndef HEAPS_DARY_HEAP_H_
+#define HEAPS_DARY_HEAP_H_
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+
+namespace dary_heap_internal {
+
+// Returns the index of the minimum of `n` keys by Compare. Ties go to the
+// first.
+template <typename T, typename Compare> int MinIndex(const T *keys, int n) {
+  int min_index = 0;
+  for (int i = 1; i < n; ++i) {
+    min_index = Compare()(keys[i], keys[min_index]) ? i : min_index;
+  }
+  return min_index;
+}
+
+// Returns the index of the minimum of kArity keys. The SIMD versions below
+// are for int keys in the default order.
+template <typename T, int kArity, typename Compare> struct FullMinIndex {
+  static int Find(const T *keys) { return MinIndex<T, Compare>(keys, kArity); }
+};
+
+#ifdef __SSE4_1__
+// Returns the lowest lane of `keys` equal to their minimum.
+inline int MinLane(__m128i keys) {
+  __m128i min = _mm_min_epi32(
+      keys, _mm_shuffle_epi32(keys, _MM_SHUFFLE(2, 3, 0, 1)));
+  min = _mm_min_epi32(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(1, 0, 3, 2)));
+  return __builtin_ctz(
+      _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(keys, min))));
+}
+
+template <> struct FullMinIndex<int, 4, std::less<int>> {
+  static int Find(const int *keys) {
+    return MinLane(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys)));
+  }
+};
+#endif
+
+#ifdef __AVX2__
+// Returns the minimum of the lanes of `keys`, broadcast to all lanes.
+inline __m256i BroadcastMin(__m256i keys) {
+  __m256i min = _mm256_min_epi32(
+      keys, _mm256_shuffle_epi32(keys, _MM_SHUFFLE(2, 3, 0, 1)));
+  min = _mm256_min_epi32(min,
+                         _mm256_shuffle_epi32(min, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm256_min_epi32(min, _mm256_permute2x128_si256(min, min, 1));
+}
+
+// Returns a bit mask of the lanes of `keys` equal to `min`.
+inline int EqualLanes(__m256i keys, __m256i min) {
+  return _mm256_movemask_ps(
+      _mm256_castsi256_ps(_mm256_cmpeq_epi32(keys, min)));
+}
+
+template <> struct FullMinIndex<int, 8, std::less<int>> {
+  static int Find(const int *keys) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys));
+    return __builtin_ctz(EqualLanes(v, BroadcastMin(v)));
+  }
+};
+
+template <> struct FullMinIndex<int, 16, std::less<int>> {
+  static int Find(const int *keys) {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys));
+    __m256i high =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + 8));
+    __m256i min = BroadcastMin(_mm256_min_epi32(low, high));
+    return __builtin_ctz(EqualLanes(low, min) | (EqualLanes(high, min) << 8));
+  }
+};
+#endif
+
+} // namespace dary_heap_internal
+
+template <typename T, int kArity, typename Ids = HeapIds<>,
+          typename Compare = std::less<T>>
+class DaryHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  static_assert(kArity >= 2, "A D-ary Heap needs at least 2 children");
+
+  // A factory for this heap.
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        std::to_string(kArity) + "-ary Heap",
+        []() { return new DaryHeap<T, kArity, Ids, Compare>{}; });
+  };
+
+  // Returns number of elements.
+  virtual int size() const override { return static_cast<int>(keys_.size()); }
+
+  // Adds an element with given key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Updates a element with a lower key.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates an element with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by its id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Returns the minimum element.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Print for debugging.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override;
+
+  // Validate the structure of the heap.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return ContainerMemoryUsage(keys_) + ContainerMemoryUsage(ids_) +
+           id_to_index_.MemoryUsage();
+  }
+
+private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Move element at `pos` upwards until its parent is smaller.
+  void SiftUp_(int pos);
+
+  // Move element at `pos` downwards until it's smaller than the children.
+  void SiftDown_(int pos);
+
+  // Returns the child of `pos` with the smallest key. `pos` must have a
+  // child.
+  int MinChild_(int pos) const;
+
+  // Set an element at particular position and update id_to_index_ map.
+  void SetElement_(int pos, T &&key, Id id);
+
+  // Print the heap.
+  void Print_(int pos, std::ostream &out, int level) const;
+
+  // The keys and ids of the elements, in heap order. The children of
+  // `pos` are at pos * kArity + 1 to pos * kArity + kArity.
+  std::vector<T> keys_;
+  std::vector<Id> ids_;
+
+  // A map from the element id to its index in the arrays.
+  typename Ids::template Index<int> id_to_index_;
+};
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::Add(T key, Id id) {
+  int pos = size();
+  keys_.push_back(std::move(key));
+  ids_.push_back(id);
+  CHECK(id_to_index_.Insert(id, pos));
+  this->AddStat_(&HeapStats::adds);
+  SiftUp_(pos);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(keys_[index], new_key));
+  keys_[index] = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+  SiftUp_(index);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(new_key, keys_[index]));
+  keys_[index] = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(index);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::Remove(Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the last element into the hole, and sift it up or down.
+  const int last = size() - 1;
+  if (index < last) {
+    SetElement_(index, std::move(keys_[last]), ids_[last]);
+  }
+  keys_.pop_back();
+  ids_.pop_back();
+  if (index == last) {
+    return;
+  }
+  if (index > 0 && Less_(keys_[index], keys_[(index - 1) / kArity])) {
+    SiftUp_(index);
+  } else {
+    SiftDown_(index);
+  }
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+const T *DaryHeap<T, kArity, Ids, Compare>::LookUp(Id id) const {
+  const int *found = id_to_index_.Find(id);
+  if (found == nullptr) {
+    return nullptr;
+  }
+  return &keys_[*found];
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+DaryHeap<T, kArity, Ids, Compare>::Min() const {
+  DCHECK(size() > 0);
+  return std::make_pair(keys_[0], ids_[0]);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+DaryHeap<T, kArity, Ids, Compare>::PopMinimum() {
+  DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  id_to_index_.Erase(ids_[0]);
+  auto min = std::make_pair(std::move(keys_[0]), ids_[0]);
+
+  // Move last element to the head of the heap and sift down.
+  if (size() > 1) {
+    SetElement_(0, std::move(keys_.back()), ids_.back());
+  }
+  keys_.pop_back();
+  ids_.pop_back();
+  if (size() > 1) {
+    SiftDown_(0);
+  }
+  return min;
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::SiftUp_(int pos) {
+  T key = std::move(keys_[pos]);
+  Id id = ids_[pos];
+
+  while (pos > 0) {
+    // Done if parent is smaller.
+    int parent = (pos - 1) / kArity;
+    if (!Less_(key, keys_[parent])) {
+      break;
+    }
+
+    // Move the parent down.
+    SetElement_(pos, std::move(keys_[parent]), ids_[parent]);
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = parent;
+  }
+
+  // Finally place element at pos.
+  SetElement_(pos, std::move(key), id);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+int DaryHeap<T, kArity, Ids, Compare>::MinChild_(int pos) const {
+  const int first_child = pos * kArity + 1;
+  const T *children = &keys_[first_child];
+  if (first_child + kArity <= size()) {
+    return first_child +
+           dary_heap_internal::FullMinIndex<T, kArity, Compare>::Find(
+               children);
+  }
+  return first_child + dary_heap_internal::MinIndex<T, Compare>(
+                           children, size() - first_child);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::SiftDown_(int pos) {
+  T key = std::move(keys_[pos]);
+  Id id = ids_[pos];
+
+  while (pos * kArity + 1 < size()) {
+    // Done if the smallest child is not smaller.
+    int child = MinChild_(pos);
+    if (!Less_(keys_[child], key)) {
+      break;
+    }
+
+    // Move child element up to parent pos.
+    SetElement_(pos, std::move(keys_[child]), ids_[child]);
+    this->AddStat_(&HeapStats::sift_steps);
+    pos = child;
+  }
+
+  // Finally place element at pos.
+  SetElement_(pos, std::move(key), id);
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::SetElement_(int pos, T &&key, Id id) {
+  id_to_index_.Set(id, pos);
+  keys_[pos] = std::move(key);
+  ids_[pos] = id;
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+HeapStats DaryHeap<T, kArity, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  stats.num_trees = keys_.empty() ? 0 : 1;
+  long level_size = 1;
+  for (long n = 0; n < size(); n += level_size, level_size *= kArity) {
+    stats.max_height++;
+  }
+  return stats;
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << "Heap(" << label << "):" << std::endl;
+  if (size() > 0) {
+    Print_(0, out, 1);
+  }
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::Validate() const {
+  CHECK(ids_.size() == keys_.size());
+  for (int pos = 1; pos < size(); ++pos) {
+    int parent = (pos - 1) / kArity;
+    CHECK(!Less_(keys_[pos], keys_[parent]));
+  }
+  for (int pos = 0; pos < size(); ++pos) {
+    CHECK(*id_to_index_.Find(ids_[pos]) == pos);
+  }
+  CHECK(id_to_index_.size() == keys_.size());
+}
+
+template <typename T, int kArity, typename Ids, typename Compare>
+void DaryHeap<T, kArity, Ids, Compare>::Print_(int pos, std::ostream &out,
+                                               int level) const {
+  for (int i = 0; i < level; ++i) {
+    out << "| ";
+  }
+  out << "[" << keys_[pos] << ",id:" << ids_[pos] << "] " << std::endl;
+
+  for (int child = pos * kArity + 1;
+       child <= pos * kArity + kArity && child < size(); ++child) {
+    Print_(child, out, level + 1);
+  }
+}
+
+#endif /* HEAPS_DARY_HEAP_H_ */
@@ -0,0 +1,256 @@
+// Heap workloads with the shape of Dijkstra's algorithm.
+//
+// GenerateDijkstraWorkload runs single source shortest paths on a generated
+// graph, and records the heap operations as a trace. The graph only exists
+// implicitly, so large workloads are cheap to generate.
+
+#ifndef HEAPS_DIJKSTRA_WORKLOAD_H_
+#define HEAPS_DIJKSTRA_WORKLOAD_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "heaps/heap_trace.h"
+
+// Graph classes for Dijkstra workloads.
+enum class DijkstraWorkloadGraph {
+  // A square grid, with edges to the 4 neighbours. The heap holds a thin
+  // frontier of about the square root of the number of vertices, as on a
+  // road network.
+  kGrid,
+  // Edges to uniformly random vertices. The heap quickly grows to hold a
+  // large fraction of the vertices.
+  kRandom,
+};
+
+// Parameters of a Dijkstra workload.
+struct DijkstraWorkloadParams {
+  DijkstraWorkloadGraph graph = DijkstraWorkloadGraph::kGrid;
+
+  // Rounded down to a square for kGrid.
+  int num_vertices = 250000;
+
+  // Only used for kRandom.
+  int edges_per_vertex = 4;
+
+  // Edge weights are uniform in [1, max_weight].
+  int max_weight = 100;
+
+  unsigned seed = 12345;
+};
+
+// The shape of a Dijkstra workload, as it was generated.
+struct DijkstraWorkloadProfile {
+  long num_adds = 0;
+  long num_reduce_keys = 0;
+  long num_pops = 0;
+  long num_lookups = 0;
+
+  // Heap size before each pop.
+  int max_heap_size = 0;
+  double mean_heap_size = 0;
+
+  // Mean distance above the last popped key, of added keys and of reduced
+  // keys. Reduced keys land closer to the minimum than added keys.
+  double mean_add_gap = 0;
+  double mean_reduce_key_gap = 0;
+
+  // Mean fraction by which ReduceKey lowers the distance above the last
+  // popped key.
+  double mean_reduce_key_fraction = 0;
+};
+
+inline std::ostream &operator<<(std::ostream &out,
+                                const DijkstraWorkloadProfile &profile) {
+  out << "adds " << profile.num_adds << ", reduce-keys "
+      << profile.num_reduce_keys << ", pops " << profile.num_pops
+      << ", lookups " << profile.num_lookups << ", heap size max "
+      << profile.max_heap_size << " mean " << profile.mean_heap_size
+      << ", gap above min: add " << profile.mean_add_gap << " reduce-key "
+      << profile.mean_reduce_key_gap << ", reduce-key fraction "
+      << profile.mean_reduce_key_fraction;
+  return out;
+}
+
+namespace dijkstra_workload_internal {
+
+// xorshift64*.
+inline uint64_t NextRandom(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545F4914F6CDD1DULL;
+}
+
+} // namespace dijkstra_workload_internal
+
+// Runs Dijkstra's algorithm from vertex 0 of a graph of the given class, and
+// appends the heap operations to `trace`, the way DijkstraShortestPath
+// issues them: one PopMinimum per vertex, then for each unsettled neighbour
+// a LookUp, followed by an Add or a ReduceKey if the distance is shorter.
+// Vertex ids are the heap ids. If `profile` is not null, it is filled with
+// the shape of the workload.
+//
+// The edges of a vertex are drawn when it is settled, which is the only
+// time they are relaxed, so this is the same as a fixed directed graph.
+// Replaying the trace on any heap is valid even though heaps pop ties in
+// different orders, because keys are only ever reduced to above the last
+// popped key. Lookups of vertices tied with the minimum may find them or
+// not, depending on the heap.
+inline void
+GenerateDijkstraWorkload(const DijkstraWorkloadParams &params,
+                         HeapTrace<int> *trace,
+                         DijkstraWorkloadProfile *profile = nullptr) {
+  using dijkstra_workload_internal::NextRandom;
+  CHECK(params.num_vertices > 0);
+  CHECK(params.max_weight > 0);
+
+  const bool grid = params.graph == DijkstraWorkloadGraph::kGrid;
+  const int width =
+      grid ? static_cast<int>(
+                 std::sqrt(static_cast<double>(params.num_vertices)))
+           : 0;
+  const int num_vertices = grid ? width * width : params.num_vertices;
+  CHECK(num_vertices > 0);
+
+  // -1 until reached.
+  std::vector<int> distances(num_vertices, -1);
+  std::vector<bool> settled(num_vertices, false);
+  // Vertices by distance, a bucket queue to find the minimum without a
+  // heap. Entries go stale when their vertex is settled or reduced.
+  std::vector<std::vector<int>> buckets;
+  int current_bucket = 0;
+  int heap_size = 0;
+  uint64_t random_state = params.seed | 1;
+
+  DijkstraWorkloadProfile local_profile;
+  double sum_heap_size = 0;
+  double sum_add_gap = 0;
+  double sum_reduce_key_gap = 0;
+  double sum_reduce_key_fraction = 0;
+
+  auto push = [&](int key, int id) {
+    if (key >= buckets.size()) {
+      buckets.resize(key + 1);
+    }
+    buckets[key].push_back(id);
+  };
+
+  trace->push_back({HeapOperation::kAdd, 0, 0});
+  distances[0] = 0;
+  push(0, 0);
+  heap_size++;
+  local_profile.num_adds++;
+
+  std::vector<int> neighbours;
+  while (heap_size > 0) {
+    // Find the minimum. Stale entries in the buckets are skipped.
+    int vertex = -1;
+    while (vertex < 0) {
+      auto &bucket = buckets[current_bucket];
+      while (!bucket.empty()) {
+        int id = bucket.back();
+        bucket.pop_back();
+        if (!settled[id] && distances[id] == current_bucket) {
+          vertex = id;
+          break;
+        }
+      }
+      if (vertex < 0) {
+        current_bucket++;
+      }
+    }
+    const int min_key = current_bucket;
+
+    sum_heap_size += heap_size;
+    local_profile.max_heap_size =
+        std::max(local_profile.max_heap_size, heap_size);
+    trace->push_back({HeapOperation::kPopMinimum, -1, 0});
+    local_profile.num_pops++;
+    settled[vertex] = true;
+    heap_size--;
+
+    neighbours.clear();
+    if (grid) {
+      const int x = vertex % width;
+      const int y = vertex / width;
+      if (x > 0) {
+        neighbours.push_back(vertex - 1);
+      }
+      if (x + 1 < width) {
+        neighbours.push_back(vertex + 1);
+      }
+      if (y > 0) {
+        neighbours.push_back(vertex - width);
+      }
+      if (y + 1 < width) {
+        neighbours.push_back(vertex + width);
+      }
+    } else {
+      for (int i = 0; i < params.edges_per_vertex; ++i) {
+        neighbours.push_back(
+            static_cast<int>((NextRandom(&random_state) >> 16) % num_vertices));
+      }
+    }
+
+    for (int to : neighbours) {
+      if (settled[to]) {
+        continue;
+      }
+      const int weight =
+          1 + static_cast<int>((NextRandom(&random_state) >> 32) %
+                               params.max_weight);
+      const int distance = min_key + weight;
+
+      trace->push_back({HeapOperation::kLookUp, to, 0});
+      local_profile.num_lookups++;
+      if (distances[to] < 0) {
+        trace->push_back({HeapOperation::kAdd, to, distance});
+        local_profile.num_adds++;
+        sum_add_gap += distance - min_key;
+        distances[to] = distance;
+        push(distance, to);
+        heap_size++;
+      } else if (distance < distances[to]) {
+        trace->push_back({HeapOperation::kReduceKey, to, distance});
+        local_profile.num_reduce_keys++;
+        sum_reduce_key_gap += distance - min_key;
+        sum_reduce_key_fraction +=
+            1.0 - static_cast<double>(distance - min_key) /
+                      (distances[to] - min_key);
+        distances[to] = distance;
+        push(distance, to);
+      }
+    }
+  }
+
+  if (profile != nullptr) {
+    local_profile.mean_heap_size = sum_heap_size / local_profile.num_pops;
+    local_profile.mean_add_gap = sum_add_gap / local_profile.num_adds;
+    if (local_profile.num_reduce_keys > 0) {
+      local_profile.mean_reduce_key_gap =
+          sum_reduce_key_gap / local_profile.num_reduce_keys;
+      local_profile.mean_reduce_key_fraction =
+          sum_reduce_key_fraction / local_profile.num_reduce_keys;
+    }
+    *profile = local_profile;
+  }
+}
+
+// Returns the name of a graph class, as used in flags.
+inline std::string DijkstraWorkloadGraphName(DijkstraWorkloadGraph graph) {
+  switch (graph) {
+  case DijkstraWorkloadGraph::kGrid:
+    return "grid";
+  case DijkstraWorkloadGraph::kRandom:
+    return "random";
+  }
+  return "";
+}
+
+#endif /* HEAPS_DIJKSTRA_WORKLOAD_H_ */
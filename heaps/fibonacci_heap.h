@@ -5,47 +5,61 @@
 #ifndef HEAPS_FIBONACCI_HEAP_H_
 #define HEAPS_FIBONACCI_HEAP_H_
 
+#include <functional>
 #include <iostream>
 #include <sstream>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/roots_by_rank.h"
 
 // A node used in Fibonnaci Heaps.
-template <typename T> class FibonacciHeapNode {
+template <typename T, typename Id = int> class FibonacciHeapNode {
 public:
-  FibonacciHeapNode(T key, int id)
-      : key_(key), id_(id), degree_(0), marked_(false), parent_(nullptr),
-        child_(nullptr), left_(this), right_(this) {}
+  FibonacciHeapNode(T key, Id id)
+      : key_(std::move(key)), id_(id), degree_(0), marked_(false),
+        parent_(nullptr), child_(nullptr), left_(this), right_(this) {}
 
   // Sentinel node.
   FibonacciHeapNode()
-      : id_(-1), degree_(0), marked_(false), parent_(nullptr), child_(nullptr),
+      : id_(), degree_(0), marked_(false), parent_(nullptr), child_(nullptr),
         left_(this), right_(this) {}
 
   const T &key() const { return key_; }
-  void set_key(T key) { key_ = key; }
+  void set_key(T key) { key_ = std::move(key); }
 
-  int id() const { return id_; }
+  // Moves the key out of the node.
+  T take_key() { return std::move(key_); }
+
+  Id id() const { return id_; }
 
   // Number of children.
   int degree() const { return degree_; }
 
-  FibonacciHeapNode<T> *parent() const { return parent_; }
+  FibonacciHeapNode<T, Id> *parent() const { return parent_; }
   void clear_parent() { parent_ = nullptr; }
 
-  FibonacciHeapNode<T> *child() const { return child_; }
+  FibonacciHeapNode<T, Id> *child() const { return child_; }
+
+  // Removes and returns the circular list of children.
+  FibonacciHeapNode<T, Id> *TakeChildren() {
+    auto *children = child_;
+    child_ = nullptr;
+    degree_ = 0;
+    return children;
+  }
 
-  FibonacciHeapNode<T> *left() const { return left_; }
-  void set_left(FibonacciHeapNode<T> *node) { left_ = node; }
+  FibonacciHeapNode<T, Id> *left() const { return left_; }
+  void set_left(FibonacciHeapNode<T, Id> *node) { left_ = node; }
 
-  FibonacciHeapNode<T> *right() const { return right_; }
-  void set_right(FibonacciHeapNode<T> *node) { right_ = node; }
+  FibonacciHeapNode<T, Id> *right() const { return right_; }
+  void set_right(FibonacciHeapNode<T, Id> *node) { right_ = node; }
 
   // Clear references to left and right siblings.
   void clear_siblings() {
@@ -59,7 +73,7 @@ public:
   void clear_mark() { marked_ = false; }
 
   // Delete the entire tree rooted at this node.
-  static void DeleteTree(FibonacciHeapNode<T> *node) {
+  static void DeleteTree(FibonacciHeapNode<T, Id> *node) {
     if (node != nullptr) {
       auto *child = node->child_;
       if (child != nullptr) {
@@ -74,13 +88,13 @@ public:
   }
 
   // Append a sibling to this node.
-  void AddSibling(FibonacciHeapNode<T> *node);
+  void AddSibling(FibonacciHeapNode<T, Id> *node);
 
   // Detach from its siblings.
   void DetachFromSiblings();
 
   // Add a child node (increasing the degree).
-  void AddChild(FibonacciHeapNode<T> *node);
+  void AddChild(FibonacciHeapNode<T, Id> *node);
 
   // Cut this node from its parents/siblings.
   void Cut();
@@ -92,13 +106,13 @@ public:
   void PrintTree(std::ostream &out, int level) const;
 
   // Validate the fields.
-  void Validate(std::unordered_set<int> *seen_ids) const;
+  void Validate(std::unordered_set<Id> *seen_ids) const;
 
 private:
   T key_;
 
-  // An int id that uniquely identifies this node.
-  int id_;
+  // An id that uniquely identifies this node.
+  Id id_;
 
   // Number of children.
   short degree_;
@@ -107,35 +121,36 @@ private:
   bool marked_;
 
   // Points to the parent node.
-  FibonacciHeapNode<T> *parent_;
+  FibonacciHeapNode<T, Id> *parent_;
 
   // Points to the first child.
-  FibonacciHeapNode<T> *child_;
+  FibonacciHeapNode<T, Id> *child_;
 
   // Points to prev sibling.
-  FibonacciHeapNode<T> *left_;
+  FibonacciHeapNode<T, Id> *left_;
 
   // Points to next sibling.
-  FibonacciHeapNode<T> *right_;
+  FibonacciHeapNode<T, Id> *right_;
 };
 
-template <typename T>
-void FibonacciHeapNode<T>::AddSibling(FibonacciHeapNode<T> *node) {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::AddSibling(FibonacciHeapNode<T, Id> *node) {
   node->left_ = left_;
   node->right_ = this;
   left_->right_ = node;
   left_ = node;
 }
 
-template <typename T> void FibonacciHeapNode<T>::DetachFromSiblings() {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::DetachFromSiblings() {
   left_->right_ = right_;
   right_->left_ = left_;
   left_ = this;
   right_ = this;
 }
 
-template <typename T>
-void FibonacciHeapNode<T>::AddChild(FibonacciHeapNode<T> *node) {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::AddChild(FibonacciHeapNode<T, Id> *node) {
   DCHECK(node->left_ == node);
   DCHECK(node->right_ == node);
   if (child_ != nullptr) {
@@ -149,7 +164,8 @@ void FibonacciHeapNode<T>::AddChild(FibonacciHeapNode<T> *node) {
   ++degree_;
 }
 
-template <typename T> void FibonacciHeapNode<T>::Cut() {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::Cut() {
   if (parent_ != nullptr) {
     if (parent_->child_ == this) {
       if (left_ == this) {
@@ -168,7 +184,8 @@ template <typename T> void FibonacciHeapNode<T>::Cut() {
   right_ = this;
 }
 
-template <typename T> std::string FibonacciHeapNode<T>::DebugString() const {
+template <typename T, typename Id>
+std::string FibonacciHeapNode<T, Id>::DebugString() const {
   std::stringstream out;
   out << key_ << " [id:" << id_ << "][deg:" << degree_ << "][marked:" << marked_
       << "]";
@@ -187,8 +204,8 @@ template <typename T> std::string FibonacciHeapNode<T>::DebugString() const {
   return out.str();
 }
 
-template <typename T>
-void FibonacciHeapNode<T>::PrintTree(std::ostream &out, int level) const {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::PrintTree(std::ostream &out, int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -203,8 +220,9 @@ void FibonacciHeapNode<T>::PrintTree(std::ostream &out, int level) const {
   }
 }
 
-template <typename T>
-void FibonacciHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
+template <typename T, typename Id>
+void FibonacciHeapNode<T, Id>::Validate(
+    std::unordered_set<Id> *seen_ids) const {
   if (seen_ids != nullptr) {
     CHECK(seen_ids->insert(id_).second);
   }
@@ -224,22 +242,26 @@ void FibonacciHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
   }
 }
 
-template <typename T> class FibonacciHeap : public Heap<T> {
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class FibonacciHeap : public Heap<T, typename Ids::Id> {
 public:
+  using Id = typename Ids::Id;
+
   FibonacciHeap() : min_root_(nullptr) {}
 
   ~FibonacciHeap() {
     auto *root = roots_.right();
     while (root != &roots_) {
       auto *next_root = root->right();
-      FibonacciHeapNode<T>::DeleteTree(root);
+      FibonacciHeapNode<T, Id>::DeleteTree(root);
       root = next_root;
     }
   }
 
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Fibonacci Heap",
-                            []() { return new FibonacciHeap<T>{}; });
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Fibonacci Heap",
+        []() { return new FibonacciHeap<T, Ids, Compare>{}; });
   }
 
   // Returns number of elements.
@@ -248,19 +270,25 @@ public:
   }
 
   // Adds an elementn with given key and unique int key.
-  virtual void Add(T key, int id) override;
+  virtual void Add(T key, Id id) override;
 
   // Updates with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the min element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out,
@@ -269,52 +297,71 @@ public:
   // Validate the invariants.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return size() * AllocationSize(sizeof(FibonacciHeapNode<T, Id>)) +
+           id_to_node_.MemoryUsage();
+  }
+
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   // Merge a root into roots_by_degree_.
-  void MergeRoot_(FibonacciHeapNode<T> *root);
+  void MergeRoot_(FibonacciHeapNode<T, Id> *root);
+
+  // Cuts a node from its parent to the roots, and cuts its marked ancestors
+  // as well.
+  void CutToRoots_(FibonacciHeapNode<T, Id> *node);
+
+  // Removes a root, consolidates the roots with its children, and returns
+  // its element.
+  HeapElement<T, Id> RemoveRoot_(FibonacciHeapNode<T, Id> *node);
 
   // Used for merging roots of the same degree.
-  std::vector<FibonacciHeapNode<T> *> roots_by_degree_;
+  RootsByRank<FibonacciHeapNode<T, Id>> roots_by_degree_;
 
   // Current root node with min key.
-  FibonacciHeapNode<T> *min_root_;
+  FibonacciHeapNode<T, Id> *min_root_;
 
   // Linked list of new root nodes.
-  FibonacciHeapNode<T> roots_;
+  FibonacciHeapNode<T, Id> roots_;
 
   // Map of each id to the node.
-  std::unordered_map<int, FibonacciHeapNode<T> *> id_to_node_;
+  typename Ids::template Index<FibonacciHeapNode<T, Id> *> id_to_node_;
 };
 
-template <typename T> void FibonacciHeap<T>::Add(T key, int id) {
-  FibonacciHeapNode<T> *node = new FibonacciHeapNode<T>{key, id};
-  CHECK(id_to_node_.emplace(id, node).second);
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::Add(T key, Id id) {
+  auto *node = new FibonacciHeapNode<T, Id>{std::move(key), id};
+  CHECK(id_to_node_.Insert(id, node));
+  this->AddStat_(&HeapStats::adds);
 
   roots_.AddSibling(node);
-  if (min_root_ == nullptr || key < min_root_->key()) {
+  if (min_root_ == nullptr || Less_(node->key(), min_root_->key())) {
     min_root_ = node;
   }
 }
 
-template <typename T>
-void FibonacciHeap<T>::MergeRoot_(FibonacciHeapNode<T> *root) {
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::MergeRoot_(
+    FibonacciHeapNode<T, Id> *root) {
   while (true) {
     int degree = root->degree();
-    if (roots_by_degree_.size() < degree + 1) {
-      roots_by_degree_.resize(degree + 1, nullptr);
-    }
-
-    auto *root2 = roots_by_degree_[degree];
+    auto *root2 = roots_by_degree_.Take(degree);
     if (root2 == nullptr) {
-      roots_by_degree_[degree] = root;
+      roots_by_degree_.Put(degree, root);
       break;
     }
 
     // Merge with existing tree of same degree. The degree will increase
     // by 1, and it may need to be merged with another tree.
-    roots_by_degree_[degree] = nullptr;
+    this->AddStat_(&HeapStats::links);
 
-    if (root->key() < root2->key()) {
+    if (Less_(root->key(), root2->key())) {
       root->AddChild(root2);
     } else {
       root2->AddChild(root);
@@ -323,25 +370,85 @@ void FibonacciHeap<T>::MergeRoot_(FibonacciHeapNode<T> *root) {
   }
 }
 
-template <typename T> void FibonacciHeap<T>::ReduceKey(T new_key, int id) {
-  auto *node = id_to_node_[id];
-  node->set_key(new_key);
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  auto *node = *id_to_node_.Find(id);
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::reduce_keys);
 
   // Make it the min_root if necessary.
-  if (new_key < min_root_->key()) {
+  if (Less_(node->key(), min_root_->key())) {
     min_root_ = node;
   }
 
   // If this is a root node, or if the new key is not smaller than its parent,
   // we're done.
   auto *parent = node->parent();
-  if (parent == nullptr || !(new_key < parent->key())) {
+  if (parent == nullptr || !Less_(node->key(), parent->key())) {
     return;
   }
+  CutToRoots_(node);
+}
 
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  FibonacciHeapNode<T, Id> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  CHECK(!Less_(new_key, node->key()));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Move the node and its children to the
+  // roots.
+  if (node->parent() != nullptr) {
+    CutToRoots_(node);
+  }
+  auto *first_child = node->TakeChildren();
+  if (first_child != nullptr) {
+    auto *child = first_child;
+    do {
+      auto *next = child->right();
+      child->clear_parent();
+      child->clear_mark();
+      child->clear_siblings();
+      roots_.AddSibling(child);
+      this->AddStat_(&HeapStats::cuts);
+      child = next;
+    } while (child != first_child);
+  }
+
+  // Find the new minimum if it was the minimum.
+  if (node == min_root_) {
+    for (auto *root = roots_.right(); root != &roots_; root = root->right()) {
+      if (Less_(root->key(), min_root_->key())) {
+        min_root_ = root;
+      }
+    }
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::Remove(Id id) {
+  FibonacciHeapNode<T, Id> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  this->AddStat_(&HeapStats::removes);
+
+  if (node->parent() != nullptr) {
+    CutToRoots_(node);
+  }
+  RemoveRoot_(node);
+}
+
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::CutToRoots_(
+    FibonacciHeapNode<T, Id> *node) {
   // Cut the node from its parent.
+  auto *parent = node->parent();
   node->Cut();
   roots_.AddSibling(node);
+  this->AddStat_(&HeapStats::cuts);
 
   // If the parent has previously cut its child before, it needs to be cut
   // as well.
@@ -356,33 +463,45 @@ template <typename T> void FibonacciHeap<T>::ReduceKey(T new_key, int id) {
     auto *next_parent = parent->parent();
     parent->Cut();
     roots_.AddSibling(parent);
+    this->AddStat_(&HeapStats::cascading_cuts);
     parent = next_parent;
   } while (parent != nullptr);
 }
 
-template <typename T> const T *FibonacciHeap<T>::LookUp(int id) const {
-  const auto it = id_to_node_.find(id);
-  if (it == id_to_node_.end()) {
+template <typename T, typename Ids, typename Compare>
+const T *FibonacciHeap<T, Ids, Compare>::LookUp(Id id) const {
+  auto *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
     return nullptr;
   }
-  return &it->second->key();
+  return &(*node)->key();
 }
 
-template <typename T> HeapElement<T> FibonacciHeap<T>::Min() const {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> FibonacciHeap<T, Ids, Compare>::Min() const {
   DCHECK(size() > 0);
   return std::make_pair(min_root_->key(), min_root_->id());
 }
 
-template <typename T> HeapElement<T> FibonacciHeap<T>::PopMinimum() {
-  auto result = std::make_pair(min_root_->key(), min_root_->id());
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> FibonacciHeap<T, Ids, Compare>::PopMinimum() {
+  this->AddStat_(&HeapStats::pops);
+  return RemoveRoot_(min_root_);
+}
 
-  // Detach the min root.
-  auto *child = min_root_->child();
-  min_root_->Cut();
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+FibonacciHeap<T, Ids, Compare>::RemoveRoot_(FibonacciHeapNode<T, Id> *node) {
+  auto result = std::make_pair(node->take_key(), node->id());
+  this->AddStat_(&HeapStats::consolidations);
+
+  // Detach the root.
+  auto *child = node->child();
+  node->Cut();
 
   // Clean up
-  id_to_node_.erase(min_root_->id());
-  delete min_root_;
+  id_to_node_.Erase(node->id());
+  delete node;
 
   // Merge new roots into roots_by_degree_.
   auto *root = roots_.right();
@@ -394,7 +513,7 @@ template <typename T> HeapElement<T> FibonacciHeap<T>::PopMinimum() {
   }
   roots_.clear_siblings();
 
-  // Merge children of min_root into roots_by_degree_;.
+  // Merge children of the root into roots_by_degree_;.
   if (child != nullptr) {
     root = child;
     do {
@@ -408,29 +527,27 @@ template <typename T> HeapElement<T> FibonacciHeap<T>::PopMinimum() {
 
   // Find the new minimum among the roots_by_degree_.
   min_root_ = nullptr;
-  for (auto *root : roots_by_degree_) {
-    if (root != nullptr) {
-      DCHECK(root->parent() == nullptr);
-      roots_.AddSibling(root);
+  while (!roots_by_degree_.empty()) {
+    auto *root = roots_by_degree_.PopLowest();
+    DCHECK(root->parent() == nullptr);
+    roots_.AddSibling(root);
 
-      if (min_root_ == nullptr || root->key() < min_root_->key()) {
-        min_root_ = root;
-      }
+    if (min_root_ == nullptr || Less_(root->key(), min_root_->key())) {
+      min_root_ = root;
     }
   }
-  roots_by_degree_.clear();
 
   return result;
 }
 
-template <typename T>
-void FibonacciHeap<T>::PrintTree(std::ostream &out,
-                                 const std::string &label) const {
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::PrintTree(std::ostream &out,
+                                               const std::string &label) const {
   out << "-- Heap (" << size() << ") " << label << " --" << std::endl;
   if (min_root_ != nullptr) {
     out << "min:" << min_root_->DebugString() << std::endl;
   }
-  for (int i = 0; i < roots_by_degree_.size(); i++) {
+  for (int i = 0; i < RootsByRank<FibonacciHeapNode<T, Id>>::kMaxRanks; i++) {
     if (roots_by_degree_[i] != nullptr) {
       out << "Deg(" << i << "):" << std::endl;
       roots_by_degree_[i]->PrintTree(out, 1);
@@ -448,7 +565,33 @@ void FibonacciHeap<T>::PrintTree(std::ostream &out,
   out << std::endl;
 }
 
-template <typename T> void FibonacciHeap<T>::Validate() const {
+template <typename T, typename Ids, typename Compare>
+HeapStats FibonacciHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  std::vector<std::pair<const FibonacciHeapNode<T, Id> *, int>> stack;
+  for (const auto *root = roots_.right(); root != &roots_;
+       root = root->right()) {
+    stats.num_trees++;
+    stack.emplace_back(root, 1);
+  }
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    stats.max_height = std::max(stats.max_height, entry.second);
+    const auto *first_child = entry.first->child();
+    if (first_child != nullptr) {
+      const auto *child = first_child;
+      do {
+        stack.emplace_back(child, entry.second + 1);
+        child = child->right();
+      } while (child != first_child);
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FibonacciHeap<T, Ids, Compare>::Validate() const {
   if (size() == 0) {
     CHECK(min_root_ == nullptr);
     CHECK(roots_.right() == &roots_);
@@ -458,19 +601,15 @@ template <typename T> void FibonacciHeap<T>::Validate() const {
 
   CHECK(roots_by_degree_.empty());
 
-  std::unordered_set<int> seen_ids;
+  std::unordered_set<Id> seen_ids;
   for (const auto *root = roots_.right(); root != &roots_;
        root = root->right()) {
     root->Validate(&seen_ids);
   }
 
-  if (seen_ids.size() != size()) {
-    for (const auto &entry : id_to_node_) {
-      if (seen_ids.find(entry.first) == seen_ids.end()) {
-        LOG(ERROR) << "Id not seen: " << entry.first;
-      }
-    }
-    LOG(FATAL) << "Some ids are missing";
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
   }
 }
 
@@ -0,0 +1,696 @@
+// Flat 2-3 Heap.
+//
+// A 2-3 Heap with the same trees as TwoThreeHeap, in a simpler layout. Each
+// trunk of one or two trees is an object of its own that holds the roots of
+// its trees in two inline slots, ordered by key. A trunk keeps its place in
+// the heap while trees move in and out of its slots, so there are no partner
+// links, sentinel nodes or primary/secondary swaps. Nodes and trunks come
+// from NodeArenas.
+
+#ifndef HEAPS_FLAT_TWO_THREE_HEAP_H_
+#define HEAPS_FLAT_TWO_THREE_HEAP_H_
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/node_arena.h"
+
+template <typename T, typename Id> struct FlatTwoThreeTrunk;
+
+// A node used in Flat 2-3 Heaps. Its dimension is the dimension of the trunk
+// that holds it.
+template <typename T, typename Id = int> struct FlatTwoThreeNode {
+  FlatTwoThreeNode(T key, Id id)
+      : key(std::move(key)), id(id), trunk(nullptr), child(nullptr) {}
+
+  T key;
+
+  // An id that uniquely identifies this node.
+  Id id;
+
+  // The trunk that holds this node.
+  FlatTwoThreeTrunk<T, Id> *trunk;
+
+  // The child trunk of the highest dimension, or nullptr if the node has
+  // dimension 0. The others follow through the `lower` links, down to
+  // dimension 0.
+  FlatTwoThreeTrunk<T, Id> *child;
+};
+
+// A trunk of one or two trees of the same dimension.
+template <typename T, typename Id = int> struct FlatTwoThreeTrunk {
+  explicit FlatTwoThreeTrunk(int dimension)
+      : nodes{nullptr, nullptr}, size(0), dimension(dimension),
+        parent(nullptr), higher(nullptr), lower(nullptr) {}
+
+  // The roots of the trees, with nodes[0] the smaller. nodes[1] is only set
+  // if size is 2.
+  FlatTwoThreeNode<T, Id> *nodes[2];
+
+  // The number of trees, 1 or 2. It is 0 only while the trunk is being
+  // refilled.
+  int8_t size;
+
+  // The dimension of the trees.
+  int8_t dimension;
+
+  // The node that this trunk is a child of, or nullptr for a root trunk.
+  FlatTwoThreeNode<T, Id> *parent;
+
+  // The sibling trunks of one dimension higher and lower, under the same
+  // parent.
+  FlatTwoThreeTrunk<T, Id> *higher;
+  FlatTwoThreeTrunk<T, Id> *lower;
+};
+
+// 2-3 Heap with flattened trunks. Same bounds as TwoThreeHeap: O(log n)
+// amortized PopMinimum, and O(1) amortized ReduceKey.
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class FlatTwoThreeHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  // A factory for this heap.
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>("Flat 2-3 Heap", []() {
+      return new FlatTwoThreeHeap<T, Ids, Compare>();
+    });
+  }
+
+  FlatTwoThreeHeap() : roots_{}, root_dims_(0) {}
+
+  virtual ~FlatTwoThreeHeap();
+
+  // Number of nodes in the heap.
+  virtual int size() const override { return nodes_.size(); }
+
+  // Add an element with the given key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Returns the element as a (key, id) pair.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Remove the min element and return its (key, id).
+  // Amortized code: O(log n).
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Decrease the key of a node.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Increase the key of a node.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Remove a node by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Print the heap in tree format.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override;
+
+  // Validate the structure of the heap.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return nodes_.MemoryUsage() + trunks_.MemoryUsage() +
+           id_to_node_.MemoryUsage();
+  }
+
+private:
+  using Node = FlatTwoThreeNode<T, Id>;
+  using Trunk = FlatTwoThreeTrunk<T, Id>;
+
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Returns the node with the min key.
+  Node *Min_() const;
+
+  // Returns a new trunk of the given dimension that holds only `node`.
+  Trunk *NewTrunk_(int dimension, Node *node);
+
+  // Puts a node in a slot of a trunk.
+  static void Put_(Trunk *trunk, int slot, Node *node) {
+    trunk->nodes[slot] = node;
+    node->trunk = trunk;
+  }
+
+  // Adds a node to a trunk with one tree, in key order.
+  static void AddToTrunk_(Trunk *trunk, Node *node);
+
+  // Removes a node from a trunk with two trees.
+  static void RemoveFromTrunk_(Node *node);
+
+  // Makes `child` the highest dimension child trunk of `node`.
+  static void LinkChild_(Node *node, Trunk *child);
+
+  // Detaches and returns the highest dimension child trunk of `node`.
+  static Trunk *UnlinkChild_(Node *node);
+
+  // Inserts a trunk as a root, merging it with the root of the same
+  // dimension.
+  void InsertRoot_(Trunk *trunk);
+
+  // Removes a node and its subtree from the heap.
+  void Cut_(Node *node);
+
+  // Refills an empty trunk by moving trees from its higher sibling, or
+  // removes it if it has none.
+  void FillTrunk_(Trunk *trunk);
+
+  // Detach the children of a node, and insert them as roots.
+  void InsertChildren_(Node *node);
+
+  // Validates a trunk and the trees under it.
+  void ValidateTrunk_(const Trunk *trunk,
+                      std::unordered_set<Id> *seen_ids) const;
+
+  // Print out a trunk and its trees, indented by level.
+  void PrintTrunk_(std::ostream &out, const Trunk *trunk, int level) const;
+
+  // Sets the root trunk for its dimension.
+  void SetRoot_(Trunk *trunk) {
+    roots_[trunk->dimension] = trunk;
+    root_dims_ |= uint32_t{1} << trunk->dimension;
+  }
+
+  // Remove the root for the given dimension.
+  void ClearRoot_(int dim) {
+    roots_[dim] = nullptr;
+    root_dims_ &= ~(uint32_t{1} << dim);
+  }
+
+  // A tree of dimension d has at least 2^d nodes, so with int sizes,
+  // dimensions are below 31.
+  static const int kMaxDimensions = 32;
+
+  // The root trunk of each dimension, or nullptr.
+  Trunk *roots_[kMaxDimensions];
+
+  // Bit d is set if there is a root of dimension d.
+  uint32_t root_dims_;
+
+  NodeArena<Node> nodes_;
+  NodeArena<Trunk> trunks_;
+
+  // Map of each id to the node.
+  typename Ids::template Index<Node *> id_to_node_;
+};
+
+template <typename T, typename Ids, typename Compare>
+FlatTwoThreeHeap<T, Ids, Compare>::~FlatTwoThreeHeap() {
+  // Walk the trees to delete the nodes, as the id index may not list them.
+  std::vector<Trunk *> stack;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    if (roots_[i] != nullptr) {
+      stack.push_back(roots_[i]);
+    }
+  }
+  while (!stack.empty()) {
+    Trunk *trunk = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < trunk->size; ++i) {
+      Node *node = trunk->nodes[i];
+      for (Trunk *child = node->child; child != nullptr;
+           child = child->lower) {
+        stack.push_back(child);
+      }
+      nodes_.Delete(node);
+    }
+    trunks_.Delete(trunk);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::Add(T key, Id id) {
+  Node *node = nodes_.New(std::move(key), id);
+  CHECK(id_to_node_.Insert(id, node));
+  InsertRoot_(NewTrunk_(0, node));
+  this->AddStat_(&HeapStats::adds);
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+FlatTwoThreeHeap<T, Ids, Compare>::Min() const {
+  const Node *min_node = Min_();
+  return std::make_pair(min_node->key, min_node->id);
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+FlatTwoThreeHeap<T, Ids, Compare>::PopMinimum() {
+  DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  this->AddStat_(&HeapStats::consolidations);
+
+  Node *min_node = Min_();
+  Trunk *trunk = min_node->trunk;
+  if (trunk->size == 2) {
+    RemoveFromTrunk_(min_node);
+  } else {
+    ClearRoot_(trunk->dimension);
+    trunks_.Delete(trunk);
+  }
+  InsertChildren_(min_node);
+
+  auto result = std::make_pair(std::move(min_node->key), min_node->id);
+  id_to_node_.Erase(min_node->id);
+  nodes_.Delete(min_node);
+  return result;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  Node *node = *id_to_node_.Find(id);
+  node->key = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+
+  // If the node is still below its parent, it may only need to move to the
+  // first slot of its trunk.
+  Trunk *trunk = node->trunk;
+  if (trunk->parent == nullptr || !Less_(node->key, trunk->parent->key)) {
+    if (trunk->size == 2 && trunk->nodes[1] == node &&
+        Less_(node->key, trunk->nodes[0]->key)) {
+      trunk->nodes[1] = trunk->nodes[0];
+      trunk->nodes[0] = node;
+    }
+    return;
+  }
+
+  // Cut the subtree and re-insert it as a root.
+  this->AddStat_(&HeapStats::cuts);
+  const int dimension = trunk->dimension;
+  Cut_(node);
+  InsertRoot_(NewTrunk_(dimension, node));
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  Node **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  Node *node = *found;
+  CHECK(!Less_(new_key, node->key));
+  node->key = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Cut the node, re-insert its children,
+  // and re-insert it alone.
+  this->AddStat_(&HeapStats::cuts);
+  Cut_(node);
+  InsertChildren_(node);
+  InsertRoot_(NewTrunk_(0, node));
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::Remove(Id id) {
+  Node **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  Node *node = *found;
+  id_to_node_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Cut the node, and re-insert its children.
+  this->AddStat_(&HeapStats::cuts);
+  Cut_(node);
+  InsertChildren_(node);
+  nodes_.Delete(node);
+}
+
+template <typename T, typename Ids, typename Compare>
+const T *FlatTwoThreeHeap<T, Ids, Compare>::LookUp(Id id) const {
+  Node *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
+    return nullptr;
+  }
+  return &(*node)->key;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << std::endl
+      << "-- Heap (" << size() << ") " << label << " --" << std::endl;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    if (roots_[i] != nullptr) {
+      out << "Tree #" << i << std::endl;
+      PrintTrunk_(out, roots_[i], 1);
+    }
+  }
+  out << std::endl;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::PrintTrunk_(std::ostream &out,
+                                                    const Trunk *trunk,
+                                                    int level) const {
+  for (int i = 0; i < trunk->size; ++i) {
+    const Node *node = trunk->nodes[i];
+    for (int j = 0; j < level; ++j) {
+      out << "| ";
+    }
+    out << node->key << " [id:" << node->id << "][dim:"
+        << static_cast<int>(trunk->dimension) << "]"
+        << (i == 1 ? "[2nd]" : "") << std::endl;
+    for (const Trunk *child = node->child; child != nullptr;
+         child = child->lower) {
+      PrintTrunk_(out, child, level + 1);
+    }
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::Validate() const {
+  std::unordered_set<Id> seen_ids;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    const Trunk *root = roots_[i];
+    CHECK(((root_dims_ >> i) & 1) == (root != nullptr));
+    if (root != nullptr) {
+      CHECK(root->dimension == i);
+      CHECK(root->parent == nullptr);
+      CHECK(root->higher == nullptr);
+      CHECK(root->lower == nullptr);
+      ValidateTrunk_(root, &seen_ids);
+    }
+  }
+
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::ValidateTrunk_(
+    const Trunk *trunk, std::unordered_set<Id> *seen_ids) const {
+  CHECK(trunk->size == 1 || trunk->size == 2);
+  if (trunk->size == 2) {
+    CHECK(!Less_(trunk->nodes[1]->key, trunk->nodes[0]->key));
+  } else {
+    CHECK(trunk->nodes[1] == nullptr);
+  }
+
+  for (int i = 0; i < trunk->size; ++i) {
+    const Node *node = trunk->nodes[i];
+    CHECK(node->trunk == trunk);
+    CHECK(seen_ids->insert(node->id).second);
+
+    // The children have dimensions dimension - 1 down to 0.
+    int child_dim = trunk->dimension - 1;
+    const Trunk *higher = nullptr;
+    for (const Trunk *child = node->child; child != nullptr;
+         child = child->lower) {
+      CHECK(child->dimension == child_dim);
+      CHECK(child->parent == node);
+      CHECK(child->higher == higher);
+      CHECK(!Less_(child->nodes[0]->key, node->key));
+      ValidateTrunk_(child, seen_ids);
+      higher = child;
+      child_dim--;
+    }
+    CHECK(child_dim == -1);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats FlatTwoThreeHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  std::vector<std::pair<const Trunk *, int>> stack;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    if (roots_[i] != nullptr) {
+      stats.num_trees++;
+      stack.emplace_back(roots_[i], 1);
+    }
+  }
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    const Trunk *trunk = entry.first;
+
+    // The second tree of a trunk hangs one level below the first.
+    stats.max_height =
+        std::max(stats.max_height, entry.second + trunk->size - 1);
+    for (int i = 0; i < trunk->size; ++i) {
+      for (const Trunk *child = trunk->nodes[i]->child; child != nullptr;
+           child = child->lower) {
+        stack.emplace_back(child, entry.second + i + 1);
+      }
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+FlatTwoThreeNode<T, typename Ids::Id> *
+FlatTwoThreeHeap<T, Ids, Compare>::Min_() const {
+  DCHECK(size() > 0);
+
+  // Find the min amongst the first slots of the root trunks.
+  uint32_t dims = root_dims_;
+  Node *min_node = roots_[__builtin_ctz(dims)]->nodes[0];
+  dims &= dims - 1;
+  while (dims != 0) {
+    Node *root = roots_[__builtin_ctz(dims)]->nodes[0];
+    dims &= dims - 1;
+    if (Less_(root->key, min_node->key)) {
+      min_node = root;
+    }
+  }
+  return min_node;
+}
+
+template <typename T, typename Ids, typename Compare>
+FlatTwoThreeTrunk<T, typename Ids::Id> *
+FlatTwoThreeHeap<T, Ids, Compare>::NewTrunk_(int dimension, Node *node) {
+  Trunk *trunk = trunks_.New(dimension);
+  Put_(trunk, 0, node);
+  trunk->size = 1;
+  return trunk;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::AddToTrunk_(Trunk *trunk, Node *node) {
+  DCHECK(trunk->size == 1);
+  if (Less_(node->key, trunk->nodes[0]->key)) {
+    Put_(trunk, 1, trunk->nodes[0]);
+    Put_(trunk, 0, node);
+  } else {
+    Put_(trunk, 1, node);
+  }
+  trunk->size = 2;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::RemoveFromTrunk_(Node *node) {
+  Trunk *trunk = node->trunk;
+  DCHECK(trunk->size == 2);
+  if (trunk->nodes[0] == node) {
+    trunk->nodes[0] = trunk->nodes[1];
+  }
+  trunk->nodes[1] = nullptr;
+  trunk->size = 1;
+  node->trunk = nullptr;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::LinkChild_(Node *node, Trunk *child) {
+  child->parent = node;
+  child->higher = nullptr;
+  child->lower = node->child;
+  if (node->child != nullptr) {
+    node->child->higher = child;
+  }
+  node->child = child;
+}
+
+template <typename T, typename Ids, typename Compare>
+FlatTwoThreeTrunk<T, typename Ids::Id> *
+FlatTwoThreeHeap<T, Ids, Compare>::UnlinkChild_(Node *node) {
+  Trunk *child = node->child;
+  node->child = child->lower;
+  if (child->lower != nullptr) {
+    child->lower->higher = nullptr;
+  }
+  child->parent = nullptr;
+  child->lower = nullptr;
+  return child;
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::InsertRoot_(Trunk *trunk) {
+  DCHECK(trunk->parent == nullptr);
+
+  while (true) {
+    const int dim = trunk->dimension;
+    Trunk *root = roots_[dim];
+    if (root == nullptr) {
+      SetRoot_(trunk);
+      return;
+    }
+    this->AddStat_(&HeapStats::links);
+
+    // Make `root` the trunk with the smallest node.
+    if (Less_(trunk->nodes[0]->key, root->nodes[0]->key)) {
+      std::swap(root, trunk);
+    }
+    Node *min_node = root->nodes[0];
+
+    // Two trees make one trunk.
+    if (root->size + trunk->size == 2) {
+      Put_(root, 1, trunk->nodes[0]);
+      root->size = 2;
+      trunks_.Delete(trunk);
+      roots_[dim] = root;
+      return;
+    }
+
+    // Otherwise the two trees after the smallest one become its child trunk,
+    // and it carries to the next dimension. If there are four trees, the
+    // second one stays as the root.
+    if (root->size == 2) {
+      Node *second = root->nodes[1];
+      root->nodes[1] = nullptr;
+      root->size = 1;
+      if (trunk->size == 1) {
+        AddToTrunk_(trunk, second);
+        ClearRoot_(dim);
+      } else {
+        roots_[dim] = NewTrunk_(dim, second);
+      }
+    } else {
+      ClearRoot_(dim);
+    }
+    LinkChild_(min_node, trunk);
+    root->dimension++;
+    trunk = root;
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::Cut_(Node *node) {
+  Trunk *trunk = node->trunk;
+  if (trunk->size == 2) {
+    RemoveFromTrunk_(node);
+    return;
+  }
+  trunk->nodes[0] = nullptr;
+  trunk->size = 0;
+  node->trunk = nullptr;
+  FillTrunk_(trunk);
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::FillTrunk_(Trunk *trunk) {
+  DCHECK(trunk->size == 0);
+  const int dim = trunk->dimension;
+  Node *parent = trunk->parent;
+  if (parent == nullptr) {
+    ClearRoot_(dim);
+    trunks_.Delete(trunk);
+    return;
+  }
+
+  // The parent loses its highest dimension, so it no longer fits in its own
+  // trunk. Take it out, and re-insert it as a root in this trunk.
+  Trunk *higher = trunk->higher;
+  if (higher == nullptr) {
+    this->AddStat_(&HeapStats::cascading_cuts);
+    UnlinkChild_(parent);
+    Trunk *parent_trunk = parent->trunk;
+    if (parent_trunk->size == 2) {
+      RemoveFromTrunk_(parent);
+    } else {
+      parent_trunk->nodes[0] = nullptr;
+      parent_trunk->size = 0;
+      FillTrunk_(parent_trunk);
+    }
+    Put_(trunk, 0, parent);
+    trunk->size = 1;
+    InsertRoot_(trunk);
+    return;
+  }
+
+  // Move trees down from the higher sibling trunk.
+  Node *first = higher->nodes[0];
+  Node *second = higher->nodes[1];
+  Trunk *first_child = first->child;
+  if (first_child->size == 2) {
+    // [first, second] -> [first_child[0], second] with first_child[1] as a
+    // new child of first_child[0], and first fills the trunk.
+    Node *grandchild = first_child->nodes[0];
+    UnlinkChild_(first);
+    Put_(first_child, 0, first_child->nodes[1]);
+    first_child->nodes[1] = nullptr;
+    first_child->size = 1;
+    LinkChild_(grandchild, first_child);
+    Put_(trunk, 0, first);
+    trunk->size = 1;
+    higher->size = 1;
+    higher->nodes[1] = nullptr;
+    Put_(higher, 0, grandchild);
+    if (second != nullptr) {
+      AddToTrunk_(higher, second);
+    }
+    return;
+  }
+
+  if (second != nullptr) {
+    Trunk *second_child = UnlinkChild_(second);
+    if (second_child->size == 2) {
+      // [first, second] -> [first, second_child[0]] with second_child[1] as
+      // a new child of second_child[0], and second fills the trunk.
+      Node *grandchild = second_child->nodes[0];
+      Put_(second_child, 0, second_child->nodes[1]);
+      second_child->nodes[1] = nullptr;
+      second_child->size = 1;
+      LinkChild_(grandchild, second_child);
+      Put_(higher, 1, grandchild);
+      Put_(trunk, 0, second);
+      trunk->size = 1;
+    } else {
+      // [first, second] -> [first], and [second, second_child[0]] fills the
+      // trunk.
+      Put_(trunk, 0, second);
+      Put_(trunk, 1, second_child->nodes[0]);
+      trunk->size = 2;
+      trunks_.Delete(second_child);
+      higher->nodes[1] = nullptr;
+      higher->size = 1;
+    }
+    return;
+  }
+
+  // [first] with a single child: [first, first_child[0]] fills the trunk,
+  // and the higher trunk becomes empty in turn.
+  UnlinkChild_(first);
+  Put_(trunk, 0, first);
+  Put_(trunk, 1, first_child->nodes[0]);
+  trunk->size = 2;
+  trunks_.Delete(first_child);
+  higher->nodes[0] = nullptr;
+  higher->size = 0;
+  FillTrunk_(higher);
+}
+
+template <typename T, typename Ids, typename Compare>
+void FlatTwoThreeHeap<T, Ids, Compare>::InsertChildren_(Node *node) {
+  while (node->child != nullptr) {
+    InsertRoot_(UnlinkChild_(node));
+  }
+}
+
+#endif /* HEAPS_FLAT_TWO_THREE_HEAP_H_ */
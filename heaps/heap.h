@@ -5,13 +5,15 @@
 
 #include <utility>
 
-// An element in a Heap. Each elements consists of a T key and an unique int
-// identifier.
-template <typename T> using HeapElement = std::pair<T, int>;
+#include "heaps/heap_stats.h"
+
+// An element in a Heap. Each elements consists of a T key and an unique
+// identifier, an int unless given another type.
+template <typename T, typename Id = int> using HeapElement = std::pair<T, Id>;
 
 // Base class for a Heap data structure.
 // Implementations should implement these virtual methods
-template <typename T> class Heap {
+template <typename T, typename Id = int> class Heap {
 public:
   virtual ~Heap() {}
 
@@ -21,28 +23,60 @@ public:
   // Returns true if it's empty.
   bool empty() const;
 
-  // Adds an element with the given key and unique id.
-  virtual void Add(T key, int id) = 0;
+  // Adds an element with the given key and unique id. The heaps move the
+  // key into place, so an rvalue key is never copied.
+  virtual void Add(T key, Id id) = 0;
+
+  // Adds an element with a key constructed from `args`, and unique id.
+  template <typename... Args> void Emplace(Id id, Args &&...args) {
+    Add(T(std::forward<Args>(args)...), id);
+  }
+
+  // Updates an element with a lower key, which is moved into place.
+  virtual void ReduceKey(T new_key, Id id) = 0;
+
+  // Updates an element with a higher key, which is moved into place.
+  virtual void IncreaseKey(T new_key, Id id) = 0;
 
-  // Updates an element with a lower key.
-  virtual void ReduceKey(T new_key, int id) = 0;
+  // Removes the element with the given id, which must be in the heap.
+  virtual void Remove(Id id) = 0;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const = 0;
+  virtual const T *LookUp(Id id) const = 0;
 
   // Returns the min element.
-  virtual HeapElement<T> Min() const = 0;
+  virtual HeapElement<T, Id> Min() const = 0;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() = 0;
+  virtual HeapElement<T, Id> PopMinimum() = 0;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out, const std::string &label) const = 0;
 
   // Validate the invariants.
   virtual void Validate() const = 0;
+
+  // Returns the operation counters, and the current shape of the heap.
+  // The counters are zero unless built with HEAPS_ENABLE_STATS.
+  virtual HeapStats Stats() const { return stats_; }
+
+  // Returns the approximate bytes of memory allocated by the heap: its nodes
+  // or arrays, and its id index. Excludes the heap object itself.
+  virtual long MemoryUsage() const = 0;
+
+protected:
+  // Adds `count` to a counter in `stats_`, if stats are enabled.
+  void AddStat_(long HeapStats::*counter, long count = 1) {
+    if (kEnableHeapStats) {
+      stats_.*counter += count;
+    }
+  }
+
+  HeapStats stats_;
 };
 
-template <typename T> bool Heap<T>::empty() const { return size() == 0; }
+template <typename T, typename Id> bool Heap<T, Id>::empty() const {
+  return size() == 0;
+}
 
 #endif /* HEAPS_HEAP_H_ */
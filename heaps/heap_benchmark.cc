@@ -0,0 +1,570 @@
+// Sweeps the cost of heap operations across heap sizes, key distributions and
+// operation mixes, to find where each heap falls out of cache and where the
+// heaps cross over.
+//
+// Each point of the sweep is repeated until its run time converges. The
+// results are written as one row per point with --output_plot_data, and in
+// the PerfReport formats with --output_json and --output_csv.
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/check.h"
+#include "absl/log/flags.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/strings/str_split.h"
+
+#include "base/cpu_affinity.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "base/perf.h"
+#include "base/perf_report.h"
+#include "base/statistics.h"
+#include "heaps/adaptive_heap.h"
+#include "heaps/b_heap.h"
+#include "heaps/binary_heap.h"
+#include "heaps/binomial_heap.h"
+#include "heaps/compact_pairing_heap.h"
+#include "heaps/compact_weak_heap.h"
+#include "heaps/dary_heap.h"
+#include "heaps/fibonacci_heap.h"
+#include "heaps/flat_two_three_heap.h"
+#include "heaps/indirect_binomial_heap.h"
+#include "heaps/pairing_heap.h"
+#include "heaps/thin_heap.h"
+#include "heaps/two_three_heap.h"
+#include "heaps/weak_heap.h"
+
+ABSL_FLAG(std::string, heaps,
+          "adaptive_heap,b_heap,binary_heap,binary_heap_bottom_up,"
+          "binomial_heap,compact_pairing_heap,compact_weak_heap,dary_heap_4,"
+          "dary_heap_8,dary_heap_16,fibonacci_heap,flat_two_three_heap,"
+          "indirect_binomial_heap,lazy_binomial_heap,pairing_heap,thin_heap,"
+          "two_three_heap,weak_heap",
+          "comma separated heaps to benchmark; pairing_heap_auxiliary, "
+          "pairing_heap_back_to_front, pairing_heap_front_to_back and "
+          "pairing_heap_multipass are also available");
+ABSL_FLAG(std::string, mixes, "add_pop,pop_add,pop_add_reduce_key",
+          "comma separated subset of {add_pop, pop_add, pop_add_reduce_key}");
+ABSL_FLAG(std::string, distributions, "uniform,sorted,zipf,dijkstra",
+          "comma separated subset of {uniform, sorted, zipf, dijkstra}");
+ABSL_FLAG(int, min_size, 100, "smallest heap size");
+ABSL_FLAG(int, max_size, 100000000, "largest heap size");
+ABSL_FLAG(int, sizes_per_decade, 1,
+          "heap sizes per factor of 10, evenly spaced on a log scale");
+ABSL_FLAG(int, ops_per_run, 1000000, "operations in each timed run");
+ABSL_FLAG(int, min_runs, 5, "fewest runs of each point");
+ABSL_FLAG(int, max_runs, 30, "most runs of each point");
+ABSL_FLAG(double, max_relative_error, 0.02,
+          "repeat runs until the standard error of the mean run time is "
+          "below this fraction of the mean");
+ABSL_FLAG(double, max_seconds_per_point, 10,
+          "stop repeating a point after this many seconds");
+ABSL_FLAG(double, max_memory_fraction, 0.5,
+          "skip points estimated to need more than this fraction of the "
+          "physical memory");
+ABSL_FLAG(bool, pin_cpu, true, "pin the benchmark to one CPU");
+ABSL_FLAG(int, cpu, -1, "CPU to pin to; -1 for the CPU it starts on");
+ABSL_FLAG(std::string, output_plot_data, "",
+          "if set, write one CSV row per point to this file");
+ABSL_FLAG(std::string, output_json, "",
+          "if set, write the results as JSON to this file");
+ABSL_FLAG(std::string, output_csv, "",
+          "if set, write the results as CSV to this file");
+
+namespace {
+
+// How the keys that are added to the heap are distributed.
+enum class KeyDistribution {
+  // Uniformly random.
+  kUniform,
+  // Increasing, so each added key is the largest.
+  kSorted,
+  // Zipf distributed with exponent 1, so small keys repeat often.
+  kZipf,
+  // Each added key is the last popped key plus a random increment, and keys
+  // are reduced towards the last popped key, as in Dijkstra's algorithm.
+  kDijkstra,
+};
+
+const std::map<std::string, KeyDistribution> kKeyDistributions{
+    {"uniform", KeyDistribution::kUniform},
+    {"sorted", KeyDistribution::kSorted},
+    {"zipf", KeyDistribution::kZipf},
+    {"dijkstra", KeyDistribution::kDijkstra}};
+
+// Returns 2^16 Zipf distributed samples over the ranks 1 to 2^20.
+const std::vector<int> &ZipfSamples() {
+  static const std::vector<int> *samples = []() {
+    const int num_ranks = 1 << 20;
+    std::vector<double> cdf(num_ranks);
+    double sum = 0;
+    for (int rank = 1; rank <= num_ranks; ++rank) {
+      sum += 1.0 / rank;
+      cdf[rank - 1] = sum;
+    }
+
+    auto *samples = new std::vector<int>(1 << 16);
+    std::srand(12345);
+    for (int &sample : *samples) {
+      double u = static_cast<double>(std::rand()) / RAND_MAX * sum;
+      sample = static_cast<int>(
+          std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin() + 1);
+    }
+    return samples;
+  }();
+  return *samples;
+}
+
+// Generates keys in a distribution. Cheap enough to run inside the timed
+// loop, so the keys don't need to be stored.
+class KeyGenerator {
+public:
+  KeyGenerator(KeyDistribution distribution, uint64_t seed)
+      : distribution_(distribution), state_(seed | 1), next_sorted_key_(0),
+        zipf_samples_(ZipfSamples()) {}
+
+  // Returns the next key to add. `min_key` is the last popped key.
+  int Next(int min_key) {
+    switch (distribution_) {
+    case KeyDistribution::kUniform:
+      return static_cast<int>(NextRandom_() & 0x3fffffff);
+    case KeyDistribution::kSorted:
+      return next_sorted_key_++;
+    case KeyDistribution::kZipf:
+      return zipf_samples_[NextRandom_() & 0xffff];
+    case KeyDistribution::kDijkstra:
+      return min_key + static_cast<int>(NextRandom_() & 0xffff);
+    }
+    return 0;
+  }
+
+  // Returns a new key, not above `key`, for ReduceKey. `min_key` is the last
+  // popped key.
+  int Reduce(int key, int min_key) {
+    if (distribution_ == KeyDistribution::kDijkstra) {
+      // Closer to the last popped key, but not below it.
+      if (key <= min_key) {
+        return key;
+      }
+      return min_key +
+             static_cast<int>((key - min_key) * (NextRandom_() & 0xff) / 256);
+    }
+    return key - static_cast<int>(NextRandom_() % (key / 4 + 1));
+  }
+
+  // Returns true with the given probability.
+  bool Bernoulli(double probability) {
+    return (NextRandom_() & 0xffffff) < probability * 0x1000000;
+  }
+
+  // Returns a random index below `n`.
+  int Index(int n) { return static_cast<int>(NextRandom_() % n); }
+
+private:
+  // xorshift64*.
+  uint64_t NextRandom_() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return (state_ * 0x2545F4914F6CDD1DULL) >> 32;
+  }
+
+  KeyDistribution distribution_;
+  uint64_t state_;
+  int next_sorted_key_;
+  const std::vector<int> &zipf_samples_;
+};
+
+// Parameters for one point of the sweep.
+struct BenchmarkParams {
+  BenchmarkParams(Factory<Heap<int>> heap_factory)
+      : heap_factory(heap_factory), size(0),
+        distribution(KeyDistribution::kUniform), reduce_key_fraction(0),
+        num_operations(0) {}
+
+  Factory<Heap<int>> heap_factory;
+  int size;
+  KeyDistribution distribution;
+  double reduce_key_fraction;
+  long num_operations;
+};
+
+// Tags the timer with the heap's operation counters and shape.
+void RecordHeapStats(const Heap<int> &heap, PerfTimer *timer) {
+  if (!kEnableHeapStats) {
+    return;
+  }
+  for (const auto &stat : heap.Stats().ToList()) {
+    timer->AddStat(stat.first, stat.second);
+  }
+}
+
+// Adds `size` keys and pops them all, repeated until `num_operations`
+// operations are done. Tags the timer with the "operations" done, and the
+// heap's stats.
+class AddPopBenchmark : public PerfTestRunner<BenchmarkParams> {
+public:
+  std::string Name() const override { return "add_pop"; }
+
+  void Run(PerfTimer *timer, const BenchmarkParams &params) const override {
+    std::unique_ptr<Heap<int>> heap(params.heap_factory());
+    KeyGenerator keys(params.distribution, 12345);
+    const long num_cycles =
+        std::max(1L, params.num_operations / (2L * params.size));
+
+    timer->Start();
+    for (long cycle = 0; cycle < num_cycles; ++cycle) {
+      for (int i = 0; i < params.size; ++i) {
+        heap->Add(keys.Next(0), i);
+      }
+      for (int i = 0; i < params.size; ++i) {
+        heap->PopMinimum();
+      }
+    }
+    timer->Stop();
+    timer->AddStat("operations", 2.0 * num_cycles * params.size);
+    RecordHeapStats(*heap, timer);
+  }
+};
+
+// Fills the heap with `size` keys, then times a steady state of operations:
+// each is a ReduceKey with probability `reduce_key_fraction`, and otherwise a
+// PopMinimum followed by an Add. Tags the timer with the "operations" done,
+// and the heap's stats.
+class SteadyStateBenchmark : public PerfTestRunner<BenchmarkParams> {
+public:
+  explicit SteadyStateBenchmark(const std::string &name) : name_(name) {}
+
+  std::string Name() const override { return name_; }
+
+  void Run(PerfTimer *timer, const BenchmarkParams &params) const override {
+    std::unique_ptr<Heap<int>> heap(params.heap_factory());
+    KeyGenerator keys(params.distribution, 12345);
+    const bool reduce_keys = params.reduce_key_fraction > 0;
+
+    // Ids in the heap, and the position of each id in `ids`. Only kept when
+    // reducing keys, which needs random ids in the heap.
+    std::vector<int> ids;
+    std::vector<int> id_positions;
+    int next_id = 0;
+    auto add = [&](int key) {
+      heap->Add(key, next_id);
+      if (reduce_keys) {
+        id_positions.push_back(static_cast<int>(ids.size()));
+        ids.push_back(next_id);
+      }
+      next_id++;
+    };
+
+    for (int i = 0; i < params.size; ++i) {
+      add(keys.Next(0));
+    }
+
+    long num_operations = 0;
+    int min_key = 0;
+    timer->Start();
+    while (num_operations < params.num_operations) {
+      if (reduce_keys && keys.Bernoulli(params.reduce_key_fraction)) {
+        int id = ids[keys.Index(static_cast<int>(ids.size()))];
+        heap->ReduceKey(keys.Reduce(*heap->LookUp(id), min_key), id);
+        num_operations++;
+        continue;
+      }
+
+      HeapElement<int> min = heap->PopMinimum();
+      min_key = min.first;
+      if (reduce_keys) {
+        int position = id_positions[min.second];
+        ids[position] = ids.back();
+        id_positions[ids[position]] = position;
+        ids.pop_back();
+      }
+      add(keys.Next(min_key));
+      num_operations += 2;
+    }
+    timer->Stop();
+    timer->AddStat("operations", num_operations);
+    RecordHeapStats(*heap, timer);
+  }
+
+private:
+  std::string name_;
+};
+
+// Returns the heap sizes to sweep.
+std::vector<int> Sizes() {
+  const int min_size = absl::GetFlag(FLAGS_min_size);
+  const int max_size = absl::GetFlag(FLAGS_max_size);
+  const int sizes_per_decade = absl::GetFlag(FLAGS_sizes_per_decade);
+  std::vector<int> sizes;
+  for (int i = 0;; ++i) {
+    double size = min_size * std::pow(10.0, double(i) / sizes_per_decade);
+    if (size > max_size * 1.0001) {
+      break;
+    }
+    sizes.push_back(static_cast<int>(std::round(size)));
+  }
+  return sizes;
+}
+
+// Estimates the bytes per element of a heap, by filling one.
+double BytesPerElement(const Factory<Heap<int>> &heap_factory) {
+  const int size = 10000;
+  std::unique_ptr<Heap<int>> heap(heap_factory());
+  for (int i = 0; i < size; ++i) {
+    heap->Add(std::rand(), i);
+  }
+  return static_cast<double>(heap->MemoryUsage()) / size;
+}
+
+// Returns the value of the stat `name` that a benchmark tagged `timer` with.
+double GetStat(const PerfTimer &timer, const std::string &name) {
+  for (const auto &stat : timer.stats()) {
+    if (stat.first == name) {
+      return stat.second;
+    }
+  }
+  LOG(FATAL) << "Missing stat: " << name;
+  return 0;
+}
+
+// Returns a name for the counter, for a column header.
+std::string CounterColumnName(PerfCounterType type) {
+  std::string name = PerfCounterName(type);
+  for (char &c : name) {
+    c = c == ' ' ? '_' : std::tolower(c);
+  }
+  return name + "_per_op";
+}
+
+// Writes the header of the plot data.
+void WritePlotDataHeader(std::ostream &out) {
+  out << "heap,mix,distribution,size,runs,ns_per_op,ns_per_op_stddev,"
+         "relative_error";
+  for (int i = 0; i < kNumPerfCounters; ++i) {
+    out << "," << CounterColumnName(static_cast<PerfCounterType>(i));
+  }
+  out << std::endl;
+}
+
+// Runs one point of the sweep until it converges. Adds the result to
+// `report`, and a row to `plot_data` if not null.
+void RunPoint(const PerfTestRunner<BenchmarkParams> &benchmark,
+              const BenchmarkParams &params,
+              const std::string &distribution_name,
+              const ConvergenceCriteria &criteria, PerfReport *report,
+              std::ostream *plot_data) {
+  // Warm up the caches and the allocator, unless that takes long.
+  if (params.size <= 1000000) {
+    PerfTimer timer;
+    benchmark.Run(&timer, params);
+  }
+
+  PerfResult result;
+  result.binary = "heap_benchmark";
+  result.benchmark = benchmark.Name();
+  result.implementation = params.heap_factory.name();
+  result.params = {{"distribution", distribution_name},
+                   {"size", std::to_string(params.size)}};
+
+  std::vector<double> ns_per_op;
+  std::vector<std::pair<std::string, double>> heap_stats;
+  double elapsed_seconds = 0;
+  while (!Converged(ns_per_op, elapsed_seconds, criteria)) {
+    auto start = std::chrono::steady_clock::now();
+    PerfTimer timer;
+    benchmark.Run(&timer, params);
+    elapsed_seconds += std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+    const long num_operations =
+        static_cast<long>(GetStat(timer, "operations"));
+    ns_per_op.push_back(timer.TotalDurationUs() * 1000.0 / num_operations);
+    result.run_times_us.push_back(timer.TotalDurationUs());
+    result.num_operations += num_operations;
+    result.counter_values.Add(timer.counter_values());
+    heap_stats.clear();
+    for (const auto &stat : timer.stats()) {
+      if (stat.first != "operations") {
+        heap_stats.push_back(stat);
+      }
+    }
+  }
+
+  const double mean_ns_per_op = Mean(ns_per_op);
+  const double relative_error = RelativeStandardError(ns_per_op);
+  result.stats = {{"ns_per_op", mean_ns_per_op},
+                  {"relative_error", relative_error}};
+  result.stats.insert(result.stats.end(), heap_stats.begin(),
+                      heap_stats.end());
+
+  std::cout << params.heap_factory.name() << " " << benchmark.Name() << " "
+            << distribution_name << " " << params.size << ": "
+            << mean_ns_per_op << " ns/op +-" << relative_error * 100 << "% ("
+            << ns_per_op.size() << " runs)" << std::endl;
+  result.counter_values.PrintPerOperation(result.num_operations, std::cout);
+  if (!heap_stats.empty()) {
+    std::cout << "  Stats (last run):";
+    for (const auto &stat : heap_stats) {
+      std::cout << " " << stat.first << " " << stat.second;
+    }
+    std::cout << std::endl;
+  }
+
+  if (plot_data != nullptr) {
+    *plot_data << params.heap_factory.name() << "," << benchmark.Name() << ","
+               << distribution_name << "," << params.size << ","
+               << ns_per_op.size() << "," << mean_ns_per_op << ","
+               << StdDev(ns_per_op) << "," << relative_error;
+    for (int i = 0; i < kNumPerfCounters; ++i) {
+      auto type = static_cast<PerfCounterType>(i);
+      *plot_data << ",";
+      if (result.counter_values.has(type)) {
+        *plot_data << static_cast<double>(result.counter_values.get(type)) /
+                          result.num_operations;
+      }
+    }
+    *plot_data << std::endl;
+  }
+  report->Add(std::move(result));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+
+  if (absl::GetFlag(FLAGS_pin_cpu)) {
+    int cpu = absl::GetFlag(FLAGS_cpu);
+    if (cpu < 0) {
+      cpu = CurrentCpu();
+    }
+    if (PinToCpu(cpu)) {
+      std::cout << "Pinned to CPU " << cpu << std::endl;
+    } else {
+      LOG(WARNING) << "Failed to pin to CPU " << cpu;
+    }
+  }
+
+  const std::map<std::string, Factory<Heap<int>>> heap_factories{
+      {"adaptive_heap", AdaptiveHeap<int>::factory()},
+      {"b_heap", BHeap<int>::factory()},
+      {"binary_heap", BinaryHeap<int>::factory()},
+      {"binary_heap_bottom_up", BinaryHeap<int, true>::factory()},
+      {"binomial_heap", BinomialHeap<int>::factory()},
+      {"compact_pairing_heap", CompactPairingHeap<int>::factory()},
+      {"compact_weak_heap", CompactWeakHeap<int>::factory()},
+      {"dary_heap_4", DaryHeap<int, 4>::factory()},
+      {"dary_heap_8", DaryHeap<int, 8>::factory()},
+      {"dary_heap_16", DaryHeap<int, 16>::factory()},
+      {"fibonacci_heap", FibonacciHeap<int>::factory()},
+      {"flat_two_three_heap", FlatTwoThreeHeap<int>::factory()},
+      {"indirect_binomial_heap", IndirectBinomialHeap<int>::factory()},
+      {"lazy_binomial_heap", IndirectBinomialHeap<int, true>::factory()},
+      {"pairing_heap", PairingHeap<int>::factory()},
+      {"pairing_heap_auxiliary",
+       PairingHeap<int, TwoPassPairing, true>::factory()},
+      {"pairing_heap_back_to_front",
+       PairingHeap<int, BackToFrontPairing>::factory()},
+      {"pairing_heap_front_to_back",
+       PairingHeap<int, FrontToBackPairing>::factory()},
+      {"pairing_heap_multipass", PairingHeap<int, MultipassPairing>::factory()},
+      {"thin_heap", ThinHeap<int>::factory()},
+      {"two_three_heap", TwoThreeHeap<int>::factory()},
+      {"weak_heap", WeakHeap<int>::factory()}};
+
+  AddPopBenchmark add_pop;
+  SteadyStateBenchmark pop_add("pop_add");
+  SteadyStateBenchmark pop_add_reduce_key("pop_add_reduce_key");
+  const std::map<std::string, std::pair<const PerfTestRunner<BenchmarkParams> *,
+                                        double>>
+      mixes{{"add_pop", {&add_pop, 0}},
+            {"pop_add", {&pop_add, 0}},
+            {"pop_add_reduce_key", {&pop_add_reduce_key, 0.5}}};
+
+  ConvergenceCriteria criteria;
+  criteria.min_runs = absl::GetFlag(FLAGS_min_runs);
+  criteria.max_runs = absl::GetFlag(FLAGS_max_runs);
+  criteria.max_relative_error = absl::GetFlag(FLAGS_max_relative_error);
+  criteria.max_seconds = absl::GetFlag(FLAGS_max_seconds_per_point);
+
+  const double memory_budget =
+      absl::GetFlag(FLAGS_max_memory_fraction) * PhysicalMemoryBytes();
+
+  std::unique_ptr<std::ofstream> plot_data;
+  if (!absl::GetFlag(FLAGS_output_plot_data).empty()) {
+    plot_data = std::make_unique<std::ofstream>(
+        absl::GetFlag(FLAGS_output_plot_data));
+    WritePlotDataHeader(*plot_data);
+  }
+
+  PerfReport report;
+  for (absl::string_view heap_name :
+       absl::StrSplit(absl::GetFlag(FLAGS_heaps), ',')) {
+    auto heap_it = heap_factories.find(std::string(heap_name));
+    if (heap_it == heap_factories.end()) {
+      LOG(FATAL) << "Unknown heap: " << heap_name;
+    }
+    BenchmarkParams params(heap_it->second);
+    // The benchmark also keeps two ints per element to reduce keys.
+    const double bytes_per_element =
+        BytesPerElement(params.heap_factory) + 2 * sizeof(int);
+
+    for (absl::string_view mix_name :
+         absl::StrSplit(absl::GetFlag(FLAGS_mixes), ',')) {
+      auto mix_it = mixes.find(std::string(mix_name));
+      if (mix_it == mixes.end()) {
+        LOG(FATAL) << "Unknown mix: " << mix_name;
+      }
+      params.reduce_key_fraction = mix_it->second.second;
+
+      for (absl::string_view distribution_name :
+           absl::StrSplit(absl::GetFlag(FLAGS_distributions), ',')) {
+        auto distribution_it =
+            kKeyDistributions.find(std::string(distribution_name));
+        if (distribution_it == kKeyDistributions.end()) {
+          LOG(FATAL) << "Unknown distribution: " << distribution_name;
+        }
+        params.distribution = distribution_it->second;
+
+        for (int size : Sizes()) {
+          if (memory_budget > 0 && size * bytes_per_element > memory_budget) {
+            std::cout << "Skipping " << params.heap_factory.name() << " "
+                      << mix_name << " " << distribution_name << " " << size
+                      << ": needs about "
+                      << static_cast<long>(size * bytes_per_element /
+                                           (1024 * 1024))
+                      << " MB" << std::endl;
+            continue;
+          }
+          params.size = size;
+          params.num_operations = absl::GetFlag(FLAGS_ops_per_run);
+          RunPoint(*mix_it->second.first, params,
+                   std::string(distribution_name), criteria, &report,
+                   plot_data.get());
+        }
+      }
+    }
+  }
+
+  if (plot_data != nullptr && !*plot_data) {
+    LOG(FATAL) << "Failed to write the plot data";
+  }
+  if (!report.WriteFiles(absl::GetFlag(FLAGS_output_json),
+                         absl::GetFlag(FLAGS_output_csv))) {
+    LOG(FATAL) << "Failed to write the results";
+  }
+
+  return 0;
+}
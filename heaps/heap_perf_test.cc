@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <map>
 #include <string>
 #include <unordered_map>
 
@@ -7,31 +11,109 @@
 #include "absl/log/flags.h"
 #include "absl/log/initialize.h"
 #include "absl/log/log.h"
+#include "absl/strings/str_split.h"
 
+#include "base/memory.h"
 #include "base/perf.h"
+#include "base/perf_report.h"
+#include "base/statistics.h"
+#include "heaps/adaptive_heap.h"
+#include "heaps/b_heap.h"
 #include "heaps/binary_heap.h"
 #include "heaps/binomial_heap.h"
+#include "heaps/compact_pairing_heap.h"
+#include "heaps/compact_weak_heap.h"
+#include "heaps/dary_heap.h"
+#include "heaps/dijkstra_workload.h"
 #include "heaps/fibonacci_heap.h"
+#include "heaps/flat_two_three_heap.h"
+#include "heaps/heap_trace.h"
+#include "heaps/indirect_binomial_heap.h"
 #include "heaps/pairing_heap.h"
 #include "heaps/thin_heap.h"
 #include "heaps/two_three_heap.h"
 #include "heaps/weak_heap.h"
+#include "heaps/weak_heapsort.h"
 
 ABSL_FLAG(std::string, heap, "",
-          "one of {binary_heap, binomial_heap, pairing_heap, two_three_heap, "
-          "weak_heap, fibonacci_heap}");
+          "one of {adaptive_heap, b_heap, binary_heap, binary_heap_bottom_up, "
+          "binomial_heap, compact_pairing_heap, compact_weak_heap, "
+          "dary_heap_4, dary_heap_8, dary_heap_16, fibonacci_heap, "
+          "flat_two_three_heap, indirect_binomial_heap, lazy_binomial_heap, "
+          "pairing_heap, pairing_heap_auxiliary, pairing_heap_back_to_front, "
+          "pairing_heap_front_to_back, pairing_heap_multipass, thin_heap, "
+          "two_three_heap, weak_heap, binary_heap_unordered_map, "
+          "binomial_heap_unordered_map, fibonacci_heap_unordered_map, "
+          "pairing_heap_unordered_map, thin_heap_unordered_map, "
+          "two_three_heap_unordered_map, weak_heap_unordered_map}");
+ABSL_FLAG(std::string, output_json, "",
+          "if set, write the results as JSON to this file");
+ABSL_FLAG(std::string, output_csv, "",
+          "if set, write the results as CSV to this file");
+ABSL_FLAG(std::string, record_trace, "",
+          "if set, record the operations of one AllOperations run to this "
+          "trace file");
+ABSL_FLAG(std::string, replay_trace, "",
+          "if set, also run a perf test replaying this trace file");
+ABSL_FLAG(std::string, dijkstra_workload_graphs, "grid,random",
+          "comma separated graph classes to replay Dijkstra workloads on, "
+          "from {grid, random}; empty to skip");
+ABSL_FLAG(int, dijkstra_workload_vertices, 250000,
+          "vertices in the graphs of the Dijkstra workloads");
+ABSL_FLAG(bool, calibrate_adaptive_heap, false,
+          "if set, time the Binary and Pairing heaps to find the thresholds "
+          "for AdaptiveHeap on this machine, print them and exit");
+ABSL_FLAG(bool, sort_benchmark, false,
+          "if set, time weak-heapsort against std::sort, std::sort_heap and "
+          "sorting through a BinaryHeap, print the times and exit");
+ABSL_FLAG(std::string, adaptive_heap_thresholds, "",
+          "thresholds for --heap=adaptive_heap, as printed by "
+          "--calibrate_adaptive_heap");
 
 namespace {
 // Parameters for a Heap Performance Test.
 struct PerfTestParams {
   PerfTestParams(Factory<Heap<int>> heap_factory)
-      : heap_factory(heap_factory), num_elements(100), num_operations(100) {}
+      : heap_factory(heap_factory), num_elements(100), num_operations(100),
+        reduce_key_fraction(0), trace(nullptr) {}
 
   Factory<Heap<int>> heap_factory;
   int num_elements;
   int num_operations;
+
+  // Fraction of ReduceKey operations for MixedPerfTestRunner.
+  double reduce_key_fraction;
+
+  // Recorded operations for ReplayPerfTestRunner, and where they came from.
+  const HeapTrace<int> *trace;
+  std::string trace_name;
 };
 
+// Tags the timer with the heap's operation counters and shape.
+void RecordHeapStats(const Heap<int> &heap, PerfTimer *timer) {
+  if (!kEnableHeapStats) {
+    return;
+  }
+  for (const auto &stat : heap.Stats().ToList()) {
+    timer->AddStat(stat.first, stat.second);
+  }
+}
+
+// Tags the timer with the bytes per element of a heap: the MemoryUsage()
+// estimate, and the bytes allocated since `allocated_before` if allocations
+// are tracked.
+void RecordHeapMemory(const Heap<int> &heap, long allocated_before,
+                      PerfTimer *timer) {
+  timer->AddStat("bytes_per_element",
+                 static_cast<double>(heap.MemoryUsage()) / heap.size());
+  if (allocated_before >= 0) {
+    timer->AddStat("allocated_bytes_per_element",
+                   static_cast<double>(AllocatedBytes() - allocated_before) /
+                       heap.size());
+  }
+  timer->AddStat("peak_rss_bytes", PeakRssBytes());
+}
+
 std::ostream &operator<<(std::ostream &out, const PerfTestParams &params) {
   out << "PerfTestParams(num elements: " << params.num_elements
       << " num operations: " << params.num_operations << ")";
@@ -41,16 +123,23 @@ std::ostream &operator<<(std::ostream &out, const PerfTestParams &params) {
 // Performance Test for adding elements to a Heap.
 class AddPerfTestRunner : public PerfTestRunner<PerfTestParams> {
 public:
+  std::string Name() const override { return "Add"; }
+
   void Run(PerfTimer *timer, const PerfTestParams &params) const override {
     std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
     auto *heap = heap_pointer.get();
+    auto *add_latency = timer->OperationLatency("Add");
+    long allocated_before = AllocatedBytes();
 
     timer->Start();
     for (int i = 0; i < params.num_elements; ++i) {
       int key = std::rand();
+      ScopedLatency latency(add_latency);
       heap->Add(key, i);
     }
     timer->Stop();
+    RecordHeapStats(*heap, timer);
+    RecordHeapMemory(*heap, allocated_before, timer);
     timer->Report("Add");
   }
 };
@@ -58,6 +147,8 @@ public:
 // Performance test for popping from a Heap.
 class PopMinimumPerfTestRunner : public PerfTestRunner<PerfTestParams> {
 public:
+  std::string Name() const override { return "PopMinimum"; }
+
   void Run(PerfTimer *timer, const PerfTestParams &params) const override {
     std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
     auto *heap = heap_pointer.get();
@@ -67,11 +158,15 @@ public:
       heap->Add(key, i);
     }
 
+    auto *pop_latency = timer->OperationLatency("PopMinimum");
+
     timer->Start();
     for (int i = 0; i < params.num_elements; ++i) {
+      ScopedLatency latency(pop_latency);
       heap->PopMinimum();
     }
     timer->Stop();
+    RecordHeapStats(*heap, timer);
     timer->Report("PopMinimum");
   }
 };
@@ -79,19 +174,26 @@ public:
 // Performance test for adding and popping from a Heap. ie. Sorting.
 class AddAndPopMinimumPerfTestRunner : public PerfTestRunner<PerfTestParams> {
 public:
+  std::string Name() const override { return "AddAndPopMinimum"; }
+
   void Run(PerfTimer *timer, const PerfTestParams &params) const override {
     std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
     auto *heap = heap_pointer.get();
+    auto *add_latency = timer->OperationLatency("Add");
+    auto *pop_latency = timer->OperationLatency("PopMinimum");
 
     timer->Start();
     for (int i = 0; i < params.num_elements; ++i) {
       int key = std::rand();
+      ScopedLatency latency(add_latency);
       heap->Add(key, i);
     }
     for (int i = 0; i < params.num_elements; ++i) {
+      ScopedLatency latency(pop_latency);
       heap->PopMinimum();
     }
     timer->Stop();
+    RecordHeapStats(*heap, timer);
     timer->Report("AddAndPopMinimum");
   }
 };
@@ -99,6 +201,8 @@ public:
 // Performance test for reducing a value in a Heap.
 class ReduceKeyPerfTestRunner : public PerfTestRunner<PerfTestParams> {
 public:
+  std::string Name() const override { return "ReduceKey"; }
+
   void Run(PerfTimer *timer, const PerfTestParams &params) const override {
     std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
     auto *heap = heap_pointer.get();
@@ -108,17 +212,26 @@ public:
       heap->Add(key, i);
     }
 
+    auto *lookup_latency = timer->OperationLatency("LookUp");
+    auto *reduce_key_latency = timer->OperationLatency("ReduceKey");
+
     timer->Start();
     for (int i = 0; i < params.num_operations; ++i) {
       int index = std::rand() % heap->size();
-      int key = *heap->LookUp(index);
-      int new_key = key - (std::rand() % (key / 4));
+      const int *key;
+      {
+        ScopedLatency latency(lookup_latency);
+        key = heap->LookUp(index);
+      }
+      int new_key = *key - (std::rand() % (*key / 4));
       if (new_key <= 0) {
         new_key = 0;
       }
+      ScopedLatency latency(reduce_key_latency);
       heap->ReduceKey(new_key, index);
     }
     timer->Stop();
+    RecordHeapStats(*heap, timer);
     timer->Report("ReduceKey");
   }
 };
@@ -126,6 +239,8 @@ public:
 // Performance test for all operations on a Heap.
 class AllOperationsPerfTestRunner : public PerfTestRunner<PerfTestParams> {
 public:
+  std::string Name() const override { return "AllOperations"; }
+
   void Run(PerfTimer *timer, const PerfTestParams &params) const override {
     std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
     auto *heap = heap_pointer.get();
@@ -135,31 +250,44 @@ public:
     int num_adds = 0;
     int num_reduce_keys = 0;
 
+    auto *add_latency = timer->OperationLatency("Add");
+    auto *pop_latency = timer->OperationLatency("PopMinimum");
+    auto *lookup_latency = timer->OperationLatency("LookUp");
+    auto *reduce_key_latency = timer->OperationLatency("ReduceKey");
+
     timer->Start();
     for (int i = 0; i < params.num_operations; ++i) {
       if (!heap->empty()) {
+        ScopedLatency latency(pop_latency);
         heap->PopMinimum();
         num_pops++;
       }
       {
         int value = std::rand();
+        ScopedLatency latency(add_latency);
         heap->Add(value, id_counter++);
         num_adds++;
       }
       if (heap->size() < params.num_elements) {
         int key = std::rand();
+        ScopedLatency latency(add_latency);
         heap->Add(key, id_counter++);
         num_adds++;
       }
       for (int n = 0; n < 4; n++) {
         int id = std::rand() % id_counter;
-        auto result = heap->LookUp(id);
+        const int *result;
+        {
+          ScopedLatency latency(lookup_latency);
+          result = heap->LookUp(id);
+        }
         if (result != nullptr) {
           int key = *result;
           int new_key = key - (std::rand() % (key / 4));
           if (new_key <= 0) {
             new_key = 0;
           }
+          ScopedLatency latency(reduce_key_latency);
           heap->ReduceKey(new_key, id);
           num_reduce_keys++;
         }
@@ -167,11 +295,13 @@ public:
     }
 
     while (!heap->empty()) {
+      ScopedLatency latency(pop_latency);
       heap->PopMinimum();
       num_pops++;
     }
 
     timer->Stop();
+    RecordHeapStats(*heap, timer);
 
     std::stringstream description;
     description << "adds: " << num_adds << ", pops: " << num_pops
@@ -180,31 +310,190 @@ public:
   }
 };
 
-// Run the performance test several times and compute the average.
+// Performance test for a steady mix of operations, as in Dijkstra's
+// algorithm: each operation is a ReduceKey with probability
+// `reduce_key_fraction`, and otherwise a PopMinimum followed by an Add of a
+// larger key. The heap stays at `num_elements`.
+class MixedPerfTestRunner : public PerfTestRunner<PerfTestParams> {
+public:
+  std::string Name() const override { return "Mixed"; }
+
+  void Run(PerfTimer *timer, const PerfTestParams &params) const override {
+    std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
+    auto *heap = heap_pointer.get();
+
+    // Ids in the heap, and the position of each id in `ids`.
+    std::vector<int> ids;
+    std::vector<int> id_positions;
+    auto add = [heap, &ids, &id_positions](int key) {
+      int id = static_cast<int>(id_positions.size());
+      heap->Add(key, id);
+      id_positions.push_back(static_cast<int>(ids.size()));
+      ids.push_back(id);
+    };
+    for (int i = 0; i < params.num_elements; ++i) {
+      add(std::rand() / 2);
+    }
+
+    auto *add_latency = timer->OperationLatency("Add");
+    auto *pop_latency = timer->OperationLatency("PopMinimum");
+    auto *reduce_key_latency = timer->OperationLatency("ReduceKey");
+    const int reduce_key_limit =
+        static_cast<int>(params.reduce_key_fraction * RAND_MAX);
+
+    timer->Start();
+    for (int i = 0; i < params.num_operations; ++i) {
+      if (std::rand() < reduce_key_limit) {
+        int id = ids[std::rand() % ids.size()];
+        int key = *heap->LookUp(id);
+        int new_key = key - std::rand() % (key / 4 + 1);
+        ScopedLatency latency(reduce_key_latency);
+        heap->ReduceKey(new_key, id);
+        continue;
+      }
+
+      HeapElement<int> min;
+      {
+        ScopedLatency latency(pop_latency);
+        min = heap->PopMinimum();
+      }
+      int position = id_positions[min.second];
+      ids[position] = ids.back();
+      id_positions[ids[position]] = position;
+      ids.pop_back();
+
+      int key = min.first + std::rand() % 1000;
+      ScopedLatency latency(add_latency);
+      add(key);
+    }
+    timer->Stop();
+    RecordHeapStats(*heap, timer);
+
+    std::stringstream description;
+    description << "reduce-key fraction: " << params.reduce_key_fraction;
+    timer->Report("Mixed(" + description.str() + ")");
+  }
+};
+
+// Performance test replaying a recorded trace of heap operations.
+class ReplayPerfTestRunner : public PerfTestRunner<PerfTestParams> {
+public:
+  std::string Name() const override { return "Replay"; }
+
+  void Run(PerfTimer *timer, const PerfTestParams &params) const override {
+    std::unique_ptr<Heap<int>> heap_pointer(params.heap_factory());
+    auto *heap = heap_pointer.get();
+
+    // Indexed by HeapOperation. Only the operations in the trace get a
+    // histogram, so that the others don't report empty latencies.
+    const char *const operation_names[] = {
+        "Add", "ReduceKey", "PopMinimum", "LookUp", "IncreaseKey", "Remove"};
+    LatencyHistogram *latencies[6] = {};
+    for (const auto &op : *params.trace) {
+      int operation = static_cast<int>(op.operation);
+      if (latencies[operation] == nullptr) {
+        latencies[operation] =
+            timer->OperationLatency(operation_names[operation]);
+      }
+    }
+
+    long num_found = 0;
+    timer->Start();
+    for (const auto &op : *params.trace) {
+      ScopedLatency latency(latencies[static_cast<int>(op.operation)]);
+      num_found += ReplayHeapOp(op, heap);
+    }
+    timer->Stop();
+    RecordHeapStats(*heap, timer);
+
+    std::stringstream description;
+    description << "ops: " << params.trace->size() << ", found: " << num_found;
+    timer->Report("Replay(" + description.str() + ")");
+  }
+};
+
+// Records the operations of one AllOperations run to a trace file.
+void RecordTrace(Factory<Heap<int>> factory, const std::string &path) {
+  std::ofstream out(path, std::ios::binary);
+  HeapTraceWriter<int> writer(&out);
+
+  PerfTestParams params(RecordingHeap<int>::factory(factory, &writer));
+  params.num_elements = 50000;
+  params.num_operations = 200000;
+
+  std::srand(12345);
+  PerfTimer timer;
+  AllOperationsPerfTestRunner runner;
+  runner.Run(&timer, params);
+  if (!out) {
+    LOG(FATAL) << "Failed to write trace " << path;
+  }
+}
+
+// Run the performance test several times and compute the average, and add
+// the result to `report`. Hardware counts are merged across the timed runs.
+// The timed runs don't record latencies, which would add two clock reads and
+// a histogram update to every operation; they come from one extra run.
 void RunOnePerfTestAve(const PerfTestRunner<PerfTestParams> *runner,
-                       const PerfTestParams &params, int num_runs) {
-  auto run = [runner, &params]() -> std::pair<long, std::string> {
+                       const PerfTestParams &params, int num_runs,
+                       PerfReport *report) {
+  auto run = [runner, &params](PerfTimer *timer) {
     const unsigned kRandomSeed = 12345;
     std::srand(kRandomSeed);
-    PerfTimer timer;
-    runner->Run(&timer, params);
-    return std::make_pair(timer.TotalDurationMs(), timer.Report());
+    runner->Run(timer, params);
   };
 
   // Warm up.
-  auto warmup_result = run();
+  PerfTimer warmup_timer;
+  run(&warmup_timer);
+
+  PerfResult result;
+  result.binary = "heap_perf_test";
+  result.benchmark = runner->Name();
+  result.implementation = params.heap_factory.name();
+  result.params = {{"num_elements", std::to_string(params.num_elements)},
+                   {"num_operations", std::to_string(params.num_operations)}};
+  if (params.reduce_key_fraction > 0) {
+    result.params.emplace_back("reduce_key_fraction",
+                               std::to_string(params.reduce_key_fraction));
+  }
+  if (params.trace != nullptr) {
+    result.params.emplace_back("trace", params.trace_name);
+  }
 
-  long total_time_ms = 0;
+  long total_time_us = 0;
   for (int i = 0; i < num_runs; ++i) {
-    total_time_ms += run().first;
+    PerfTimer timer;
+    timer.DisableOperationLatencies();
+    run(&timer);
+    total_time_us += timer.TotalDurationUs();
+    result.run_times_us.push_back(timer.TotalDurationUs());
+    result.counter_values.Add(timer.counter_values());
+    result.stats = timer.stats();
   }
 
-  long ave_time_ms = total_time_ms / num_runs;
-  std::cout << "(" << num_runs << " runs) " << ave_time_ms << " ms. "
-            << warmup_result.second << std::endl;
+  // Every run uses the same seed, so performs the same operations.
+  PerfTimer latency_timer;
+  run(&latency_timer);
+  result.operation_latencies = latency_timer.operation_latencies();
+  result.num_operations = latency_timer.NumOperations() * num_runs;
+
+  long ave_time_us = total_time_us / num_runs;
+  std::cout << "(" << num_runs << " runs) " << ave_time_us << " us. "
+            << warmup_timer.Report() << std::endl;
+  PrintOperationLatencies(result.operation_latencies, std::cout);
+  result.counter_values.PrintPerOperation(result.num_operations, std::cout);
+  if (!result.stats.empty()) {
+    std::cout << "  Stats (last run):";
+    for (const auto &stat : result.stats) {
+      std::cout << " " << stat.first << " " << stat.second;
+    }
+    std::cout << std::endl;
+  }
+  report->Add(std::move(result));
 }
 
-void RunPerfTests(Factory<Heap<int>> factory) {
+void RunPerfTests(Factory<Heap<int>> factory, PerfReport *report) {
   PerfTestParams params(factory);
   params.num_elements = 50000;
   params.num_operations = 200000;
@@ -213,23 +502,175 @@ void RunPerfTests(Factory<Heap<int>> factory) {
   std::cout << "Params: " << params << std::endl;
   {
     AddPerfTestRunner runner;
-    RunOnePerfTestAve(&runner, params, num_runs);
+    RunOnePerfTestAve(&runner, params, num_runs, report);
   }
   {
     PopMinimumPerfTestRunner runner;
-    RunOnePerfTestAve(&runner, params, num_runs);
+    RunOnePerfTestAve(&runner, params, num_runs, report);
   }
   {
     AddAndPopMinimumPerfTestRunner runner;
-    RunOnePerfTestAve(&runner, params, num_runs);
+    RunOnePerfTestAve(&runner, params, num_runs, report);
   }
   {
     ReduceKeyPerfTestRunner runner;
-    RunOnePerfTestAve(&runner, params, num_runs);
+    RunOnePerfTestAve(&runner, params, num_runs, report);
   }
   {
     AllOperationsPerfTestRunner runner;
-    RunOnePerfTestAve(&runner, params, num_runs);
+    RunOnePerfTestAve(&runner, params, num_runs, report);
+  }
+  {
+    PerfTestParams mixed_params = params;
+    mixed_params.reduce_key_fraction = 0.25;
+    MixedPerfTestRunner runner;
+    RunOnePerfTestAve(&runner, mixed_params, num_runs, report);
+  }
+
+  std::string trace_path = absl::GetFlag(FLAGS_replay_trace);
+  if (!trace_path.empty()) {
+    std::ifstream in(trace_path, std::ios::binary);
+    HeapTrace<int> trace;
+    if (!ReadHeapTrace(&in, &trace)) {
+      LOG(FATAL) << "Failed to read trace " << trace_path;
+    }
+    PerfTestParams replay_params = params;
+    replay_params.trace = &trace;
+    replay_params.trace_name = trace_path;
+    ReplayPerfTestRunner runner;
+    RunOnePerfTestAve(&runner, replay_params, num_runs, report);
+  }
+
+  const std::map<std::string, DijkstraWorkloadGraph> dijkstra_workload_graphs{
+      {"grid", DijkstraWorkloadGraph::kGrid},
+      {"random", DijkstraWorkloadGraph::kRandom}};
+  for (absl::string_view graph_name :
+       absl::StrSplit(absl::GetFlag(FLAGS_dijkstra_workload_graphs), ',',
+                      absl::SkipEmpty())) {
+    auto it = dijkstra_workload_graphs.find(std::string(graph_name));
+    if (it == dijkstra_workload_graphs.end()) {
+      LOG(FATAL) << "Unknown Dijkstra workload graph: " << graph_name;
+    }
+    DijkstraWorkloadParams workload_params;
+    workload_params.graph = it->second;
+    workload_params.num_vertices =
+        absl::GetFlag(FLAGS_dijkstra_workload_vertices);
+    HeapTrace<int> trace;
+    DijkstraWorkloadProfile profile;
+    GenerateDijkstraWorkload(workload_params, &trace, &profile);
+    std::cout << "Dijkstra workload on a " << graph_name
+              << " graph: " << profile << std::endl;
+
+    PerfTestParams replay_params = params;
+    replay_params.trace = &trace;
+    replay_params.trace_name = "dijkstra_" + std::string(graph_name);
+    ReplayPerfTestRunner runner;
+    RunOnePerfTestAve(&runner, replay_params, num_runs, report);
+  }
+}
+
+// Returns the median run time of a perf test, in microseconds.
+double MedianRunTimeUs(const PerfTestRunner<PerfTestParams> &runner,
+                       const PerfTestParams &params, int num_runs) {
+  std::vector<double> run_times_us;
+  for (int i = 0; i < num_runs; ++i) {
+    std::srand(12345);
+    PerfTimer timer;
+    runner.Run(&timer, params);
+    run_times_us.push_back(timer.TotalDurationUs());
+  }
+  return Median(run_times_us);
+}
+
+// Finds the AdaptiveHeap thresholds for this machine. For each heap size,
+// finds the smallest fraction of ReduceKey operations at which the Pairing
+// Heap beats the Binary Heap on the Mixed test.
+AdaptiveHeapThresholds CalibrateAdaptiveHeap() {
+  const std::vector<int> sizes{100, 1000, 10000, 100000};
+  const int num_runs = 5;
+
+  AdaptiveHeapThresholds thresholds;
+  thresholds.pairing_reduce_key_fractions.clear();
+  MixedPerfTestRunner runner;
+  for (int size : sizes) {
+    // Above 1 if the Pairing Heap never wins.
+    double crossover = 2;
+    for (int step = 0; step <= 10 && crossover > 1; ++step) {
+      PerfTestParams params(BinaryHeap<int>::factory());
+      params.num_elements = size;
+      params.num_operations = 200000;
+      params.reduce_key_fraction = step / 10.0;
+      double binary_heap_us = MedianRunTimeUs(runner, params, num_runs);
+      params.heap_factory = PairingHeap<int>::factory();
+      double pairing_heap_us = MedianRunTimeUs(runner, params, num_runs);
+
+      std::cout << "size " << size << ", reduce-key fraction "
+                << params.reduce_key_fraction << ": binary heap "
+                << binary_heap_us << " us, pairing heap " << pairing_heap_us
+                << " us" << std::endl;
+      if (pairing_heap_us < binary_heap_us) {
+        crossover = params.reduce_key_fraction;
+      }
+    }
+    thresholds.pairing_reduce_key_fractions.emplace_back(size, crossover);
+  }
+  return thresholds;
+}
+
+// Times sorting random ints with weak-heapsort, std::sort, std::make_heap
+// and std::sort_heap, and adding to then popping from a BinaryHeap. Prints
+// the median time of each.
+void RunSortBenchmark() {
+  const int num_runs = 5;
+  using SortFunction = std::function<void(std::vector<int> *)>;
+  const std::vector<std::pair<std::string, SortFunction>> sorts{
+      {"weak-heapsort",
+       [](std::vector<int> *values) {
+         WeakHeapSort(values->data(), values->data() + values->size());
+       }},
+      {"std::sort",
+       [](std::vector<int> *values) {
+         std::sort(values->begin(), values->end());
+       }},
+      {"std::sort_heap",
+       [](std::vector<int> *values) {
+         std::make_heap(values->begin(), values->end());
+         std::sort_heap(values->begin(), values->end());
+       }},
+      {"BinaryHeap", [](std::vector<int> *values) {
+         BinaryHeap<int> heap;
+         for (int i = 0; i < values->size(); ++i) {
+           heap.Add((*values)[i], i);
+         }
+         for (int i = 0; i < values->size(); ++i) {
+           (*values)[i] = heap.PopMinimum().first;
+         }
+       }}};
+
+  std::srand(12345);
+  for (int size : {1000, 100000, 1000000}) {
+    std::vector<int> values(size);
+    for (int &value : values) {
+      value = std::rand();
+    }
+    std::vector<int> expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    std::cout << "size " << size << ":";
+    for (const auto &sort : sorts) {
+      std::vector<double> run_times_us;
+      for (int i = 0; i < num_runs; ++i) {
+        std::vector<int> sorted = values;
+        PerfTimer timer;
+        timer.Start();
+        sort.second(&sorted);
+        timer.Stop();
+        CHECK(sorted == expected) << sort.first;
+        run_times_us.push_back(timer.TotalDurationUs());
+      }
+      std::cout << " " << sort.first << " " << Median(run_times_us) << " us";
+    }
+    std::cout << std::endl;
   }
 }
 
@@ -239,14 +680,67 @@ int main(int argc, char *argv[]) {
   absl::ParseCommandLine(argc, argv);
   absl::InitializeLog();
 
+  if (absl::GetFlag(FLAGS_calibrate_adaptive_heap)) {
+    AdaptiveHeapThresholds thresholds = CalibrateAdaptiveHeap();
+    std::cout << "--adaptive_heap_thresholds=\"" << thresholds.ToString()
+              << "\"" << std::endl;
+    return 0;
+  }
+
+  if (absl::GetFlag(FLAGS_sort_benchmark)) {
+    RunSortBenchmark();
+    return 0;
+  }
+
+  AdaptiveHeapThresholds adaptive_heap_thresholds;
+  if (!adaptive_heap_thresholds.Parse(
+          absl::GetFlag(FLAGS_adaptive_heap_thresholds))) {
+    LOG(FATAL) << "Bad --adaptive_heap_thresholds";
+  }
+
   std::unordered_map<std::string, Factory<Heap<int>>> heap_factories{
+      {"adaptive_heap", AdaptiveHeap<int>::factory(adaptive_heap_thresholds)},
+      {"b_heap", BHeap<int>::factory()},
       {"binary_heap", BinaryHeap<int>::factory()},
+      {"binary_heap_bottom_up", BinaryHeap<int, true>::factory()},
       {"binomial_heap", BinomialHeap<int>::factory()},
+      {"compact_pairing_heap", CompactPairingHeap<int>::factory()},
+      {"compact_weak_heap", CompactWeakHeap<int>::factory()},
+      {"dary_heap_4", DaryHeap<int, 4>::factory()},
+      {"dary_heap_8", DaryHeap<int, 8>::factory()},
+      {"dary_heap_16", DaryHeap<int, 16>::factory()},
       {"fibonacci_heap", FibonacciHeap<int>::factory()},
+      {"flat_two_three_heap", FlatTwoThreeHeap<int>::factory()},
+      {"indirect_binomial_heap", IndirectBinomialHeap<int>::factory()},
+      {"lazy_binomial_heap", IndirectBinomialHeap<int, true>::factory()},
       {"pairing_heap", PairingHeap<int>::factory()},
+      {"pairing_heap_auxiliary",
+       PairingHeap<int, TwoPassPairing, true>::factory()},
+      {"pairing_heap_back_to_front",
+       PairingHeap<int, BackToFrontPairing>::factory()},
+      {"pairing_heap_front_to_back",
+       PairingHeap<int, FrontToBackPairing>::factory()},
+      {"pairing_heap_multipass", PairingHeap<int, MultipassPairing>::factory()},
       {"thin_heap", ThinHeap<int>::factory()},
       {"two_three_heap", TwoThreeHeap<int>::factory()},
-      {"weak_heap", WeakHeap<int>::factory()}};
+      {"weak_heap", WeakHeap<int>::factory()},
+      // The heaps with the previous std::unordered_map id index, to compare
+      // with the default FlatHashMap.
+      {"binary_heap_unordered_map",
+       BinaryHeap<int, false, HeapIds<int, HashIdIndex>>::factory()},
+      {"binomial_heap_unordered_map",
+       BinomialHeap<int, HeapIds<int, HashIdIndex>>::factory()},
+      {"fibonacci_heap_unordered_map",
+       FibonacciHeap<int, HeapIds<int, HashIdIndex>>::factory()},
+      {"pairing_heap_unordered_map",
+       PairingHeap<int, TwoPassPairing, false,
+                   HeapIds<int, HashIdIndex>>::factory()},
+      {"thin_heap_unordered_map",
+       ThinHeap<int, HeapIds<int, HashIdIndex>>::factory()},
+      {"two_three_heap_unordered_map",
+       TwoThreeHeap<int, HeapIds<int, HashIdIndex>>::factory()},
+      {"weak_heap_unordered_map",
+       WeakHeap<int, HeapIds<int, HashIdIndex>>::factory()}};
 
   std::string heap_flag = absl::GetFlag(FLAGS_heap);
   auto it = heap_factories.find(heap_flag);
@@ -256,7 +750,19 @@ int main(int argc, char *argv[]) {
 
   auto factory = it->second;
   std::cout << std::endl << "Perf Testing " << factory.name() << std::endl;
-  RunPerfTests(factory);
+  std::string record_path = absl::GetFlag(FLAGS_record_trace);
+  if (!record_path.empty()) {
+    RecordTrace(factory, record_path);
+  }
+
+  PerfReport report;
+  RunPerfTests(factory, &report);
+  std::cout << "Peak RSS " << PeakRssBytes() / (1024 * 1024) << " MB"
+            << std::endl;
+  if (!report.WriteFiles(absl::GetFlag(FLAGS_output_json),
+                         absl::GetFlag(FLAGS_output_csv))) {
+    LOG(FATAL) << "Failed to write the results";
+  }
 
   return 0;
 }
@@ -0,0 +1,100 @@
+// Operation counters and structural statistics of a heap.
+
+#ifndef HEAPS_HEAP_STATS_H_
+#define HEAPS_HEAP_STATS_H_
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Heap counters are only maintained when built with -DHEAPS_ENABLE_STATS,
+// e.g. `bazel build --copt=-DHEAPS_ENABLE_STATS ...`. Otherwise all the
+// counter updates compile away.
+#ifdef HEAPS_ENABLE_STATS
+const bool kEnableHeapStats = true;
+#else
+const bool kEnableHeapStats = false;
+#endif
+
+// Counts the work done inside a heap, and describes its shape.
+struct HeapStats {
+  HeapStats()
+      : adds(0), pops(0), reduce_keys(0), increase_keys(0), removes(0),
+        links(0), cuts(0), cascading_cuts(0), consolidations(0),
+        sift_steps(0), num_trees(0), max_height(0) {}
+
+  // Calls to the public operations.
+  long adds;
+  long pops;
+  long reduce_keys;
+  long increase_keys;
+  long removes;
+
+  // Trees linked under another tree, or weak heap joins.
+  long links;
+
+  // Subtrees cut from their parent by ReduceKey, IncreaseKey or Remove.
+  long cuts;
+
+  // Additional cuts of ancestors triggered by a cut.
+  long cascading_cuts;
+
+  // Passes that consolidate the root list.
+  long consolidations;
+
+  // Levels moved by elements while sifting up or down.
+  long sift_steps;
+
+  // Shape at the time of the snapshot: number of trees, and the height of
+  // the tallest tree.
+  int num_trees;
+  int max_height;
+
+  // Adds the counters of `other`, e.g. of another heap, and keeps the larger
+  // of the shapes.
+  void Add(const HeapStats &other) {
+    adds += other.adds;
+    pops += other.pops;
+    reduce_keys += other.reduce_keys;
+    increase_keys += other.increase_keys;
+    removes += other.removes;
+    links += other.links;
+    cuts += other.cuts;
+    cascading_cuts += other.cascading_cuts;
+    consolidations += other.consolidations;
+    sift_steps += other.sift_steps;
+    num_trees = std::max(num_trees, other.num_trees);
+    max_height = std::max(max_height, other.max_height);
+  }
+
+  // Returns the statistics as (name, value) pairs.
+  std::vector<std::pair<std::string, double>> ToList() const {
+    return {{"adds", adds},
+            {"pops", pops},
+            {"reduce_keys", reduce_keys},
+            {"increase_keys", increase_keys},
+            {"removes", removes},
+            {"links", links},
+            {"cuts", cuts},
+            {"cascading_cuts", cascading_cuts},
+            {"consolidations", consolidations},
+            {"sift_steps", sift_steps},
+            {"num_trees", num_trees},
+            {"max_height", max_height}};
+  }
+};
+
+inline std::ostream &operator<<(std::ostream &out, const HeapStats &stats) {
+  out << "HeapStats(";
+  bool first = true;
+  for (const auto &stat : stats.ToList()) {
+    out << (first ? "" : ", ") << stat.first << ": " << stat.second;
+    first = false;
+  }
+  out << ")";
+  return out;
+}
+
+#endif /* HEAPS_HEAP_STATS_H_ */
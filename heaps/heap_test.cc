@@ -1,6 +1,13 @@
 // Tests Heap implementations by running through all Heap operations.
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <sstream>
 
 #include "absl/flags/parse.h"
 #include "absl/log/check.h"
@@ -8,13 +15,24 @@
 #include "absl/log/initialize.h"
 #include "absl/log/log.h"
 
+#include "heaps/adaptive_heap.h"
+#include "heaps/b_heap.h"
 #include "heaps/binary_heap.h"
 #include "heaps/binomial_heap.h"
+#include "heaps/compact_pairing_heap.h"
+#include "heaps/compact_weak_heap.h"
+#include "heaps/dary_heap.h"
+#include "heaps/dijkstra_workload.h"
 #include "heaps/fibonacci_heap.h"
+#include "heaps/flat_two_three_heap.h"
+#include "heaps/heap_trace.h"
+#include "heaps/indirect_binomial_heap.h"
 #include "heaps/pairing_heap.h"
+#include "heaps/payload_heap.h"
 #include "heaps/thin_heap.h"
 #include "heaps/two_three_heap.h"
 #include "heaps/weak_heap.h"
+#include "heaps/weak_heapsort.h"
 
 namespace {
 
@@ -119,6 +137,48 @@ public:
     ReduceKey(new_key, id);
   }
 
+  // Perform an IncreaseKey operation on the heap.
+  void IncreaseKey(T new_key, int id) {
+    if (kDebugPrintOperations) {
+      LOG(INFO) << "[Test] IncreaseKey: " << new_key;
+    }
+
+    heap_->IncreaseKey(new_key, id);
+    CheckHeap_();
+
+    CHECK(*heap_->LookUp(id) == new_key);
+    CHECK(heap_->size() == ids_.size());
+  }
+
+  // Perform a Remove operation on the heap.
+  void Remove(int id) {
+    if (kDebugPrintOperations) {
+      LOG(INFO) << "[Test] Remove: " << *heap_->LookUp(id);
+    }
+
+    heap_->Remove(id);
+    CheckHeap_();
+
+    ids_.Remove(id);
+    CHECK(heap_->LookUp(id) == nullptr);
+    CHECK(heap_->size() == ids_.size());
+  }
+
+  // Randomly increase a key in the heap.
+  void RandomIncreaseKey() {
+    CHECK(ids_.size() > 0);
+    int id = ids_.RandomId();
+    const T *key = heap_->LookUp(id);
+    CHECK(key != nullptr);
+    IncreaseKey(*key + std::rand() % (*key / 4 + 1), id);
+  }
+
+  // Randomly remove an element from the heap.
+  void RandomRemove() {
+    CHECK(ids_.size() > 0);
+    Remove(ids_.RandomId());
+  }
+
   // Tests Add and Pop operations on the heap.
   void TestAddAndPop(int num_elements) {
     CHECK(heap_->empty());
@@ -181,6 +241,39 @@ public:
     Clear_();
   }
 
+  // Tests Remove and IncreaseKey mixed with the other operations, as in a
+  // job queue where many entries are cancelled or postponed.
+  void TestRemoveAndIncreaseKey(int num_elements, int num_operations) {
+    for (int i = 0; i < num_operations; ++i) {
+      if (heap_->size() < num_elements) {
+        Add(std::rand() % 1000000, i);
+      }
+
+      int operation = std::rand() % 10;
+      if (heap_->empty()) {
+        continue;
+      } else if (operation < 3) {
+        RandomRemove();
+      } else if (operation < 5) {
+        RandomIncreaseKey();
+      } else if (operation < 7) {
+        int id = ids_.RandomId();
+        int key = *heap_->LookUp(id);
+        ReduceKey(key - std::rand() % (key / 4 + 1), id);
+      } else if (operation < 8) {
+        PopMinimum();
+      }
+    }
+
+    // The remaining elements pop in order.
+    T prev_key = heap_->empty() ? T() : heap_->Min().first;
+    while (!heap_->empty()) {
+      auto min = PopMinimum();
+      CHECK(!(min.first < prev_key));
+      prev_key = min.first;
+    }
+  }
+
 private:
   // Check that the heap is well formed.
   void CheckHeap_() {
@@ -201,6 +294,599 @@ private:
   IdSet ids_;
 };
 
+// Records random operations on a heap, then checks that replaying the trace
+// pops the same elements from a fresh heap as from a reference BinaryHeap.
+void TestTraceReplay(Factory<Heap<int>> factory) {
+  std::stringstream trace_stream;
+  HeapTraceWriter<int> writer(&trace_stream);
+  {
+    HeapTester<int> tester(
+        std::make_unique<RecordingHeap<int>>(factory(), &writer));
+    tester.TestRandomOperations(1000, 1000);
+    tester.TestRemoveAndIncreaseKey(500, 1000);
+  }
+
+  HeapTrace<int> trace;
+  CHECK(ReadHeapTrace(&trace_stream, &trace));
+  CHECK(!trace.empty());
+
+  std::vector<HeapElement<int>> popped;
+  std::vector<HeapElement<int>> expected_popped;
+  auto heap = factory();
+  BinaryHeap<int> reference_heap;
+  CHECK(ReplayHeapTrace(trace, heap.get(), &popped) ==
+        ReplayHeapTrace(trace, &reference_heap, &expected_popped));
+  CHECK(heap->empty());
+  CHECK(popped.size() == expected_popped.size());
+  for (int i = 0; i < popped.size(); ++i) {
+    // Ties may be popped in any order, so only compare the keys.
+    CHECK(popped[i].first == expected_popped[i].first);
+  }
+}
+
+// Replays generated Dijkstra workloads, and checks that the keys are popped
+// in order, the same as from a reference BinaryHeap.
+void TestDijkstraWorkload(Factory<Heap<int>> factory) {
+  for (auto graph :
+       {DijkstraWorkloadGraph::kGrid, DijkstraWorkloadGraph::kRandom}) {
+    DijkstraWorkloadParams params;
+    params.graph = graph;
+    params.num_vertices = 2500;
+    params.max_weight = 10;
+    HeapTrace<int> trace;
+    DijkstraWorkloadProfile profile;
+    GenerateDijkstraWorkload(params, &trace, &profile);
+    CHECK(profile.num_pops == profile.num_adds);
+    CHECK(profile.num_reduce_keys > 0);
+    CHECK(profile.mean_reduce_key_gap < profile.mean_add_gap);
+    if (graph == DijkstraWorkloadGraph::kGrid) {
+      CHECK(profile.num_pops == params.num_vertices);
+    }
+
+    std::vector<HeapElement<int>> popped;
+    std::vector<HeapElement<int>> expected_popped;
+    auto heap = factory();
+    BinaryHeap<int> reference_heap;
+    // Lookups of vertices tied with the minimum may find them in one heap
+    // and not in the other, so the checksums are not compared.
+    ReplayHeapTrace(trace, heap.get(), &popped);
+    ReplayHeapTrace(trace, &reference_heap, &expected_popped);
+    CHECK(heap->empty());
+    CHECK(popped.size() == profile.num_pops);
+    for (int i = 0; i < popped.size(); ++i) {
+      CHECK(popped[i].first == expected_popped[i].first);
+      CHECK(i == 0 || popped[i - 1].first <= popped[i].first);
+    }
+  }
+}
+
+// Checks that an AdaptiveHeap switches to a Pairing Heap under a ReduceKey
+// heavy workload, and back to a Binary Heap without one.
+void TestAdaptiveHeapSwitches(const AdaptiveHeapThresholds &thresholds) {
+  AdaptiveHeap<int> heap(thresholds);
+  for (int i = 0; i < 1000; ++i) {
+    heap.Add(i * 10 + 10, i);
+  }
+  CHECK(!heap.is_pairing_heap());
+
+  for (int i = 0; i < 1000; ++i) {
+    heap.ReduceKey(*heap.LookUp(i) - 1, i);
+  }
+  CHECK(heap.is_pairing_heap());
+  heap.Validate();
+
+  for (int i = 0; i < 500; ++i) {
+    CHECK(heap.PopMinimum().second == i);
+  }
+  CHECK(!heap.is_pairing_heap());
+  CHECK(heap.num_switches() == 2);
+  heap.Validate();
+
+  // The operation mix decides between sizes where the fraction is in (0, 1].
+  CHECK(thresholds.FavourPairingHeap(100, 0.5));
+  CHECK(!thresholds.FavourPairingHeap(100, 0));
+
+  // The default table only looks at the size.
+  const AdaptiveHeapThresholds defaults;
+  for (int size : {10, 1000, 10000, 100000, 1000000}) {
+    CHECK(defaults.FavourPairingHeap(size, 0) ==
+          defaults.FavourPairingHeap(size, 1));
+  }
+  CHECK(defaults.FavourPairingHeap(1000, 0));
+  CHECK(!defaults.FavourPairingHeap(100000, 1));
+
+  AdaptiveHeapThresholds parsed;
+  CHECK(parsed.Parse(thresholds.ToString()));
+  CHECK(parsed.ToString() == thresholds.ToString());
+  CHECK(!parsed.Parse("sample_interval=x"));
+}
+
+// The number of comparisons between CountedInts.
+long num_comparisons = 0;
+
+// An int that counts its comparisons.
+struct CountedInt {
+  int value;
+
+  bool operator<(const CountedInt &other) const {
+    num_comparisons++;
+    return value < other.value;
+  }
+};
+
+std::ostream &operator<<(std::ostream &out, const CountedInt &value) {
+  return out << value.value;
+}
+
+// Checks that WeakHeapSort sorts, within n ceil(log n) - 2^ceil(log n) + n - 1
+// comparisons.
+void TestWeakHeapSort() {
+  for (int n : {0, 1, 2, 3, 10, 64, 65, 1000, 4096, 10000}) {
+    std::vector<CountedInt> values(n);
+    for (auto &value : values) {
+      value.value = rand() % (n + 1);
+    }
+    std::vector<int> expected(n);
+    for (int i = 0; i < n; ++i) {
+      expected[i] = values[i].value;
+    }
+    std::sort(expected.begin(), expected.end());
+
+    num_comparisons = 0;
+    WeakHeapSort(values.data(), values.data() + n);
+    for (int i = 0; i < n; ++i) {
+      CHECK(values[i].value == expected[i]);
+    }
+    if (n > 1) {
+      const int log_n = static_cast<int>(std::ceil(std::log2(n)));
+      CHECK(num_comparisons <= n * log_n - (1 << log_n) + n - 1)
+          << num_comparisons;
+    }
+  }
+}
+
+// Checks that CompactWeakHeap::AddAll builds a heap with n - 1 comparisons,
+// and adds to a non-empty heap.
+void TestCompactWeakHeapAddAll() {
+  const int n = 5000;
+  std::vector<HeapElement<int>> elements;
+  for (int i = 0; i < n; ++i) {
+    elements.emplace_back(rand() % n, i);
+  }
+
+  CompactWeakHeap<int> heap;
+  heap.AddAll(elements);
+  heap.Validate();
+  CHECK(heap.size() == n);
+
+  std::vector<HeapElement<int>> more_elements;
+  for (int i = n; i < n + 100; ++i) {
+    more_elements.emplace_back(rand() % n, i);
+  }
+  heap.AddAll(std::move(more_elements));
+  heap.Validate();
+
+  int prev_key = -1;
+  for (int i = 0; i < n + 100; ++i) {
+    auto min = heap.PopMinimum();
+    CHECK(prev_key <= min.first);
+    prev_key = min.first;
+  }
+  CHECK(heap.empty());
+
+  CompactWeakHeap<CountedInt> counted_heap;
+  std::vector<HeapElement<CountedInt>> counted_elements;
+  for (const auto &element : elements) {
+    counted_elements.emplace_back(CountedInt{element.first}, element.second);
+  }
+  num_comparisons = 0;
+  counted_heap.AddAll(std::move(counted_elements));
+  CHECK(num_comparisons == n - 1);
+}
+
+// Checks that a bottom-up BinaryHeap pops the same keys as a BinaryHeap,
+// with fewer comparisons.
+void TestBinaryHeapBottomUp() {
+  const int n = 10000;
+  BinaryHeap<CountedInt> heap;
+  BinaryHeap<CountedInt, true> bottom_up_heap;
+  for (int i = 0; i < n; ++i) {
+    CountedInt key{rand() % n};
+    heap.Add(key, i);
+    bottom_up_heap.Add(key, i);
+  }
+  bottom_up_heap.Validate();
+
+  long comparisons = 0;
+  long bottom_up_comparisons = 0;
+  for (int i = 0; i < n; ++i) {
+    num_comparisons = 0;
+    auto min = heap.PopMinimum();
+    comparisons += num_comparisons;
+
+    num_comparisons = 0;
+    auto bottom_up_min = bottom_up_heap.PopMinimum();
+    bottom_up_comparisons += num_comparisons;
+    CHECK(min.first.value == bottom_up_min.first.value);
+  }
+  CHECK(bottom_up_heap.empty());
+  CHECK(bottom_up_comparisons < comparisons * 3 / 4)
+      << bottom_up_comparisons << " vs " << comparisons;
+}
+
+// Checks the DaryHeap minimum child scan against a plain loop, with many
+// ties. With -msse4.1 or -mavx2 this tests the SIMD versions.
+template <int kArity> void TestDaryHeapMinIndex() {
+  using FullMinIndex =
+      dary_heap_internal::FullMinIndex<int, kArity, std::less<int>>;
+  int keys[kArity];
+  for (int i = 0; i < 10000; ++i) {
+    for (int &key : keys) {
+      key = rand() % 8 - 4;
+    }
+    int expected = 0;
+    for (int j = 1; j < kArity; ++j) {
+      if (keys[j] < keys[expected]) {
+        expected = j;
+      }
+    }
+    CHECK(FullMinIndex::Find(keys) == expected);
+  }
+}
+
+// Checks a FlatTwoThreeHeap against a TwoThreeHeap: under the same random
+// operations, both have the same size, keys and min key.
+void TestFlatTwoThreeHeap() {
+  const int num_ids = 2000;
+  const int num_operations = 50000;
+  TwoThreeHeap<int> heap;
+  FlatTwoThreeHeap<int> flat_heap;
+  for (int i = 0; i < num_operations; ++i) {
+    const int id = rand() % num_ids;
+    const int *key = heap.LookUp(id);
+    const int op = rand() % 8;
+    if (key == nullptr) {
+      const int new_key = rand() % 100000;
+      heap.Add(new_key, id);
+      flat_heap.Add(new_key, id);
+    } else if (op < 4) {
+      const int new_key = *key - rand() % (*key / 4 + 1);
+      heap.ReduceKey(new_key, id);
+      flat_heap.ReduceKey(new_key, id);
+    } else if (op < 5) {
+      const int new_key = *key + rand() % 1000;
+      heap.IncreaseKey(new_key, id);
+      flat_heap.IncreaseKey(new_key, id);
+    } else if (op < 6) {
+      heap.Remove(id);
+      flat_heap.Remove(id);
+    } else {
+      // Ties may be popped in any order, so only compare the keys.
+      CHECK(heap.PopMinimum().first == flat_heap.PopMinimum().first);
+    }
+
+    CHECK(heap.size() == flat_heap.size());
+    CHECK(heap.empty() || heap.Min().first == flat_heap.Min().first);
+    const int *flat_key = flat_heap.LookUp(id);
+    key = heap.LookUp(id);
+    CHECK((key == nullptr) == (flat_key == nullptr));
+    CHECK(key == nullptr || *key == *flat_key);
+    if (i % 1000 == 0) {
+      flat_heap.Validate();
+    }
+  }
+  flat_heap.Validate();
+  while (!heap.empty()) {
+    CHECK(heap.PopMinimum().first == flat_heap.PopMinimum().first);
+  }
+  CHECK(flat_heap.empty());
+}
+
+// The number of copies of CopyCountedInts.
+long num_copies = 0;
+
+// An int that counts its copies, but not its moves.
+struct CopyCountedInt {
+  int value = 0;
+
+  CopyCountedInt() {}
+  explicit CopyCountedInt(int value) : value(value) {}
+  CopyCountedInt(const CopyCountedInt &other) : value(other.value) {
+    num_copies++;
+  }
+  CopyCountedInt(CopyCountedInt &&other) = default;
+  CopyCountedInt &operator=(const CopyCountedInt &other) {
+    num_copies++;
+    value = other.value;
+    return *this;
+  }
+  CopyCountedInt &operator=(CopyCountedInt &&other) = default;
+
+  bool operator<(const CopyCountedInt &other) const {
+    return value < other.value;
+  }
+};
+
+std::ostream &operator<<(std::ostream &out, const CopyCountedInt &value) {
+  return out << value.value;
+}
+
+// Checks that the heap moves the keys, rather than copying them, in Add,
+// ReduceKey and PopMinimum.
+void TestKeyMoves(Factory<Heap<CopyCountedInt>> factory) {
+  const int n = 2000;
+  auto heap = factory();
+  num_copies = 0;
+  for (int i = 0; i < n; ++i) {
+    heap->Emplace(i, rand() % n + n);
+  }
+  for (int i = 0; i < n; i += 2) {
+    heap->ReduceKey(CopyCountedInt(heap->LookUp(i)->value - n), i);
+  }
+  for (int i = 0; i < n / 2; ++i) {
+    heap->PopMinimum();
+  }
+  for (int i = 0; i < n; ++i) {
+    heap->Add(CopyCountedInt(rand() % n), n + i);
+  }
+  while (!heap->empty()) {
+    heap->PopMinimum();
+  }
+  CHECK(num_copies == 0) << factory.name() << ": " << num_copies;
+}
+
+// Checks that CompactWeakHeap::AddAll moves the keys in, into an empty and a
+// non-empty heap.
+void TestCompactWeakHeapAddAllMoves() {
+  CompactWeakHeap<CopyCountedInt> heap;
+  for (int round = 0; round < 2; ++round) {
+    std::vector<HeapElement<CopyCountedInt>> elements;
+    for (int i = 0; i < 1000; ++i) {
+      elements.emplace_back(CopyCountedInt(rand()), round * 1000 + i);
+    }
+    num_copies = 0;
+    heap.AddAll(std::move(elements));
+    CHECK(num_copies == 0) << num_copies;
+  }
+  heap.Validate();
+}
+
+// A move-only payload, ordered by its distance.
+struct Labels {
+  int distance;
+  std::unique_ptr<std::vector<int>> labels;
+};
+
+struct LabelsDistance {
+  int operator()(const Labels &payload) const { return payload.distance; }
+};
+
+// Checks that a PayloadHeap pops move-only payloads in order, intact.
+template <typename Id> void TestPayloadHeap(Factory<Heap<int, Id>> factory) {
+  const int n = 2000;
+  PayloadHeap<Labels, LabelsDistance, Id> heap(factory);
+  for (int i = 0; i < n; ++i) {
+    std::unique_ptr<std::vector<int>> labels(new std::vector<int>(3, i));
+    heap.Emplace(Id(i), Labels{rand() % n + n, std::move(labels)});
+  }
+  for (int i = 0; i < n; i += 3) {
+    std::unique_ptr<std::vector<int>> labels(new std::vector<int>(3, i));
+    heap.ReduceKey(
+        Labels{heap.LookUp(Id(i))->distance - n, std::move(labels)}, Id(i));
+  }
+  heap.Validate();
+  CHECK(heap.MinPayload().distance == heap.LookUp(heap.MinId())->distance);
+
+  int prev_distance = -1;
+  while (!heap.empty()) {
+    HeapElement<Labels, Id> min = heap.PopMinimum();
+    CHECK(prev_distance <= min.first.distance);
+    prev_distance = min.first.distance;
+    CHECK(*min.first.labels ==
+          std::vector<int>(3, static_cast<int>(min.second)));
+  }
+  heap.Validate();
+}
+
+// An object that holds its own entry in a heap, for HandleIdIndex.
+struct Job {
+  HeapHandle handle;
+};
+
+HeapHandle &HeapHandleOf(Job *job) { return job->handle; }
+
+// Checks random operations on a heap with the given ids against a map of the
+// expected keys.
+template <typename Id>
+void TestIds(Factory<Heap<int, Id>> factory, const std::vector<Id> &ids) {
+  const int num_operations = 5000;
+  auto heap = factory();
+  std::map<Id, int> expected;
+  for (int i = 0; i < num_operations; ++i) {
+    const Id id = ids[rand() % ids.size()];
+    auto it = expected.find(id);
+    const int op = rand() % 4;
+    if (it == expected.end()) {
+      const int key = rand() % 10000;
+      heap->Add(key, id);
+      expected.emplace(id, key);
+    } else if (op == 0) {
+      it->second -= rand() % 100;
+      heap->ReduceKey(it->second, id);
+    } else if (op == 1) {
+      it->second += rand() % 100;
+      heap->IncreaseKey(it->second, id);
+    } else if (op == 2) {
+      heap->Remove(id);
+      expected.erase(it);
+      CHECK(heap->LookUp(id) == nullptr);
+    } else {
+      HeapElement<int, Id> min = heap->PopMinimum();
+      auto min_it = expected.find(min.second);
+      CHECK(min_it != expected.end());
+      CHECK(min_it->second == min.first);
+      for (const auto &entry : expected) {
+        CHECK(min.first <= entry.second);
+      }
+      expected.erase(min_it);
+    }
+    CHECK(heap->size() == static_cast<int>(expected.size()));
+  }
+  heap->Validate();
+  for (const auto &entry : expected) {
+    CHECK(*heap->LookUp(entry.first) == entry.second) << factory.name();
+  }
+  int prev_key = std::numeric_limits<int>::min();
+  while (!heap->empty()) {
+    HeapElement<int, Id> min = heap->PopMinimum();
+    CHECK(prev_key <= min.first);
+    prev_key = min.first;
+    CHECK(expected.erase(min.second) == 1);
+  }
+  CHECK(expected.empty());
+}
+
+// Returns the factories of the heaps with the given ids.
+template <typename Ids>
+std::vector<Factory<Heap<int, typename Ids::Id>>> IdsHeapFactories() {
+  return {BinaryHeap<int, false, Ids>::factory(),
+          DaryHeap<int, 4, Ids>::factory(),
+          BHeap<int, 2, Ids>::factory(),
+          BinomialHeap<int, Ids>::factory(),
+          IndirectBinomialHeap<int, false, Ids>::factory(),
+          IndirectBinomialHeap<int, true, Ids>::factory(),
+          WeakHeap<int, Ids>::factory(),
+          CompactWeakHeap<int, Ids>::factory(),
+          PairingHeap<int, TwoPassPairing, false, Ids>::factory(),
+          PairingHeap<int, MultipassPairing, true, Ids>::factory(),
+          CompactPairingHeap<int, Ids>::factory(),
+          TwoThreeHeap<int, Ids>::factory(),
+          FlatTwoThreeHeap<int, Ids>::factory(),
+          FibonacciHeap<int, Ids>::factory(),
+          ThinHeap<int, Ids>::factory()};
+}
+
+// Runs the heaps with 64-bit ids in both hash indexes, dense int ids and
+// handle ids.
+void TestIdTypes() {
+  const int num_ids = 300;
+  std::vector<uint64_t> large_ids;
+  std::vector<int> dense_ids;
+  std::vector<Job> jobs(num_ids);
+  std::vector<Job *> job_ids;
+  for (int i = 0; i < num_ids; ++i) {
+    large_ids.push_back((uint64_t{1} << 40) +
+                        static_cast<uint64_t>(i) * 0x9e3779b9);
+    dense_ids.push_back(i);
+    job_ids.push_back(&jobs[i]);
+  }
+  for (const auto &factory : IdsHeapFactories<HeapIds<uint64_t>>()) {
+    TestIds(factory, large_ids);
+  }
+  for (const auto &factory :
+       IdsHeapFactories<HeapIds<uint64_t, HashIdIndex>>()) {
+    TestIds(factory, large_ids);
+  }
+  for (const auto &factory : IdsHeapFactories<HeapIds<int, DenseIdIndex>>()) {
+    TestIds(factory, dense_ids);
+  }
+  for (const auto &factory :
+       IdsHeapFactories<HeapIds<Job *, HandleIdIndex>>()) {
+    TestIds(factory, job_ids);
+  }
+  for (const auto &job : jobs) {
+    CHECK(!job.handle.in_heap());
+  }
+
+  // TakeElements() must take the elements out of the callers' handles too.
+  BinaryHeap<int, false, HeapIds<Job *, HandleIdIndex>> binary_heap;
+  PairingHeap<int, TwoPassPairing, true, HeapIds<Job *, HandleIdIndex>>
+      pairing_heap;
+  for (int i = 0; i < num_ids; ++i) {
+    if (i % 2 == 0) {
+      binary_heap.Add(rand() % 10000, job_ids[i]);
+    } else {
+      pairing_heap.Add(rand() % 10000, job_ids[i]);
+    }
+  }
+  CHECK(binary_heap.TakeElements().size() == (num_ids + 1) / 2);
+  CHECK(pairing_heap.TakeElements().size() == num_ids / 2);
+  CHECK(binary_heap.empty() && pairing_heap.empty());
+  for (const auto &job : jobs) {
+    CHECK(!job.handle.in_heap());
+  }
+}
+
+// Checks random operations on a heap ordered by Compare, which reduces a key
+// by moving it towards the top, against a map of the expected keys.
+template <typename Compare> void TestCompare(Factory<Heap<int>> factory) {
+  const int num_ids = 300;
+  const int num_operations = 5000;
+  const Compare compare;
+  auto heap = factory();
+  std::map<int, int> expected;
+  for (int i = 0; i < num_operations; ++i) {
+    const int id = rand() % num_ids;
+    auto it = expected.find(id);
+    const int op = rand() % 4;
+    const int delta = rand() % 100;
+    if (it == expected.end()) {
+      const int key = rand() % 10000;
+      heap->Add(key, id);
+      expected.emplace(id, key);
+    } else if (op == 0) {
+      it->second += compare(0, delta) ? -delta : delta;
+      heap->ReduceKey(it->second, id);
+    } else if (op == 1) {
+      it->second += compare(0, delta) ? delta : -delta;
+      heap->IncreaseKey(it->second, id);
+    } else if (op == 2) {
+      heap->Remove(id);
+      expected.erase(it);
+    } else {
+      HeapElement<int> min = heap->PopMinimum();
+      CHECK(expected[min.second] == min.first) << factory.name();
+      for (const auto &entry : expected) {
+        CHECK(!compare(entry.second, min.first)) << factory.name();
+      }
+      expected.erase(min.second);
+    }
+  }
+  heap->Validate();
+  while (!heap->empty()) {
+    HeapElement<int> min = heap->PopMinimum();
+    for (const auto &entry : expected) {
+      CHECK(!compare(entry.second, min.first)) << factory.name();
+    }
+    CHECK(expected.erase(min.second) == 1);
+  }
+  CHECK(expected.empty());
+}
+
+// Returns the factories of the heaps ordered by Compare.
+template <typename Compare>
+std::vector<Factory<Heap<int>>> CompareHeapFactories() {
+  using Ids = HeapIds<>;
+  return {BinaryHeap<int, false, Ids, Compare>::factory(),
+          BinaryHeap<int, true, Ids, Compare>::factory(),
+          DaryHeap<int, 4, Ids, Compare>::factory(),
+          DaryHeap<int, 16, Ids, Compare>::factory(),
+          BHeap<int, 2, Ids, Compare>::factory(),
+          BinomialHeap<int, Ids, Compare>::factory(),
+          IndirectBinomialHeap<int, false, Ids, Compare>::factory(),
+          IndirectBinomialHeap<int, true, Ids, Compare>::factory(),
+          WeakHeap<int, Ids, Compare>::factory(),
+          CompactWeakHeap<int, Ids, Compare>::factory(),
+          PairingHeap<int, TwoPassPairing, false, Ids, Compare>::factory(),
+          PairingHeap<int, MultipassPairing, true, Ids, Compare>::factory(),
+          CompactPairingHeap<int, Ids, Compare>::factory(),
+          TwoThreeHeap<int, Ids, Compare>::factory(),
+          FlatTwoThreeHeap<int, Ids, Compare>::factory(),
+          FibonacciHeap<int, Ids, Compare>::factory(),
+          ThinHeap<int, Ids, Compare>::factory(),
+          AdaptiveHeap<int, Compare>::factory()};
+}
+
 // Run all tests on heaps created by the given heap factory.
 void RunTests(Factory<Heap<int>> factory) {
   std::srand(kRandomSeed);
@@ -220,20 +906,96 @@ void RunTests(Factory<Heap<int>> factory) {
     HeapTester<int> tester(factory());
     tester.TestRandomOperations(num_elements, num_operations);
   }
+  {
+    const int num_elements = 500;
+    const int num_operations = 3000;
+    HeapTester<int> tester(factory());
+    tester.TestRemoveAndIncreaseKey(num_elements, num_operations);
+  }
+  TestTraceReplay(factory);
+  TestDijkstraWorkload(factory);
 }
 
 // Run heap tests for all the heap implementations.
 void RunAllHeapTests() {
   std::vector<Factory<Heap<int>>> heap_factories{
-      BinaryHeap<int>::factory(),   BinomialHeap<int>::factory(),
-      WeakHeap<int>::factory(),     PairingHeap<int>::factory(),
-      TwoThreeHeap<int>::factory(), FibonacciHeap<int>::factory(),
-      ThinHeap<int>::factory()};
+      BinaryHeap<int>::factory(),   BinaryHeap<int, true>::factory(),
+      DaryHeap<int, 4>::factory(),  DaryHeap<int, 8>::factory(),
+      DaryHeap<int, 16>::factory(), BHeap<int>::factory(),
+      BHeap<int, 2>::factory(),
+      BinomialHeap<int>::factory(),
+      IndirectBinomialHeap<int>::factory(),
+      IndirectBinomialHeap<int, true>::factory(),
+      WeakHeap<int>::factory(),     CompactWeakHeap<int>::factory(),
+      PairingHeap<int>::factory(),
+      PairingHeap<int, MultipassPairing>::factory(),
+      PairingHeap<int, FrontToBackPairing>::factory(),
+      PairingHeap<int, BackToFrontPairing>::factory(),
+      PairingHeap<int, TwoPassPairing, true>::factory(),
+      PairingHeap<int, MultipassPairing, true>::factory(),
+      CompactPairingHeap<int>::factory(),
+      TwoThreeHeap<int>::factory(), FlatTwoThreeHeap<int>::factory(),
+      FibonacciHeap<int>::factory(), ThinHeap<int>::factory()};
 
   for (const auto &factory : heap_factories) {
     LOG(INFO) << "Testing " << factory.name();
     RunTests(factory);
   }
+
+  // Small samples and thresholds, so the heap switches back and forth
+  // between implementations during the tests.
+  AdaptiveHeapThresholds thresholds;
+  thresholds.sample_interval = 50;
+  thresholds.samples_to_switch = 1;
+  thresholds.pairing_reduce_key_fractions = {{1, 2}, {100, 0.3}};
+  LOG(INFO) << "Testing Adaptive Heap";
+  RunTests(AdaptiveHeap<int>::factory(thresholds));
+  TestAdaptiveHeapSwitches(thresholds);
+
+  LOG(INFO) << "Testing Weak-heapsort";
+  TestWeakHeapSort();
+  TestCompactWeakHeapAddAll();
+  LOG(INFO) << "Testing Binary Heap (bottom-up) comparisons";
+  TestBinaryHeapBottomUp();
+  LOG(INFO) << "Testing D-ary Heap minimum child scan";
+  TestDaryHeapMinIndex<4>();
+  TestDaryHeapMinIndex<8>();
+  TestDaryHeapMinIndex<16>();
+  LOG(INFO) << "Testing Flat 2-3 Heap against 2-3 Heap";
+  TestFlatTwoThreeHeap();
+  LOG(INFO) << "Testing key moves";
+  std::vector<Factory<Heap<CopyCountedInt>>> move_factories{
+      BinaryHeap<CopyCountedInt>::factory(),
+      BinaryHeap<CopyCountedInt, true>::factory(),
+      DaryHeap<CopyCountedInt, 4>::factory(),
+      BHeap<CopyCountedInt>::factory(),
+      BinomialHeap<CopyCountedInt>::factory(),
+      IndirectBinomialHeap<CopyCountedInt>::factory(),
+      IndirectBinomialHeap<CopyCountedInt, true>::factory(),
+      WeakHeap<CopyCountedInt>::factory(),
+      CompactWeakHeap<CopyCountedInt>::factory(),
+      PairingHeap<CopyCountedInt>::factory(),
+      PairingHeap<CopyCountedInt, TwoPassPairing, true>::factory(),
+      CompactPairingHeap<CopyCountedInt>::factory(),
+      TwoThreeHeap<CopyCountedInt>::factory(),
+      FlatTwoThreeHeap<CopyCountedInt>::factory(),
+      FibonacciHeap<CopyCountedInt>::factory(),
+      ThinHeap<CopyCountedInt>::factory(),
+      AdaptiveHeap<CopyCountedInt>::factory()};
+  for (const auto &factory : move_factories) {
+    TestKeyMoves(factory);
+  }
+  TestCompactWeakHeapAddAllMoves();
+  LOG(INFO) << "Testing id types";
+  TestIdTypes();
+  LOG(INFO) << "Testing comparators";
+  for (const auto &factory : CompareHeapFactories<std::greater<int>>()) {
+    TestCompare<std::greater<int>>(factory);
+  }
+  LOG(INFO) << "Testing Payload Heap";
+  TestPayloadHeap(BinaryHeap<int>::factory());
+  TestPayloadHeap(PairingHeap<int>::factory());
+  TestPayloadHeap(BinaryHeap<int, false, HeapIds<uint64_t>>::factory());
   LOG(INFO) << "Done";
 }
 
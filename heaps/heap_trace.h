@@ -0,0 +1,308 @@
+// Recording and replay of heap operation traces.
+//
+// A RecordingHeap wraps any Heap and logs its operations to a compact binary
+// trace. ReadHeapTrace loads a trace into memory, and ReplayHeapTrace drives
+// another heap through the same operations without any logging overhead.
+
+#ifndef HEAPS_HEAP_TRACE_H_
+#define HEAPS_HEAP_TRACE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "heaps/heap.h"
+
+// Heap operations recorded in a trace.
+enum class HeapOperation : uint8_t {
+  kAdd = 0,
+  kReduceKey = 1,
+  kPopMinimum = 2,
+  kLookUp = 3,
+  kIncreaseKey = 4,
+  kRemove = 5,
+};
+
+// A recorded heap operation. `key` is only meaningful for kAdd, kReduceKey
+// and kIncreaseKey, and `id` is unused for kPopMinimum.
+template <typename T> struct HeapTraceOp {
+  HeapOperation operation;
+  int id;
+  T key;
+};
+
+// A trace loaded in memory.
+template <typename T> using HeapTrace = std::vector<HeapTraceOp<T>>;
+
+namespace heap_trace_internal {
+
+// Trace file header: magic, format version, sizeof(T).
+const char kMagic[4] = {'H', 'T', 'R', 'C'};
+const uint8_t kVersion = 1;
+
+inline void WriteVarint(uint64_t value, std::ostream *out) {
+  while (value >= 0x80) {
+    out->put(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->put(static_cast<char>(value));
+}
+
+inline bool ReadVarint(std::istream *in, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = in->get();
+    if (byte == EOF) {
+      return false;
+    }
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ (value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Integral keys are written as zigzag varints.
+template <typename T>
+void WriteKey(const T &key, std::ostream *out, std::true_type /*integral*/) {
+  WriteVarint(ZigZagEncode(static_cast<int64_t>(key)), out);
+}
+
+template <typename T>
+bool ReadKey(std::istream *in, T *key, std::true_type /*integral*/) {
+  uint64_t value;
+  if (!ReadVarint(in, &value)) {
+    return false;
+  }
+  *key = static_cast<T>(ZigZagDecode(value));
+  return true;
+}
+
+// Other keys are written as raw bytes.
+template <typename T>
+void WriteKey(const T &key, std::ostream *out, std::false_type /*integral*/) {
+  out->write(reinterpret_cast<const char *>(&key), sizeof(T));
+}
+
+template <typename T>
+bool ReadKey(std::istream *in, T *key, std::false_type /*integral*/) {
+  return static_cast<bool>(in->read(reinterpret_cast<char *>(key), sizeof(T)));
+}
+
+} // namespace heap_trace_internal
+
+// Writes heap operations as a compact binary trace.
+//
+// After a header, each operation is one byte for the operation type, the
+// id as a zigzag varint delta from the previous id, and for kAdd, kReduceKey
+// and kIncreaseKey, the key. Keys must be trivially copyable; integral keys are
+// varint encoded, and others are written as raw bytes.
+template <typename T> class HeapTraceWriter {
+public:
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Trace keys must be trivially copyable");
+
+  explicit HeapTraceWriter(std::ostream *out) : out_(out), last_id_(0) {
+    out_->write(heap_trace_internal::kMagic,
+                sizeof(heap_trace_internal::kMagic));
+    out_->put(static_cast<char>(heap_trace_internal::kVersion));
+    out_->put(static_cast<char>(sizeof(T)));
+  }
+
+  // Appends an operation to the trace.
+  void Write(HeapOperation operation, int id, const T *key);
+
+private:
+  std::ostream *out_;
+  int last_id_;
+};
+
+template <typename T>
+void HeapTraceWriter<T>::Write(HeapOperation operation, int id, const T *key) {
+  out_->put(static_cast<char>(operation));
+  if (operation == HeapOperation::kPopMinimum) {
+    return;
+  }
+  heap_trace_internal::WriteVarint(
+      heap_trace_internal::ZigZagEncode(static_cast<int64_t>(id) - last_id_),
+      out_);
+  last_id_ = id;
+  if (key != nullptr) {
+    heap_trace_internal::WriteKey(*key, out_, std::is_integral<T>{});
+  }
+}
+
+// Reads a whole trace written by HeapTraceWriter. Returns false if the input
+// is not a valid trace for keys of type T.
+template <typename T>
+bool ReadHeapTrace(std::istream *in, HeapTrace<T> *trace) {
+  char magic[sizeof(heap_trace_internal::kMagic)];
+  if (!in->read(magic, sizeof(magic)) ||
+      std::memcmp(magic, heap_trace_internal::kMagic, sizeof(magic)) != 0 ||
+      in->get() != heap_trace_internal::kVersion ||
+      in->get() != static_cast<int>(sizeof(T))) {
+    return false;
+  }
+
+  int last_id = 0;
+  int operation;
+  while ((operation = in->get()) != EOF) {
+    HeapTraceOp<T> op;
+    op.operation = static_cast<HeapOperation>(operation);
+    op.id = -1;
+    op.key = T();
+    if (op.operation != HeapOperation::kPopMinimum) {
+      uint64_t delta;
+      if (!heap_trace_internal::ReadVarint(in, &delta)) {
+        return false;
+      }
+      op.id = last_id +
+              static_cast<int>(heap_trace_internal::ZigZagDecode(delta));
+      last_id = op.id;
+    }
+    switch (op.operation) {
+    case HeapOperation::kAdd:
+    case HeapOperation::kReduceKey:
+    case HeapOperation::kIncreaseKey:
+      if (!heap_trace_internal::ReadKey(in, &op.key, std::is_integral<T>{})) {
+        return false;
+      }
+      break;
+    case HeapOperation::kPopMinimum:
+    case HeapOperation::kLookUp:
+    case HeapOperation::kRemove:
+      break;
+    default:
+      return false;
+    }
+    trace->push_back(op);
+  }
+  return true;
+}
+
+// Applies one traced operation to `heap`. If `popped` is not null, a popped
+// element is appended to it. Returns 1 if a looked up id was found, else 0.
+template <typename T>
+int ReplayHeapOp(const HeapTraceOp<T> &op, Heap<T> *heap,
+                 std::vector<HeapElement<T>> *popped = nullptr) {
+  switch (op.operation) {
+  case HeapOperation::kAdd:
+    heap->Add(op.key, op.id);
+    break;
+  case HeapOperation::kReduceKey:
+    heap->ReduceKey(op.key, op.id);
+    break;
+  case HeapOperation::kPopMinimum:
+    if (popped != nullptr) {
+      popped->push_back(heap->PopMinimum());
+    } else {
+      heap->PopMinimum();
+    }
+    break;
+  case HeapOperation::kLookUp:
+    return heap->LookUp(op.id) != nullptr;
+  case HeapOperation::kIncreaseKey:
+    heap->IncreaseKey(op.key, op.id);
+    break;
+  case HeapOperation::kRemove:
+    heap->Remove(op.id);
+    break;
+  }
+  return 0;
+}
+
+// Drives `heap` through the operations of `trace`. If `popped` is not null,
+// the popped elements are appended to it. Returns the number of lookups that
+// found their id, so that the lookups are not optimized away.
+template <typename T>
+long ReplayHeapTrace(const HeapTrace<T> &trace, Heap<T> *heap,
+                     std::vector<HeapElement<T>> *popped = nullptr) {
+  long num_found = 0;
+  for (const auto &op : trace) {
+    num_found += ReplayHeapOp(op, heap, popped);
+  }
+  return num_found;
+}
+
+// A Heap decorator that records the operations on the wrapped heap.
+template <typename T> class RecordingHeap : public Heap<T> {
+public:
+  RecordingHeap(std::unique_ptr<Heap<T>> heap, HeapTraceWriter<T> *writer)
+      : heap_(std::move(heap)), writer_(writer) {}
+
+  // A factory for heaps that record to `writer`. The writer must outlive the
+  // heaps.
+  static Factory<Heap<T>> factory(Factory<Heap<T>> heap_factory,
+                                  HeapTraceWriter<T> *writer) {
+    return Factory<Heap<T>>(
+        "Recording " + heap_factory.name(), [heap_factory, writer]() {
+          return new RecordingHeap<T>(heap_factory(), writer);
+        });
+  }
+
+  virtual int size() const override { return heap_->size(); }
+
+  virtual void Add(T key, int id) override {
+    writer_->Write(HeapOperation::kAdd, id, &key);
+    heap_->Add(std::move(key), id);
+  }
+
+  virtual void ReduceKey(T new_key, int id) override {
+    writer_->Write(HeapOperation::kReduceKey, id, &new_key);
+    heap_->ReduceKey(std::move(new_key), id);
+  }
+
+  virtual void IncreaseKey(T new_key, int id) override {
+    writer_->Write(HeapOperation::kIncreaseKey, id, &new_key);
+    heap_->IncreaseKey(std::move(new_key), id);
+  }
+
+  virtual void Remove(int id) override {
+    writer_->Write(HeapOperation::kRemove, id, nullptr);
+    heap_->Remove(id);
+  }
+
+  virtual const T *LookUp(int id) const override {
+    writer_->Write(HeapOperation::kLookUp, id, nullptr);
+    return heap_->LookUp(id);
+  }
+
+  virtual HeapElement<T> Min() const override { return heap_->Min(); }
+
+  virtual HeapElement<T> PopMinimum() override {
+    writer_->Write(HeapOperation::kPopMinimum, -1, nullptr);
+    return heap_->PopMinimum();
+  }
+
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override {
+    heap_->PrintTree(out, label);
+  }
+
+  virtual void Validate() const override { heap_->Validate(); }
+
+  virtual HeapStats Stats() const override { return heap_->Stats(); }
+
+  virtual long MemoryUsage() const override { return heap_->MemoryUsage(); }
+
+private:
+  std::unique_ptr<Heap<T>> heap_;
+  HeapTraceWriter<T> *writer_;
+};
+
+#endif /* HEAPS_HEAP_TRACE_H_ */
@@ -0,0 +1,226 @@
+// Id indexes for heaps.
+//
+// A heap keeps an index from the id of each element to where the element is:
+// its position in an array, or its node. The heaps take the type of the ids
+// and the kind of index as a HeapIds parameter, e.g.
+// `BinaryHeap<T, false, HeapIds<uint64_t>>`. An index is a
+// `template <typename Id, typename V> class` with the methods of HashIdIndex:
+// * FlatHashIdIndex hashes the ids into a FlatHashMap, so they can be of any
+//   hashable type, e.g. 64-bit object ids. This is the default.
+// * HashIdIndex hashes the ids into a std::unordered_map, with one
+//   allocation per id.
+// * DenseIdIndex is a vector indexed by the ids, which must be small
+//   non-negative integers, e.g. vertex ids.
+// * HandleIdIndex keeps no index. The ids are pointers to the caller's
+//   objects, and each object holds a HeapHandle for the heap's entry.
+
+#ifndef HEAPS_ID_INDEX_H_
+#define HEAPS_ID_INDEX_H_
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/flat_hash_map.h"
+#include "base/memory.h"
+
+// An index of ids in a flat hash map, with the methods of HashIdIndex.
+template <typename Id, typename V> using FlatHashIdIndex = FlatHashMap<Id, V>;
+
+// An index of ids in a std::unordered_map.
+template <typename Id, typename V> class HashIdIndex {
+public:
+  // Returns the number of ids.
+  int size() const { return static_cast<int>(map_.size()); }
+
+  // Returns the value of an id, or nullptr if it is not in the index.
+  V *Find(Id id) {
+    auto it = map_.find(id);
+    return it == map_.end() ? nullptr : &it->second;
+  }
+  const V *Find(Id id) const {
+    auto it = map_.find(id);
+    return it == map_.end() ? nullptr : &it->second;
+  }
+
+  // Adds an id with its value. Returns false if the id is already in the
+  // index.
+  bool Insert(Id id, V value) { return map_.emplace(id, value).second; }
+
+  // Sets the value of an id in the index.
+  void Set(Id id, V value) { map_[id] = value; }
+
+  // Removes an id in the index.
+  void Erase(Id id) { map_.erase(id); }
+
+  // Reserves room for `size` ids.
+  void Reserve(int size) { map_.reserve(size); }
+
+  // Returns the approximate bytes allocated by the index.
+  long MemoryUsage() const { return ContainerMemoryUsage(map_); }
+
+private:
+  std::unordered_map<Id, V> map_;
+};
+
+// An index of small non-negative integer ids in a vector. It takes memory
+// for every id up to the largest one.
+template <typename Id, typename V> class DenseIdIndex {
+public:
+  static_assert(std::is_integral<Id>::value, "Dense ids must be integers");
+
+  DenseIdIndex() : size_(0) {}
+
+  int size() const { return size_; }
+
+  V *Find(Id id) {
+    return Contains_(id) ? &values_[static_cast<size_t>(id)] : nullptr;
+  }
+  const V *Find(Id id) const {
+    return Contains_(id) ? &values_[static_cast<size_t>(id)] : nullptr;
+  }
+
+  bool Insert(Id id, V value) {
+    CHECK(id >= 0);
+    const size_t pos = static_cast<size_t>(id);
+    if (pos >= values_.size()) {
+      values_.resize(pos + 1);
+      present_.resize(pos + 1);
+    }
+    if (present_[pos]) {
+      return false;
+    }
+    values_[pos] = value;
+    present_[pos] = 1;
+    size_++;
+    return true;
+  }
+
+  void Set(Id id, V value) {
+    DCHECK(Contains_(id));
+    values_[static_cast<size_t>(id)] = value;
+  }
+
+  void Erase(Id id) {
+    DCHECK(Contains_(id));
+    present_[static_cast<size_t>(id)] = 0;
+    size_--;
+  }
+
+  void Reserve(int size) {
+    values_.reserve(size);
+    present_.reserve(size);
+  }
+
+  long MemoryUsage() const {
+    return ContainerMemoryUsage(values_) + ContainerMemoryUsage(present_);
+  }
+
+private:
+  bool Contains_(Id id) const {
+    return id >= 0 && static_cast<size_t>(id) < present_.size() &&
+           present_[static_cast<size_t>(id)];
+  }
+
+  // The value of each id, valid if the id is present.
+  std::vector<V> values_;
+
+  // Whether each id is in the index.
+  std::vector<uint8_t> present_;
+
+  int size_;
+};
+
+// The entry of a heap element, held by the caller's object. The object is in
+// at most one heap at a time through each of its handles.
+class HeapHandle {
+public:
+  HeapHandle() : in_heap_(false) {}
+
+  // Returns true if the object is in a heap.
+  bool in_heap() const { return in_heap_; }
+
+private:
+  template <typename, typename> friend class HandleIdIndex;
+
+  // Room for the heap's entry: an array position, a node index or a pointer.
+  alignas(8) unsigned char entry_[8];
+
+  bool in_heap_;
+};
+
+// An index that is kept in the caller's objects. Each id is a pointer to an
+// object, and `HeapHandleOf(id)`, found by argument dependent lookup, returns
+// a reference to its HeapHandle. Looking up an id then reads the object
+// instead of a map.
+template <typename Id, typename V> class HandleIdIndex {
+public:
+  static_assert(std::is_pointer<Id>::value, "Handle ids must be pointers");
+  static_assert(sizeof(V) <= sizeof(HeapHandle::entry_) &&
+                    std::is_trivially_copyable<V>::value,
+                "The entry must fit in a HeapHandle");
+
+  HandleIdIndex() : size_(0) {}
+
+  int size() const { return size_; }
+
+  V *Find(Id id) {
+    HeapHandle &handle = HeapHandleOf(id);
+    return handle.in_heap_ ? Entry_(&handle) : nullptr;
+  }
+  const V *Find(Id id) const {
+    HeapHandle &handle = HeapHandleOf(id);
+    return handle.in_heap_ ? Entry_(&handle) : nullptr;
+  }
+
+  bool Insert(Id id, V value) {
+    HeapHandle &handle = HeapHandleOf(id);
+    if (handle.in_heap_) {
+      return false;
+    }
+    new (handle.entry_) V(value);
+    handle.in_heap_ = true;
+    size_++;
+    return true;
+  }
+
+  void Set(Id id, V value) {
+    HeapHandle &handle = HeapHandleOf(id);
+    DCHECK(handle.in_heap_);
+    *Entry_(&handle) = value;
+  }
+
+  void Erase(Id id) {
+    HeapHandle &handle = HeapHandleOf(id);
+    DCHECK(handle.in_heap_);
+    handle.in_heap_ = false;
+    size_--;
+  }
+
+  void Reserve(int size) {}
+
+  long MemoryUsage() const { return 0; }
+
+private:
+  static V *Entry_(HeapHandle *handle) {
+    return reinterpret_cast<V *>(handle->entry_);
+  }
+
+  int size_;
+};
+
+// The ids of the elements of a heap: their type, and the kind of index from
+// each id to its element. A template parameter of the heaps.
+template <typename IdType = int,
+          template <typename, typename> class IndexType = FlatHashIdIndex>
+struct HeapIds {
+  using Id = IdType;
+
+  // An index from the ids to values of type V.
+  template <typename V> using Index = IndexType<IdType, V>;
+};
+
+#endif /* HEAPS_ID_INDEX_H_ */
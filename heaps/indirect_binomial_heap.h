@@ -0,0 +1,489 @@
+// Indirect Binomial Heap.
+//
+// A Binomial Heap whose nodes point to the elements, instead of holding them.
+// Sifting a reduced key up moves the pointers between nodes, and fixes up
+// each moved element's pointer back to its node, so the id index is only
+// looked up once per ReduceKey, and never written. The index maps each id to
+// its element, which the heap allocates.
+//
+// With kLazy, Add and ReduceKey only put trees on the root list, and the
+// roots are consolidated by PopMinimum.
+
+#ifndef HEAPS_INDIRECT_BINOMIAL_HEAP_H_
+#define HEAPS_INDIRECT_BINOMIAL_HEAP_H_
+
+#include <functional>
+#include <iostream>
+#include <unordered_set>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/binomial_heap.h"
+#include "heaps/heap.h"
+#include "heaps/id_index.h"
+
+template <typename T, typename Id, typename Compare>
+struct IndirectBinomialHeapEntry;
+
+// The key of a node in an Indirect Binomial Heap: a pointer to the element,
+// compared by the element's key.
+template <typename T, typename Id, typename Compare>
+struct IndirectBinomialHeapKey {
+  IndirectBinomialHeapEntry<T, Id, Compare> *entry;
+
+  bool operator<(const IndirectBinomialHeapKey<T, Id, Compare> &other) const {
+    return Compare()(entry->key, other.entry->key);
+  }
+};
+
+template <typename T, typename Id, typename Compare>
+std::ostream &operator<<(std::ostream &out,
+                         const IndirectBinomialHeapKey<T, Id, Compare> &key) {
+  return out << key.entry->key;
+}
+
+// An element of an Indirect Binomial Heap. Allocated by the heap, so that it
+// does not move when the id index grows.
+template <typename T, typename Id, typename Compare>
+struct IndirectBinomialHeapEntry {
+  T key;
+  Id id;
+
+  // The node that points to this element.
+  BinomialHeapNode<IndirectBinomialHeapKey<T, Id, Compare>, Id> *node;
+};
+
+template <typename T, bool kLazy = false, typename Ids = HeapIds<>,
+          typename Compare = std::less<T>>
+class IndirectBinomialHeap : public Heap<T, typename Ids::Id> {
+public:
+  using Id = typename Ids::Id;
+
+  IndirectBinomialHeap() : root_(nullptr), min_root_(nullptr) {}
+  ~IndirectBinomialHeap() { DeleteTree_(root_); }
+
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        kLazy ? "Lazy Binomial Heap" : "Indirect Binomial Heap",
+        []() { return new IndirectBinomialHeap{}; });
+  }
+
+  // Returns number of elements.
+  virtual int size() const override {
+    return static_cast<int>(id_to_entry_.size());
+  }
+
+  // Adds an element with given key and unique id.
+  virtual void Add(T key, Id id) override;
+
+  // Updates with a lower key.
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
+
+  // Looks up a key by id. Returns nullptr if not found.
+  virtual const T *LookUp(Id id) const override;
+
+  // Returns the min element.
+  virtual HeapElement<T, Id> Min() const override;
+
+  // Pops and returns the minimum key.
+  virtual HeapElement<T, Id> PopMinimum() override;
+
+  // Print for debugging.
+  virtual void PrintTree(std::ostream &out,
+                         const std::string &label) const override;
+
+  // Validate the invariants.
+  virtual void Validate() const override;
+
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return size() * (AllocationSize(sizeof(Node)) +
+                     AllocationSize(sizeof(Entry))) +
+           id_to_entry_.MemoryUsage();
+  }
+
+private:
+  using Key = IndirectBinomialHeapKey<T, Id, Compare>;
+  using Entry = IndirectBinomialHeapEntry<T, Id, Compare>;
+  using Node = BinomialHeapNode<Key, Id>;
+
+  // Deletes the tree rooted at `node` and its elements.
+  static void DeleteTree_(Node *node);
+
+  // Moves the element of `node` up while it is smaller than its parent's, or
+  // to the root if `to_root`. Returns the node it ends in.
+  Node *SiftUp_(Node *node, bool to_root = false);
+
+  // Moves the element of `node` down while it is larger than a child's.
+  void SiftDown_(Node *node);
+
+  // Removes `root`, whose previous sibling is `prev_node`, from the root list,
+  // merges its children into the root list and returns its element.
+  HeapElement<T, Id> RemoveRoot_(Node *root, Node *prev_node);
+
+  // Returns the root with the minimum key, and sets its previous sibling.
+  Node *Min_(Node **prev_node) const;
+
+  // Merges the roots of equal dimension until all differ, and sorts the root
+  // list by ascending dimension. Sets min_root_.
+  void Consolidate_();
+
+  // Linked list of root nodes. In ascending dimension, except with kLazy
+  // between a change and the next PopMinimum.
+  Node *root_;
+
+  // With kLazy, the root with the minimum key. Maybe null.
+  Node *min_root_;
+
+  // Map of each id to its element.
+  typename Ids::template Index<Entry *> id_to_entry_;
+};
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::DeleteTree_(Node *node) {
+  if (node != nullptr) {
+    DeleteTree_(node->child());
+    DeleteTree_(node->right());
+    delete node->key().entry;
+    delete node;
+  }
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::Add(T key, Id id) {
+  Entry *entry = new Entry{std::move(key), id, nullptr};
+  CHECK(id_to_entry_.Insert(id, entry));
+  Node *node = new Node{Key{entry}, id};
+  entry->node = node;
+  this->AddStat_(&HeapStats::adds);
+
+  if (kLazy) {
+    node->set_right(root_);
+    root_ = node;
+    if (min_root_ == nullptr || node->key() < min_root_->key()) {
+      min_root_ = node;
+    }
+  } else if (root_ == nullptr) {
+    // If no root. Make this the root.
+    root_ = node;
+  } else {
+    root_ = Node::AddToTreeList(node, root_);
+  }
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  Entry *entry = *id_to_entry_.Find(id);
+  DCHECK(!Compare()(entry->key, new_key));
+  entry->key = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
+
+  Node *node = SiftUp_(entry->node);
+  if (kLazy && node->is_root() && node->key() < min_root_->key()) {
+    min_root_ = node;
+  }
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::IncreaseKey(T new_key,
+                                                               Id id) {
+  Entry **found = id_to_entry_.Find(id);
+  CHECK(found != nullptr);
+  Entry *entry = *found;
+  CHECK(!Compare()(new_key, entry->key));
+  entry->key = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+
+  Node *node = entry->node;
+  SiftDown_(node);
+  if (kLazy && node == min_root_) {
+    // The minimum root may have grown larger than another root.
+    for (auto *root = root_; root != nullptr; root = root->right()) {
+      if (root->key() < min_root_->key()) {
+        min_root_ = root;
+      }
+    }
+  }
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::Remove(Id id) {
+  Entry **found = id_to_entry_.Find(id);
+  CHECK(found != nullptr);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the element to the root of its tree, and remove the root.
+  Node *root = SiftUp_((*found)->node, /*to_root=*/true);
+  Node *prev_node = nullptr;
+  for (auto *node = root_; node != root; node = node->right()) {
+    prev_node = node;
+  }
+  RemoveRoot_(root, prev_node);
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+const T *IndirectBinomialHeap<T, kLazy, Ids, Compare>::LookUp(Id id) const {
+  const Entry *const *entry = id_to_entry_.Find(id);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  return &(*entry)->key;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+IndirectBinomialHeap<T, kLazy, Ids, Compare>::Min() const {
+  const Entry *entry;
+  if (kLazy) {
+    DCHECK(size() > 0);
+    entry = min_root_->key().entry;
+  } else {
+    Node *unused_node;
+    entry = Min_(&unused_node)->key().entry;
+  }
+  return std::make_pair(entry->key, entry->id);
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+typename IndirectBinomialHeap<T, kLazy, Ids, Compare>::Node *
+IndirectBinomialHeap<T, kLazy, Ids, Compare>::Min_(Node **prev_node) const {
+  DCHECK(size() > 0);
+
+  Node *prev = root_;
+  Node *min_root = root_;
+  Node *min_root_prev = nullptr;
+  if (kLazy) {
+    // Find the previous sibling of min_root_, so that ties pop the element
+    // Min() returned.
+    min_root = min_root_;
+    for (auto *root = root_; root != min_root_; root = root->right()) {
+      min_root_prev = root;
+    }
+    *prev_node = min_root_prev;
+    return min_root;
+  }
+  for (auto *root = root_->right(); root != nullptr;
+       prev = root, root = root->right()) {
+    if (root->key() < min_root->key()) {
+      min_root = root;
+      min_root_prev = prev;
+    }
+  }
+  *prev_node = min_root_prev;
+  return min_root;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+IndirectBinomialHeap<T, kLazy, Ids, Compare>::PopMinimum() {
+  Node *prev_node;
+  Node *min_root = Min_(&prev_node);
+  this->AddStat_(&HeapStats::pops);
+  return RemoveRoot_(min_root, prev_node);
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+IndirectBinomialHeap<T, kLazy, Ids, Compare>::RemoveRoot_(Node *root,
+                                                          Node *prev_node) {
+  if (prev_node != nullptr) {
+    prev_node->set_right(root->right());
+  } else {
+    root_ = root->right();
+  }
+
+  this->AddStat_(&HeapStats::consolidations);
+  auto *children = root->DetachChildren();
+  if (kLazy) {
+    // Put the children on the root list, then merge all the roots.
+    while (children != nullptr) {
+      auto *next = children->right();
+      children->set_right(root_);
+      root_ = children;
+      children = next;
+    }
+    Consolidate_();
+  } else {
+    int num_trees = 0;
+    if (kEnableHeapStats) {
+      for (auto *root = root_; root != nullptr; root = root->right()) {
+        num_trees++;
+      }
+      num_trees += root->dimension();
+    }
+    root_ = Node::MergeTreeLists(root_, children);
+    if (kEnableHeapStats) {
+      for (auto *root = root_; root != nullptr; root = root->right()) {
+        num_trees--;
+      }
+      this->AddStat_(&HeapStats::links, num_trees);
+    }
+  }
+
+  Entry *entry = root->key().entry;
+  auto result = std::make_pair(std::move(entry->key), entry->id);
+  id_to_entry_.Erase(result.second);
+  delete entry;
+  delete root;
+  return result;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+typename IndirectBinomialHeap<T, kLazy, Ids, Compare>::Node *
+IndirectBinomialHeap<T, kLazy, Ids, Compare>::SiftUp_(Node *node,
+                                                      bool to_root) {
+  const Key key = node->key();
+  while (true) {
+    auto *parent = node->parent();
+
+    // Done if parent is root or has smaller key.
+    if (parent == nullptr || (!to_root && !(key < parent->key()))) {
+      break;
+    }
+
+    // Move the parent's element down.
+    node->set_key(parent->key());
+    node->set_id(parent->id());
+    node->key().entry->node = node;
+    this->AddStat_(&HeapStats::sift_steps);
+
+    node = parent;
+  }
+
+  // Finally place the element at node.
+  node->set_key(key);
+  node->set_id(key.entry->id);
+  key.entry->node = node;
+  return node;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::SiftDown_(Node *node) {
+  const Key key = node->key();
+  while (node->child() != nullptr) {
+    // Find the child with the smallest key.
+    auto *min_child = node->child();
+    for (auto *child = min_child->right(); child != nullptr;
+         child = child->right()) {
+      if (child->key() < min_child->key()) {
+        min_child = child;
+      }
+    }
+
+    // Done if all children are larger.
+    if (!(min_child->key() < key)) {
+      break;
+    }
+
+    // Move the child's element up.
+    node->set_key(min_child->key());
+    node->set_id(min_child->id());
+    node->key().entry->node = node;
+    this->AddStat_(&HeapStats::sift_steps);
+
+    node = min_child;
+  }
+
+  // Finally place the element at node.
+  node->set_key(key);
+  node->set_id(key.entry->id);
+  key.entry->node = node;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::Consolidate_() {
+  // A tree of each dimension. Dimensions are below 64, as sizes are ints.
+  Node *trees[64] = {};
+  int max_dimension = -1;
+  Node *root = root_;
+  while (root != nullptr) {
+    auto *next = root->right();
+    root->set_right(nullptr);
+    int dimension = root->dimension();
+    while (trees[dimension] != nullptr) {
+      root = Node::MergeTrees(root, trees[dimension]);
+      this->AddStat_(&HeapStats::links);
+      trees[dimension] = nullptr;
+      dimension++;
+    }
+    trees[dimension] = root;
+    max_dimension = std::max(max_dimension, dimension);
+    root = next;
+  }
+
+  // Rebuild the root list in ascending dimension.
+  root_ = nullptr;
+  min_root_ = nullptr;
+  for (int dimension = max_dimension; dimension >= 0; --dimension) {
+    Node *tree = trees[dimension];
+    if (tree == nullptr) {
+      continue;
+    }
+    tree->set_right(root_);
+    root_ = tree;
+    if (min_root_ == nullptr || tree->key() < min_root_->key()) {
+      min_root_ = tree;
+    }
+  }
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+HeapStats IndirectBinomialHeap<T, kLazy, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  for (const auto *root = root_; root != nullptr; root = root->right()) {
+    // A binomial tree of dimension d has height d + 1.
+    stats.num_trees++;
+    stats.max_height = std::max(stats.max_height, root->dimension() + 1);
+  }
+  return stats;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
+  out << std::endl
+      << "-- Heap (" << size() << ") " << label << " --" << std::endl;
+  for (const auto *root = root_; root != nullptr; root = root->right()) {
+    out << "Tree #" << root->dimension() << std::endl;
+    root->PrintTree(out, 1);
+  }
+  out << std::endl;
+}
+
+template <typename T, bool kLazy, typename Ids, typename Compare>
+void IndirectBinomialHeap<T, kLazy, Ids, Compare>::Validate() const {
+  int prev_dimension = -1;
+  std::unordered_set<Id> seen_ids;
+  for (auto *root = root_; root != nullptr; root = root->right()) {
+    CHECK(root->is_root());
+    if (!kLazy) {
+      CHECK(root->dimension() > prev_dimension);
+    } else {
+      CHECK(!(root->key() < min_root_->key()));
+    }
+    root->Validate(&seen_ids);
+    prev_dimension = root->dimension();
+  }
+  CHECK(!kLazy || (root_ == nullptr) == (min_root_ == nullptr));
+
+  CHECK(seen_ids.size() == size());
+  for (const auto &id : seen_ids) {
+    const Entry *entry = *id_to_entry_.Find(id);
+    CHECK(entry->id == id);
+    CHECK(entry->node->key().entry == entry);
+    CHECK(entry->node->id() == id);
+  }
+}
+
+#endif /* HEAPS_INDIRECT_BINOMIAL_HEAP_H_ */
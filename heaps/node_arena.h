@@ -0,0 +1,88 @@
+// An arena of heap nodes, allocated in blocks.
+//
+// Unlike NodePool, nodes never move, so they can link to each other with
+// pointers. Freed nodes are reused, and the blocks are kept until the arena
+// is destroyed, so a heap that stays within its past size does not call the
+// allocator.
+
+#ifndef HEAPS_NODE_ARENA_H_
+#define HEAPS_NODE_ARENA_H_
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/memory.h"
+
+template <typename Node> class NodeArena {
+public:
+  NodeArena() : size_(0), used_(0) {}
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+
+  // Does not destroy the nodes still allocated; their owner must Delete them
+  // first.
+  ~NodeArena() { DCHECK(size_ == 0); }
+
+  // Returns the number of allocated nodes.
+  int size() const { return size_; }
+
+  // Constructs a node from `args`, and returns it.
+  template <typename... Args> Node *New(Args &&...args) {
+    void *slot;
+    if (!free_.empty()) {
+      slot = free_.back();
+      free_.pop_back();
+    } else {
+      if (used_ == static_cast<long>(blocks_.size()) * kBlockSize) {
+        blocks_.emplace_back(new Slot[kBlockSize]);
+      }
+      slot = &blocks_[used_ / kBlockSize][used_ % kBlockSize];
+      used_++;
+    }
+    size_++;
+    return new (slot) Node(std::forward<Args>(args)...);
+  }
+
+  // Destroys a node, and keeps its memory for a later New. When the arena
+  // becomes empty, it starts again from the first block, so that a new
+  // batch of nodes is contiguous again.
+  void Delete(Node *node) {
+    node->~Node();
+    size_--;
+    if (size_ == 0) {
+      free_.clear();
+      used_ = 0;
+    } else {
+      free_.push_back(node);
+    }
+  }
+
+  // Returns the approximate bytes allocated by the arena.
+  long MemoryUsage() const {
+    return static_cast<long>(blocks_.size()) *
+               AllocationSize(kBlockSize * sizeof(Slot)) +
+           ContainerMemoryUsage(blocks_) + ContainerMemoryUsage(free_);
+  }
+
+private:
+  using Slot = typename std::aligned_storage<sizeof(Node), alignof(Node)>::type;
+
+  // The number of nodes in each block.
+  static const int kBlockSize = 256;
+
+  // The number of allocated nodes.
+  int size_;
+
+  // The number of slots handed out from the blocks, freed or not.
+  long used_;
+
+  std::vector<std::unique_ptr<Slot[]>> blocks_;
+
+  // Freed nodes, reused last in first out.
+  std::vector<Node *> free_;
+};
+
+#endif /* HEAPS_NODE_ARENA_H_ */
@@ -0,0 +1,81 @@
+// A pool of heap nodes in one contiguous array.
+//
+// Nodes are addressed by 32-bit indices instead of pointers, which halves
+// the size of the links, and nodes allocated one after the other sit next
+// to each other in memory.
+//
+// Nodes are placed by allocation order, and freed slots are reused last in
+// first out, not by id: nodes for adjacent ids only land near each other if
+// they are added together. Placing them by id would need dense integer ids,
+// which the heaps do not require.
+
+#ifndef HEAPS_NODE_POOL_H_
+#define HEAPS_NODE_POOL_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "base/memory.h"
+
+// An index that refers to no node.
+const uint32_t kNullNodeIndex = 0xffffffff;
+
+template <typename Node> class NodePool {
+public:
+  // Returns the number of allocated nodes.
+  int size() const { return static_cast<int>(nodes_.size() - free_.size()); }
+
+  // Stores `node`, and returns its index.
+  uint32_t Allocate(Node node) {
+    if (!free_.empty()) {
+      uint32_t index = free_.back();
+      free_.pop_back();
+      nodes_[index] = std::move(node);
+      return index;
+    }
+    CHECK(nodes_.size() < kNullNodeIndex);
+    nodes_.push_back(std::move(node));
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  // Returns a node to the pool. When the pool becomes empty, it starts
+  // again from the front of the array, so that a new batch of nodes is
+  // contiguous again.
+  void Free(uint32_t index) {
+    DCHECK(index < nodes_.size());
+    // Move the node into a temporary that is destroyed at once, so that a
+    // key that owns memory releases it now rather than when the slot is
+    // reused.
+    static_cast<void>(Node(std::move(nodes_[index])));
+    free_.push_back(index);
+    if (free_.size() == nodes_.size()) {
+      free_.clear();
+      nodes_.clear();
+    }
+  }
+
+  Node &operator[](uint32_t index) {
+    DCHECK(index < nodes_.size());
+    return nodes_[index];
+  }
+
+  const Node &operator[](uint32_t index) const {
+    DCHECK(index < nodes_.size());
+    return nodes_[index];
+  }
+
+  // Returns the approximate bytes allocated by the pool.
+  long MemoryUsage() const {
+    return ContainerMemoryUsage(nodes_) + ContainerMemoryUsage(free_);
+  }
+
+private:
+  std::vector<Node> nodes_;
+
+  // Indices of the freed nodes, reused last in first out.
+  std::vector<uint32_t> free_;
+};
+
+#endif /* HEAPS_NODE_POOL_H_ */
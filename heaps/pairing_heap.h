@@ -1,25 +1,36 @@
 // Pairing Heap.
 //
 // See https://en.wikipedia.org/wiki/Pairing_heap
+//
+// The strategy for merging the subtrees of a popped root is a template
+// parameter, and so is the auxiliary insertion buffer of Stasko and Vitter,
+// "Pairing heaps: experiments and analysis", CACM 1987.
 
 #ifndef HEAPS_PAIRING_HEAP_H_
 #define HEAPS_PAIRING_HEAP_H_
 
+#include <functional>
 #include <iostream>
-#include <unordered_map>
+#include <string>
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
 
 // A node used in Pairing Heaps.
-template <typename T> class PairingHeapNode {
+template <typename T, typename Id = int,
+          typename Compare = std::less<T>>
+class PairingHeapNode {
 public:
-  PairingHeapNode(T key, int id)
-      : key_(key), id_(id), child_(nullptr), left_(nullptr), right_(nullptr) {}
+  PairingHeapNode(T key, Id id)
+      : key_(std::move(key)), id_(id), child_(nullptr), left_(nullptr),
+        right_(nullptr) {}
 
-  static void DeleteTree(PairingHeapNode<T> *node) {
+  static void DeleteTree(PairingHeapNode<T, Id, Compare> *node) {
     if (node != nullptr) {
       DeleteTree(node->child_);
       DeleteTree(node->right_);
@@ -28,23 +39,39 @@ public:
   }
 
   const T &key() const { return key_; }
-  void set_key(T key) { key_ = key; }
+  void set_key(T key) { key_ = std::move(key); }
+
+  // Moves the key out of the node.
+  T take_key() { return std::move(key_); }
 
-  int id() const { return id_; }
+  Id id() const { return id_; }
 
   // Returns the child node.
-  PairingHeapNode<T> *child() const { return child_; }
+  PairingHeapNode<T, Id, Compare> *child() const { return child_; }
 
   // Returns the previous sibling, or the parent if it has no previous sibling.
-  PairingHeapNode<T> *left() const { return left_; }
+  PairingHeapNode<T, Id, Compare> *left() const { return left_; }
 
   // Returns the next sibling.
-  PairingHeapNode<T> *right() const { return right_; }
+  PairingHeapNode<T, Id, Compare> *right() const { return right_; }
 
   // Add a child to this node.
-  void AddChild(PairingHeapNode<T> *child);
+  void AddChild(PairingHeapNode<T, Id, Compare> *child);
+
+  // Removes and returns the list of children.
+  PairingHeapNode<T, Id, Compare> *TakeChildren() {
+    auto *children = child_;
+    child_ = nullptr;
+    return children;
+  }
 
-  // Remove the node from its parent.
+  // Puts this node, with no parent or siblings, in front of a list of trees
+  // that have no parent. `list` may be null.
+  void PrependTo(PairingHeapNode<T, Id, Compare> *list);
+
+  // Remove the node from its parent, or from a list of trees with no parent.
+  // If it is the first of such a list, the list's owner must point to the
+  // next tree first.
   void DetachFromParent();
 
   // Debug information about this node.
@@ -57,34 +84,53 @@ public:
   void PrintTree(std::ostream &out, int level) const;
 
   // Validate the fields.
-  void Validate(std::unordered_set<int> *seen_ids) const;
+  void Validate(std::unordered_set<Id> *seen_ids) const;
 
   // Merge two trees.
-  static PairingHeapNode<T> *MergeTrees(PairingHeapNode<T> *a,
-                                        PairingHeapNode<T> *b);
+  static PairingHeapNode<T, Id, Compare> *MergeTrees(
+      PairingHeapNode<T, Id, Compare> *a, PairingHeapNode<T, Id, Compare> *b);
+
+  // Merge a list of trees: pairs from left to right, then the pairs from
+  // right to left.
+  static PairingHeapNode<T, Id, Compare> *
+  MergeTreeList(PairingHeapNode<T, Id, Compare> *tree_list);
+
+  // Merge a list of trees by pairing them in passes from left to right,
+  // until one is left.
+  static PairingHeapNode<T, Id, Compare> *
+  MergeTreeListMultipass(PairingHeapNode<T, Id, Compare> *tree_list);
+
+  // Merge a list of trees one at a time into the first one.
+  static PairingHeapNode<T, Id, Compare> *
+  MergeTreeListFrontToBack(PairingHeapNode<T, Id, Compare> *tree_list);
 
-  // Merge a list of trees.
-  static PairingHeapNode<T> *MergeTreeList(PairingHeapNode<T> *tree_list);
+  // Merge a list of trees one at a time into the last one.
+  static PairingHeapNode<T, Id, Compare> *
+  MergeTreeListBackToFront(PairingHeapNode<T, Id, Compare> *tree_list);
 
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   T key_;
 
   // An int that uniquely identifies this node.
-  int id_;
+  Id id_;
 
   // Points to the first child.
-  PairingHeapNode<T> *child_;
+  PairingHeapNode<T, Id, Compare> *child_;
 
   // Points to the previous sibling. If it has no previous sibling,
   // this points to its parent.
-  PairingHeapNode<T> *left_;
+  PairingHeapNode<T, Id, Compare> *left_;
 
   // Points to next sibling.
-  PairingHeapNode<T> *right_;
+  PairingHeapNode<T, Id, Compare> *right_;
 };
 
-template <typename T>
-void PairingHeapNode<T>::AddChild(PairingHeapNode<T> *child) {
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::AddChild(
+    PairingHeapNode<T, Id, Compare> *child) {
   if (child_ != nullptr) {
     child_->left_ = child;
   }
@@ -93,10 +139,11 @@ void PairingHeapNode<T>::AddChild(PairingHeapNode<T> *child) {
   child_ = child;
 }
 
-template <typename T>
-PairingHeapNode<T> *PairingHeapNode<T>::MergeTrees(PairingHeapNode<T> *a,
-                                                   PairingHeapNode<T> *b) {
-  if (a->key_ < b->key_) {
+template <typename T, typename Id, typename Compare>
+PairingHeapNode<T, Id, Compare> *
+PairingHeapNode<T, Id, Compare>::MergeTrees(
+    PairingHeapNode<T, Id, Compare> *a, PairingHeapNode<T, Id, Compare> *b) {
+  if (Less_(a->key_, b->key_)) {
     a->AddChild(b);
     return a;
   } else {
@@ -105,15 +152,16 @@ PairingHeapNode<T> *PairingHeapNode<T>::MergeTrees(PairingHeapNode<T> *a,
   }
 }
 
-template <typename T>
-PairingHeapNode<T> *
-PairingHeapNode<T>::MergeTreeList(PairingHeapNode<T> *tree_list) {
+template <typename T, typename Id, typename Compare>
+PairingHeapNode<T, Id, Compare> *
+PairingHeapNode<T, Id, Compare>::MergeTreeList(
+    PairingHeapNode<T, Id, Compare> *tree_list) {
   if (tree_list == nullptr) {
     return nullptr;
   }
 
   // Merge pairs from left to right.
-  PairingHeapNode<T> *merged_head = nullptr;
+  PairingHeapNode<T, Id, Compare> *merged_head = nullptr;
   auto *node = tree_list;
   do {
     auto *next = node->right_;
@@ -146,8 +194,92 @@ PairingHeapNode<T>::MergeTreeList(PairingHeapNode<T> *tree_list) {
   return merged_head;
 }
 
-template <typename T> void PairingHeapNode<T>::DetachFromParent() {
-  if (left_->child_ == this) {
+template <typename T, typename Id, typename Compare>
+PairingHeapNode<T, Id, Compare> *
+PairingHeapNode<T, Id, Compare>::MergeTreeListMultipass(
+    PairingHeapNode<T, Id, Compare> *tree_list) {
+  if (tree_list == nullptr) {
+    return nullptr;
+  }
+
+  // Trees are queued through right_. Merging the two at the front and
+  // queueing the result at the back makes passes from left to right.
+  auto *head = tree_list;
+  auto *tail = tree_list;
+  while (tail->right_ != nullptr) {
+    tail = tail->right_;
+  }
+  while (head != tail) {
+    auto *first = head;
+    auto *second = head->right_;
+    head = second->right_;
+    auto *merged = MergeTrees(first, second);
+    merged->right_ = nullptr;
+    if (head == nullptr) {
+      head = merged;
+    } else {
+      tail->right_ = merged;
+    }
+    tail = merged;
+  }
+
+  head->left_ = nullptr;
+  return head;
+}
+
+template <typename T, typename Id, typename Compare>
+PairingHeapNode<T, Id, Compare> *
+PairingHeapNode<T, Id, Compare>::MergeTreeListFrontToBack(
+    PairingHeapNode<T, Id, Compare> *tree_list) {
+  if (tree_list == nullptr) {
+    return nullptr;
+  }
+
+  auto *merged = tree_list;
+  auto *node = tree_list->right_;
+  merged->right_ = nullptr;
+  while (node != nullptr) {
+    auto *next = node->right_;
+    node->right_ = nullptr;
+    merged = MergeTrees(merged, node);
+    node = next;
+  }
+
+  merged->left_ = nullptr;
+  return merged;
+}
+
+template <typename T, typename Id, typename Compare>
+PairingHeapNode<T, Id, Compare> *
+PairingHeapNode<T, Id, Compare>::MergeTreeListBackToFront(
+    PairingHeapNode<T, Id, Compare> *tree_list) {
+  // Reverse the list, then merge from the front.
+  PairingHeapNode<T, Id, Compare> *reversed = nullptr;
+  auto *node = tree_list;
+  while (node != nullptr) {
+    auto *next = node->right_;
+    node->right_ = reversed;
+    reversed = node;
+    node = next;
+  }
+  return MergeTreeListFrontToBack(reversed);
+}
+
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::PrependTo(
+    PairingHeapNode<T, Id, Compare> *list) {
+  if (list != nullptr) {
+    list->left_ = this;
+  }
+  left_ = nullptr;
+  right_ = list;
+}
+
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::DetachFromParent() {
+  if (left_ == nullptr) {
+    // The first of a list with no parent.
+  } else if (left_->child_ == this) {
     // This is the first child. left_ is the parent.
     left_->child_ = right_;
   } else {
@@ -160,7 +292,8 @@ template <typename T> void PairingHeapNode<T>::DetachFromParent() {
   right_ = nullptr;
 }
 
-template <typename T> std::string PairingHeapNode<T>::DebugString() const {
+template <typename T, typename Id, typename Compare>
+std::string PairingHeapNode<T, Id, Compare>::DebugString() const {
   std::stringstream out;
   out << key_ << " [id:" << id_ << "]";
 
@@ -177,16 +310,17 @@ template <typename T> std::string PairingHeapNode<T>::DebugString() const {
   return out.str();
 }
 
-template <typename T>
-void PairingHeapNode<T>::PrintTree(std::ostream &out,
-                                   const std::string &label) const {
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
   out << label << ":" << std::endl;
   PrintTree(out, 0);
   out << std::endl;
 }
 
-template <typename T>
-void PairingHeapNode<T>::PrintTree(std::ostream &out, int level) const {
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::PrintTree(std::ostream &out,
+                                                int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -201,8 +335,9 @@ void PairingHeapNode<T>::PrintTree(std::ostream &out, int level) const {
   }
 }
 
-template <typename T>
-void PairingHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
+template <typename T, typename Id, typename Compare>
+void PairingHeapNode<T, Id, Compare>::Validate(
+    std::unordered_set<Id> *seen_ids) const {
   if (seen_ids != nullptr) {
     CHECK(seen_ids->insert(id_).second);
   }
@@ -218,14 +353,81 @@ void PairingHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
   }
 }
 
-template <typename T> class PairingHeap : public Heap<T> {
+// Strategies for merging the subtrees of a popped root, for the Pairing
+// parameter of PairingHeap.
+
+// Pairs the trees from left to right, then merges the pairs from right to
+// left. The standard strategy.
+struct TwoPassPairing {
+  static const char *Name() { return "two-pass"; }
+
+  template <typename T, typename Id, typename Compare>
+  static PairingHeapNode<T, Id, Compare> *Merge(
+      PairingHeapNode<T, Id, Compare> *tree_list) {
+    return PairingHeapNode<T, Id, Compare>::MergeTreeList(tree_list);
+  }
+};
+
+// Pairs the trees in passes from left to right, until one is left.
+struct MultipassPairing {
+  static const char *Name() { return "multipass"; }
+
+  template <typename T, typename Id, typename Compare>
+  static PairingHeapNode<T, Id, Compare> *Merge(
+      PairingHeapNode<T, Id, Compare> *tree_list) {
+    return PairingHeapNode<T, Id, Compare>::MergeTreeListMultipass(tree_list);
+  }
+};
+
+// Merges each tree into the first one, from left to right.
+struct FrontToBackPairing {
+  static const char *Name() { return "front-to-back"; }
+
+  template <typename T, typename Id, typename Compare>
+  static PairingHeapNode<T, Id, Compare> *Merge(
+      PairingHeapNode<T, Id, Compare> *tree_list) {
+    return PairingHeapNode<T, Id, Compare>::MergeTreeListFrontToBack(tree_list);
+  }
+};
+
+// Merges each tree into the last one, from right to left.
+struct BackToFrontPairing {
+  static const char *Name() { return "back-to-front"; }
+
+  template <typename T, typename Id, typename Compare>
+  static PairingHeapNode<T, Id, Compare> *Merge(
+      PairingHeapNode<T, Id, Compare> *tree_list) {
+    return PairingHeapNode<T, Id, Compare>::MergeTreeListBackToFront(tree_list);
+  }
+};
+
+// A Pairing Heap, merging subtrees with the `Pairing` strategy.
+//
+// With kAuxiliaryBuffer, added and reduced nodes are kept in a list beside
+// the root instead of being merged into it. The list is merged with the
+// multipass strategy on the next PopMinimum, so a run of adds or reduce-keys
+// costs no links until then.
+template <typename T, typename Pairing = TwoPassPairing,
+          bool kAuxiliaryBuffer = false, typename Ids = HeapIds<>,
+          typename Compare = std::less<T>>
+class PairingHeap : public Heap<T, typename Ids::Id> {
 public:
-  PairingHeap() : root_(nullptr) {}
-  ~PairingHeap() { PairingHeapNode<T>::DeleteTree(root_); }
+  using Id = typename Ids::Id;
 
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Pairing Heap",
-                            []() { return new PairingHeap<T>{}; });
+  PairingHeap()
+      : root_(nullptr), auxiliary_buffer_(nullptr), auxiliary_min_(nullptr) {}
+  ~PairingHeap() {
+    MergeAuxiliaryBuffer_();
+    PairingHeapNode<T, Id, Compare>::DeleteTree(root_);
+  }
+
+  static Factory<Heap<T, Id>> factory() {
+    std::string name = "Pairing Heap";
+    if (!std::is_same<Pairing, TwoPassPairing>::value || kAuxiliaryBuffer) {
+      name += std::string(" (") + Pairing::Name() +
+              (kAuxiliaryBuffer ? ", auxiliary buffer)" : ")");
+    }
+    return Factory<Heap<T, Id>>(name, []() { return new PairingHeap{}; });
   }
 
   // Returns number of elements.
@@ -233,20 +435,30 @@ public:
     return static_cast<int>(id_to_node_.size());
   }
 
-  // Adds an element with key and unique int id.
-  virtual void Add(T key, int id) override;
+  // Moves out all the elements, in no particular order, and leaves the heap
+  // empty. Takes O(n) time, without comparing keys.
+  std::vector<HeapElement<T, Id>> TakeElements();
+
+  // Adds an element with key and unique id.
+  virtual void Add(T key, Id id) override;
 
   // Updates with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the min element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out,
@@ -255,76 +467,308 @@ public:
   // Validate the invariants.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return size() * AllocationSize(sizeof(PairingHeapNode<T, Id, Compare>)) +
+           id_to_node_.MemoryUsage();
+  }
+
 private:
-  // The min root node. Maybe null.
-  PairingHeapNode<T> *root_;
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Adds a node with no parent or siblings to the auxiliary buffer.
+  void AddToAuxiliaryBuffer_(PairingHeapNode<T, Id, Compare> *node);
+
+  // Merges the auxiliary buffer into the root.
+  void MergeAuxiliaryBuffer_();
+
+  // Detaches the children of `node`, and merges them into one tree with the
+  // `Pairing` strategy. Returns null if it has no children.
+  PairingHeapNode<T, Id, Compare> *MergeChildren_(
+      PairingHeapNode<T, Id, Compare> *node);
+
+  // The min root node, not counting the auxiliary buffer. Maybe null.
+  PairingHeapNode<T, Id, Compare> *root_;
+
+  // With kAuxiliaryBuffer, the first of the buffered trees, which are linked
+  // as siblings. Null if the buffer is empty.
+  PairingHeapNode<T, Id, Compare> *auxiliary_buffer_;
+
+  // The buffered tree with the minimum key. Null if the buffer is empty.
+  PairingHeapNode<T, Id, Compare> *auxiliary_min_;
 
   // Map of each id to the node.
-  std::unordered_map<int, PairingHeapNode<T> *> id_to_node_;
+  typename Ids::template Index<PairingHeapNode<T, Id, Compare> *> id_to_node_;
 };
 
-template <typename T> void PairingHeap<T>::Add(T key, int id) {
-  PairingHeapNode<T> *node = new PairingHeapNode<T>{key, id};
-  CHECK(id_to_node_.emplace(id, node).second);
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+std::vector<HeapElement<T, typename Ids::Id>>
+PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::TakeElements() {
+  std::vector<HeapElement<T, Id>> elements;
+  elements.reserve(size());
 
-  // If no root. Make this the root.
-  if (root_ == nullptr) {
+  // Walk the trees with an explicit stack, as they may be deep.
+  std::vector<PairingHeapNode<T, Id, Compare> *> stack;
+  if (root_ != nullptr) {
+    stack.push_back(root_);
+  }
+  if (auxiliary_buffer_ != nullptr) {
+    stack.push_back(auxiliary_buffer_);
+  }
+  while (!stack.empty()) {
+    auto *node = stack.back();
+    stack.pop_back();
+    if (node->right() != nullptr) {
+      stack.push_back(node->right());
+    }
+    if (node->child() != nullptr) {
+      stack.push_back(node->child());
+    }
+    id_to_node_.Erase(node->id());
+    elements.emplace_back(node->take_key(), node->id());
+    delete node;
+  }
+  root_ = nullptr;
+  auxiliary_buffer_ = nullptr;
+  auxiliary_min_ = nullptr;
+  return elements;
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::Add(T key,
+                                                                  Id id) {
+  auto *node = new PairingHeapNode<T, Id, Compare>{std::move(key), id};
+  CHECK(id_to_node_.Insert(id, node));
+  this->AddStat_(&HeapStats::adds);
+
+  if (kAuxiliaryBuffer) {
+    AddToAuxiliaryBuffer_(node);
+  } else if (root_ == nullptr) {
+    // If no root. Make this the root.
     root_ = node;
   } else {
-    root_ = PairingHeapNode<T>::MergeTrees(root_, node);
+    root_ = PairingHeapNode<T, Id, Compare>::MergeTrees(root_, node);
+    this->AddStat_(&HeapStats::links);
   }
 }
 
-template <typename T> void PairingHeap<T>::ReduceKey(T new_key, int id) {
-  auto *node = id_to_node_[id];
-  DCHECK(!(node->key() < new_key));
-  node->set_key(new_key);
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::ReduceKey(
+    T new_key, Id id) {
+  auto *node = *id_to_node_.Find(id);
+  DCHECK(!Less_(node->key(), new_key));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::reduce_keys);
 
   if (node == root_) {
     return;
   }
+  if (node == auxiliary_buffer_) {
+    auxiliary_buffer_ = node->right();
+  }
   node->DetachFromParent();
-  root_ = PairingHeapNode<T>::MergeTrees(root_, node);
+  this->AddStat_(&HeapStats::cuts);
+  if (kAuxiliaryBuffer) {
+    AddToAuxiliaryBuffer_(node);
+    return;
+  }
+  root_ = PairingHeapNode<T, Id, Compare>::MergeTrees(root_, node);
+  this->AddStat_(&HeapStats::links);
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::IncreaseKey(
+    T new_key, Id id) {
+  PairingHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  CHECK(!Less_(new_key, node->key()));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Merge them into a tree of their own,
+  // and link it with the root.
+  MergeAuxiliaryBuffer_();
+  auto *children = MergeChildren_(node);
+  if (children == nullptr) {
+    return;
+  }
+  root_ = PairingHeapNode<T, Id, Compare>::MergeTrees(root_, children);
+  this->AddStat_(&HeapStats::links);
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::Remove(Id id) {
+  PairingHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  id_to_node_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  MergeAuxiliaryBuffer_();
+  auto *children = MergeChildren_(node);
+  if (node == root_) {
+    root_ = children;
+  } else {
+    node->DetachFromParent();
+    this->AddStat_(&HeapStats::cuts);
+    if (children != nullptr) {
+      root_ = PairingHeapNode<T, Id, Compare>::MergeTrees(root_, children);
+      this->AddStat_(&HeapStats::links);
+    }
+  }
+  delete node;
 }
 
-template <typename T> const T *PairingHeap<T>::LookUp(int id) const {
-  const auto it = id_to_node_.find(id);
-  if (it == id_to_node_.end()) {
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+const T *PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::LookUp(
+    Id id) const {
+  auto *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
     return nullptr;
   }
-  return &it->second->key();
+  return &(*node)->key();
 }
 
-template <typename T> HeapElement<T> PairingHeap<T>::Min() const {
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+HeapElement<T, typename Ids::Id>
+PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::Min() const {
   DCHECK(size() > 0);
+  if (auxiliary_min_ != nullptr &&
+      (root_ == nullptr || Less_(auxiliary_min_->key(), root_->key()))) {
+    return std::make_pair(auxiliary_min_->key(), auxiliary_min_->id());
+  }
   return std::make_pair(root_->key(), root_->id());
 }
 
-template <typename T> HeapElement<T> PairingHeap<T>::PopMinimum() {
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+HeapElement<T, typename Ids::Id>
+PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::PopMinimum() {
   DCHECK(size() > 0);
+  MergeAuxiliaryBuffer_();
 
   auto *min_root = root_;
+  this->AddStat_(&HeapStats::pops);
+  root_ = MergeChildren_(min_root);
 
-  auto *children = min_root->child();
-  root_ = PairingHeapNode<T>::MergeTreeList(children);
-
-  auto result = std::make_pair(min_root->key(), min_root->id());
-  id_to_node_.erase(min_root->id());
+  auto result = std::make_pair(min_root->take_key(), min_root->id());
+  id_to_node_.Erase(min_root->id());
   delete min_root;
   return result;
 }
 
-template <typename T>
-void PairingHeap<T>::PrintTree(std::ostream &out,
-                               const std::string &label) const {
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+PairingHeapNode<T, typename Ids::Id, Compare> *
+PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::MergeChildren_(
+    PairingHeapNode<T, Id, Compare> *node) {
+  auto *children = node->TakeChildren();
+  this->AddStat_(&HeapStats::consolidations);
+  if (kEnableHeapStats && children != nullptr) {
+    // Merging a list of trees takes one link less than the number of trees.
+    for (auto *child = children->right(); child != nullptr;
+         child = child->right()) {
+      this->AddStat_(&HeapStats::links);
+    }
+  }
+  return Pairing::Merge(children);
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::
+    AddToAuxiliaryBuffer_(PairingHeapNode<T, Id, Compare> *node) {
+  node->PrependTo(auxiliary_buffer_);
+  auxiliary_buffer_ = node;
+  if (auxiliary_min_ == nullptr || Less_(node->key(), auxiliary_min_->key())) {
+    auxiliary_min_ = node;
+  }
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::
+    MergeAuxiliaryBuffer_() {
+  auto *trees = auxiliary_buffer_;
+  if (trees == nullptr) {
+    return;
+  }
+  auxiliary_buffer_ = nullptr;
+  if (kEnableHeapStats) {
+    for (auto *tree = trees->right(); tree != nullptr; tree = tree->right()) {
+      this->AddStat_(&HeapStats::links);
+    }
+  }
+  auto *merged = PairingHeapNode<T, Id, Compare>::MergeTreeListMultipass(trees);
+  if (root_ == nullptr) {
+    root_ = merged;
+  } else {
+    root_ = PairingHeapNode<T, Id, Compare>::MergeTrees(root_, merged);
+    this->AddStat_(&HeapStats::links);
+  }
+  auxiliary_min_ = nullptr;
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::PrintTree(
+    std::ostream &out, const std::string &label) const {
   out << std::endl
       << "-- Heap (" << size() << ") " << label << " --" << std::endl;
-  root_->PrintTree(out, 1);
+  if (root_ != nullptr) {
+    root_->PrintTree(out, 1);
+  }
+  if (auxiliary_buffer_ != nullptr) {
+    out << "Auxiliary buffer:" << std::endl;
+    auxiliary_buffer_->PrintTree(out, 1);
+  }
   out << std::endl;
 }
 
-template <typename T> void PairingHeap<T>::Validate() const {
-  std::unordered_set<int> seen_ids;
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+HeapStats
+PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+
+  // Walk the trees with an explicit stack, as they may be deep.
+  std::vector<std::pair<const PairingHeapNode<T, Id, Compare> *, int>> stack;
+  if (root_ != nullptr) {
+    stack.emplace_back(root_, 1);
+  }
+  for (const auto *tree = auxiliary_buffer_; tree != nullptr;
+       tree = tree->right()) {
+    stack.emplace_back(tree, 1);
+  }
+  stats.num_trees = static_cast<int>(stack.size());
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    stats.max_height = std::max(stats.max_height, entry.second);
+    for (const auto *child = entry.first->child(); child != nullptr;
+         child = child->right()) {
+      stack.emplace_back(child, entry.second + 1);
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename Pairing, bool kAuxiliaryBuffer, typename Ids,
+          typename Compare>
+void PairingHeap<T, Pairing, kAuxiliaryBuffer, Ids, Compare>::Validate() const {
+  std::unordered_set<Id> seen_ids;
   if (root_ != nullptr) {
     CHECK(root_->left() == nullptr);
     CHECK(root_->right() == nullptr);
@@ -332,13 +776,20 @@ template <typename T> void PairingHeap<T>::Validate() const {
     root_->Validate(&seen_ids);
   }
 
-  if (seen_ids.size() != size()) {
-    for (const auto &entry : id_to_node_) {
-      if (seen_ids.find(entry.first) == seen_ids.end()) {
-        LOG(ERROR) << "Id not seen: " << entry.first;
-      }
+  const auto *buffered = auxiliary_buffer_;
+  CHECK(kAuxiliaryBuffer || buffered == nullptr);
+  CHECK((buffered == nullptr) == (auxiliary_min_ == nullptr));
+  if (buffered != nullptr) {
+    CHECK(buffered->left() == nullptr);
+    buffered->Validate(&seen_ids);
+    for (const auto *tree = buffered; tree != nullptr; tree = tree->right()) {
+      CHECK(!Less_(tree->key(), auxiliary_min_->key()));
     }
-    LOG(FATAL) << "Some ids are missing";
+  }
+
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
   }
 }
 
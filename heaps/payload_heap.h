@@ -0,0 +1,154 @@
+// Payload Heap.
+//
+// A heap of large, possibly move-only, payloads that are ordered by a small
+// key taken from each payload. Only the key and the id go into the underlying
+// heap, so its sifts and links move a few bytes instead of the payloads. The
+// payloads stay in an id-indexed map, and are moved in and out, never copied.
+
+#ifndef HEAPS_PAYLOAD_HEAP_H_
+#define HEAPS_PAYLOAD_HEAP_H_
+
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "base/factory.h"
+#include "base/memory.h"
+#include "heaps/heap.h"
+
+// `KeyOf` returns the key of a payload, e.g. the distance of a label set.
+// Payloads must be ordered by their keys.
+//
+// The ids are `int` unless given another hashable type, and the heap of keys
+// may find them with any id index. The payloads themselves are kept in a
+// std::unordered_map, since the id indexes copy their values, and a
+// HeapHandle has no room for a payload.
+template <typename T, typename KeyOf, typename Id = int> class PayloadHeap {
+public:
+  using Key = typename std::decay<decltype(std::declval<const KeyOf &>()(
+      std::declval<const T &>()))>::type;
+
+  // Keeps the keys in a heap made by `heap_factory`.
+  explicit PayloadHeap(const Factory<Heap<Key, Id>> &heap_factory,
+                       KeyOf key_of = KeyOf())
+      : heap_(heap_factory()), key_of_(std::move(key_of)) {}
+
+  // Returns number of elements.
+  int size() const { return heap_->size(); }
+
+  // Returns true if it's empty.
+  bool empty() const { return heap_->empty(); }
+
+  // Adds a payload with a unique id.
+  void Add(T payload, Id id);
+
+  // Adds a payload constructed from `args`, with a unique id.
+  template <typename... Args> void Emplace(Id id, Args &&...args) {
+    Add(T(std::forward<Args>(args)...), id);
+  }
+
+  // Replaces the payload of an element with one of a lower key.
+  void ReduceKey(T new_payload, Id id);
+
+  // Replaces the payload of an element with one of a higher key.
+  void IncreaseKey(T new_payload, Id id);
+
+  // Removes an element by its id.
+  void Remove(Id id);
+
+  // Looks up a payload by id. Returns nullptr if not found.
+  const T *LookUp(Id id) const;
+
+  // Returns the id of the min element.
+  Id MinId() const { return heap_->Min().second; }
+
+  // Returns the payload of the min element.
+  const T &MinPayload() const { return values_.find(MinId())->second; }
+
+  // Pops the min element, and returns its payload, moved out, and id.
+  HeapElement<T, Id> PopMinimum();
+
+  // Validate the invariants.
+  void Validate() const;
+
+  // Returns the operation counters and shape of the underlying heap.
+  HeapStats Stats() const { return heap_->Stats(); }
+
+  // Returns the approximate bytes allocated by the heap and the payloads.
+  long MemoryUsage() const {
+    return heap_->MemoryUsage() + ContainerMemoryUsage(values_);
+  }
+
+private:
+  // The keys of the payloads.
+  std::unique_ptr<Heap<Key, Id>> heap_;
+
+  KeyOf key_of_;
+
+  // A map from the element id to its payload.
+  std::unordered_map<Id, T> values_;
+};
+
+template <typename T, typename KeyOf, typename Id>
+void PayloadHeap<T, KeyOf, Id>::Add(T payload, Id id) {
+  auto inserted = values_.emplace(id, std::move(payload));
+  CHECK(inserted.second);
+  heap_->Add(key_of_(inserted.first->second), id);
+}
+
+template <typename T, typename KeyOf, typename Id>
+void PayloadHeap<T, KeyOf, Id>::ReduceKey(T new_payload, Id id) {
+  auto it = values_.find(id);
+  CHECK(it != values_.end());
+  it->second = std::move(new_payload);
+  heap_->ReduceKey(key_of_(it->second), id);
+}
+
+template <typename T, typename KeyOf, typename Id>
+void PayloadHeap<T, KeyOf, Id>::IncreaseKey(T new_payload, Id id) {
+  auto it = values_.find(id);
+  CHECK(it != values_.end());
+  it->second = std::move(new_payload);
+  heap_->IncreaseKey(key_of_(it->second), id);
+}
+
+template <typename T, typename KeyOf, typename Id>
+void PayloadHeap<T, KeyOf, Id>::Remove(Id id) {
+  auto it = values_.find(id);
+  CHECK(it != values_.end());
+  heap_->Remove(id);
+  values_.erase(it);
+}
+
+template <typename T, typename KeyOf, typename Id>
+const T *PayloadHeap<T, KeyOf, Id>::LookUp(Id id) const {
+  const auto it = values_.find(id);
+  if (it == values_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+template <typename T, typename KeyOf, typename Id>
+HeapElement<T, Id> PayloadHeap<T, KeyOf, Id>::PopMinimum() {
+  const Id id = heap_->PopMinimum().second;
+  auto it = values_.find(id);
+  HeapElement<T, Id> result(std::move(it->second), id);
+  values_.erase(it);
+  return result;
+}
+
+template <typename T, typename KeyOf, typename Id>
+void PayloadHeap<T, KeyOf, Id>::Validate() const {
+  heap_->Validate();
+  CHECK(values_.size() == heap_->size());
+  for (const auto &value : values_) {
+    const Key *key = heap_->LookUp(value.first);
+    CHECK(key != nullptr);
+    CHECK(!(*key < key_of_(value.second)) && !(key_of_(value.second) < *key));
+  }
+}
+
+#endif /* HEAPS_PAYLOAD_HEAP_H_ */
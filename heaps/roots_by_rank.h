@@ -0,0 +1,64 @@
+// A fixed-capacity array of heap roots, indexed by rank, for consolidating
+// the roots of Fibonacci and Thin heaps.
+//
+// A tree whose root has rank r holds at least phi^r nodes, so with at most
+// 2^31 elements, ranks are below log_phi(2^31) < 45. The slots are never
+// resized or cleared: a bitmask records the occupied ones, and the roots
+// are visited in rank order by counting its trailing zeros.
+
+#ifndef HEAPS_ROOTS_BY_RANK_H_
+#define HEAPS_ROOTS_BY_RANK_H_
+
+#include <cstdint>
+
+#include "absl/log/check.h"
+
+template <typename Node> class RootsByRank {
+public:
+  // The number of ranks.
+  static const int kMaxRanks = 45;
+
+  RootsByRank() : occupied_(0) {}
+
+  bool empty() const { return occupied_ == 0; }
+
+  // Returns the root of given rank, or nullptr.
+  Node *operator[](int rank) const {
+    return (occupied_ >> rank) & 1 ? roots_[rank] : nullptr;
+  }
+
+  // Removes and returns the root of given rank, or returns nullptr.
+  Node *Take(int rank) {
+    DCHECK(rank < kMaxRanks);
+    const uint64_t bit = uint64_t{1} << rank;
+    if ((occupied_ & bit) == 0) {
+      return nullptr;
+    }
+    occupied_ &= ~bit;
+    return roots_[rank];
+  }
+
+  // Stores a root in the free slot of given rank.
+  void Put(int rank, Node *root) {
+    DCHECK(rank < kMaxRanks);
+    DCHECK(((occupied_ >> rank) & 1) == 0);
+    occupied_ |= uint64_t{1} << rank;
+    roots_[rank] = root;
+  }
+
+  // Removes and returns the root of the lowest rank. Must not be empty.
+  Node *PopLowest() {
+    DCHECK(!empty());
+    const int rank = __builtin_ctzll(occupied_);
+    occupied_ &= occupied_ - 1;
+    return roots_[rank];
+  }
+
+private:
+  // Bit r is set if roots_[r] holds a root.
+  uint64_t occupied_;
+
+  Node *roots_[kMaxRanks];
+};
+
+#endif /* HEAPS_ROOTS_BY_RANK_H_ */
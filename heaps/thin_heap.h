@@ -6,6 +6,7 @@
 #ifndef HEAPS_THIN_HEAP_H_
 #define HEAPS_THIN_HEAP_H_
 
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <unordered_set>
@@ -13,19 +14,27 @@
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/roots_by_rank.h"
 
 // A node used in Thin Heaps.
-template <typename T> class ThinHeapNode {
+template <typename T, typename Id = int,
+          typename Compare = std::less<T>>
+class ThinHeapNode {
 public:
-  ThinHeapNode(T key, int id)
-      : key_(key), id_(id), rank_(0), child_(nullptr), left_(nullptr),
-        right_(nullptr) {}
+  ThinHeapNode(T key, Id id)
+      : key_(std::move(key)), id_(id), rank_(0), child_(nullptr),
+        left_(nullptr), right_(nullptr) {}
 
   const T &key() const { return key_; }
-  void set_key(T key) { key_ = key; }
+  void set_key(T key) { key_ = std::move(key); }
 
-  int id() const { return id_; }
+  // Moves the key out of the node.
+  T take_key() { return std::move(key_); }
+
+  Id id() const { return id_; }
 
   short rank() const { return rank_; }
   void set_rank(int rank) { rank_ = rank; }
@@ -44,21 +53,29 @@ public:
   bool is_root() const { return left_ == nullptr; }
 
   // Returns the previous sibling or the parent if this is the first child.
-  ThinHeapNode<T> *left() const { return left_; }
+  ThinHeapNode<T, Id, Compare> *left() const { return left_; }
   void clear_left() { left_ = nullptr; }
 
   // Returns the next sibling.
-  ThinHeapNode<T> *right() const { return right_; }
-  void set_right(ThinHeapNode<T> *right) { right_ = right; }
+  ThinHeapNode<T, Id, Compare> *right() const { return right_; }
+  void set_right(ThinHeapNode<T, Id, Compare> *right) { right_ = right; }
   void clear_right() { right_ = nullptr; }
 
   // Returns the highest rank child (with dimension = dimension() - 1 or
   // dimension() - 2)
-  ThinHeapNode<T> *child() const { return child_; }
+  ThinHeapNode<T, Id, Compare> *child() const { return child_; }
+
+  // Removes and returns the list of children, dropping the rank to 0.
+  ThinHeapNode<T, Id, Compare> *TakeChildren() {
+    auto *children = child_;
+    child_ = nullptr;
+    rank_ = 0;
+    return children;
+  }
 
   // Delete the entire tree rooted at this node.
-  static void DeleteTree(ThinHeapNode<T> *node) {
-    ThinHeapNode<T> *next_node;
+  static void DeleteTree(ThinHeapNode<T, Id, Compare> *node) {
+    ThinHeapNode<T, Id, Compare> *next_node;
     for (; node != nullptr; node = next_node) {
       next_node = node->right_;
       DeleteTree(node->child_);
@@ -76,7 +93,7 @@ public:
   }
 
   // Add a (highest ranked) child and increase the rank of this node.
-  void AddChild(ThinHeapNode<T> *child) {
+  void AddChild(ThinHeapNode<T, Id, Compare> *child) {
     if (child_ != nullptr) {
       child_->left_ = child;
     }
@@ -87,14 +104,14 @@ public:
   }
 
   // Insert a node before this node.
-  void InsertBefore(ThinHeapNode<T> *node) {
+  void InsertBefore(ThinHeapNode<T, Id, Compare> *node) {
     node->right_ = this;
     node->left_ = nullptr;
     left_ = node;
   }
 
   // Insert a node after this node.
-  void InsertAfter(ThinHeapNode<T> *node) {
+  void InsertAfter(ThinHeapNode<T, Id, Compare> *node) {
     node->left_ = this;
     node->right_ = right_;
     if (right_ != nullptr) {
@@ -104,7 +121,7 @@ public:
   }
 
   // Detach first child without lowering rank of this node.
-  ThinHeapNode<T> *DetachFirstChild() {
+  ThinHeapNode<T, Id, Compare> *DetachFirstChild() {
     DCHECK(is_thick());
     auto *child = child_;
     if (child->right_ != nullptr) {
@@ -137,34 +154,38 @@ public:
   void PrintTree(std::ostream &out, int level) const;
 
   // Validate the fields.
-  void Validate(std::unordered_set<int> *seen_ids) const;
+  void Validate(std::unordered_set<Id> *seen_ids) const;
 
   // Merge two trees into one.
-  static ThinHeapNode<T> *MergeTrees(ThinHeapNode<T> *a, ThinHeapNode<T> *b);
+  static ThinHeapNode<T, Id, Compare> *MergeTrees(
+      ThinHeapNode<T, Id, Compare> *a, ThinHeapNode<T, Id, Compare> *b);
 
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   T key_;
 
-  // An int id that uniquely identifies this node.
-  int id_;
+  // An id that uniquely identifies this node.
+  Id id_;
 
   // Rank of the tree at this node.
   short rank_;
 
   // Points to the highest dimension child.
-  ThinHeapNode<T> *child_;
+  ThinHeapNode<T, Id, Compare> *child_;
 
   // Points to the left sibling or parent node (if this is the first child).
-  ThinHeapNode<T> *left_;
+  ThinHeapNode<T, Id, Compare> *left_;
 
   // Points to next sibling.
-  ThinHeapNode<T> *right_;
+  ThinHeapNode<T, Id, Compare> *right_;
 };
 
-template <typename T>
-ThinHeapNode<T> *ThinHeapNode<T>::MergeTrees(ThinHeapNode<T> *a,
-                                             ThinHeapNode<T> *b) {
-  if (a->key_ < b->key_) {
+template <typename T, typename Id, typename Compare>
+ThinHeapNode<T, Id, Compare> *ThinHeapNode<T, Id, Compare>::MergeTrees(
+    ThinHeapNode<T, Id, Compare> *a, ThinHeapNode<T, Id, Compare> *b) {
+  if (Less_(a->key_, b->key_)) {
     a->AddChild(b);
     return a;
   } else {
@@ -173,7 +194,8 @@ ThinHeapNode<T> *ThinHeapNode<T>::MergeTrees(ThinHeapNode<T> *a,
   }
 }
 
-template <typename T> std::string ThinHeapNode<T>::DebugString() const {
+template <typename T, typename Id, typename Compare>
+std::string ThinHeapNode<T, Id, Compare>::DebugString() const {
   std::stringstream out;
   out << key_ << " [id:" << id_ << "][rank:" << rank_ << "]";
 
@@ -189,8 +211,9 @@ template <typename T> std::string ThinHeapNode<T>::DebugString() const {
   return out.str();
 }
 
-template <typename T>
-void ThinHeapNode<T>::PrintTree(std::ostream &out, int level) const {
+template <typename T, typename Id, typename Compare>
+void ThinHeapNode<T, Id, Compare>::PrintTree(std::ostream &out,
+                                             int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -200,8 +223,9 @@ void ThinHeapNode<T>::PrintTree(std::ostream &out, int level) const {
   }
 }
 
-template <typename T>
-void ThinHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
+template <typename T, typename Id, typename Compare>
+void ThinHeapNode<T, Id, Compare>::Validate(
+    std::unordered_set<Id> *seen_ids) const {
   if (seen_ids != nullptr) {
     CHECK(seen_ids->insert(id_).second);
   }
@@ -215,7 +239,7 @@ void ThinHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
          child = child->right(), child_rank--) {
       CHECK(!child->is_root());
       CHECK(child->rank_ == child_rank);
-      CHECK(!(child->key_ < key_));
+      CHECK(!Less_(child->key_, key_));
       child->Validate(seen_ids);
       if (child->right_ != nullptr) {
         CHECK(child->right_->left_ == child);
@@ -226,15 +250,17 @@ void ThinHeapNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
   }
 }
 
-template <typename T> class ThinHeap : public Heap<T> {
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class ThinHeap : public Heap<T, typename Ids::Id> {
 public:
-  ThinHeap() : min_root_(nullptr), root_(nullptr) {
-    roots_by_rank_.resize(1, nullptr);
-  }
-  ~ThinHeap() { ThinHeapNode<T>::DeleteTree(root_); }
+  using Id = typename Ids::Id;
+
+  ThinHeap() : min_root_(nullptr), root_(nullptr) {}
+  ~ThinHeap() { ThinHeapNode<T, Id, Compare>::DeleteTree(root_); }
 
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Thin Heap", []() { return new ThinHeap<T>{}; });
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Thin Heap", []() { return new ThinHeap<T, Ids, Compare>{}; });
   }
 
   // Returns number of elements.
@@ -243,19 +269,25 @@ public:
   }
 
   // Adds an element with given key and unique int key.
-  virtual void Add(T key, int id) override;
+  virtual void Add(T key, Id id) override;
 
   // Updates with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the min element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print for debugging.
   virtual void PrintTree(std::ostream &out,
@@ -264,58 +296,129 @@ public:
   // Validate the invariants.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return size() * AllocationSize(sizeof(ThinHeapNode<T, Id, Compare>)) +
+           id_to_node_.MemoryUsage();
+  }
+
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   // Merge a tree into `roots_by_rank_`, combining with other trees of the
   // same rank if necessary.
-  void MergeRoot_(ThinHeapNode<T> *root);
+  void MergeRoot_(ThinHeapNode<T, Id, Compare> *root);
 
   // Cut a tree and move it to the list of nodes. Adjust the tree's nearby
   // nodes to keep the heap invariants.
-  void CutAndMoveToRoot_(ThinHeapNode<T> *tree);
+  void CutAndMoveToRoot_(ThinHeapNode<T, Id, Compare> *tree);
 
   // Fix the rank after `tree` is cut.
-  void LowerRank_(ThinHeapNode<T> *tree);
+  void LowerRank_(ThinHeapNode<T, Id, Compare> *tree);
+
+  // Removes a root, consolidates the roots with its children, and returns
+  // its element.
+  HeapElement<T, Id> RemoveRoot_(ThinHeapNode<T, Id, Compare> *node);
 
   // The minimum root. This points to one of the node in the `root_` linked
   // list.
-  ThinHeapNode<T> *min_root_;
+  ThinHeapNode<T, Id, Compare> *min_root_;
 
   // Linked list of root nodes.
-  ThinHeapNode<T> *root_;
+  ThinHeapNode<T, Id, Compare> *root_;
 
   // Roots indexed by their rank.
-  std::vector<ThinHeapNode<T> *> roots_by_rank_;
+  RootsByRank<ThinHeapNode<T, Id, Compare>> roots_by_rank_;
 
   // Map of each id to the node.
-  std::unordered_map<int, ThinHeapNode<T> *> id_to_node_;
+  typename Ids::template Index<ThinHeapNode<T, Id, Compare> *> id_to_node_;
 };
 
-template <typename T> void ThinHeap<T>::Add(T key, int id) {
-  auto *node = new ThinHeapNode<T>{key, id};
-  CHECK(id_to_node_.emplace(id, node).second);
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::Add(T key, Id id) {
+  auto *node = new ThinHeapNode<T, Id, Compare>{std::move(key), id};
+  CHECK(id_to_node_.Insert(id, node));
+  this->AddStat_(&HeapStats::adds);
 
-  if (min_root_ == nullptr || key < min_root_->key()) {
+  if (min_root_ == nullptr || Less_(node->key(), min_root_->key())) {
     min_root_ = node;
   }
   node->set_right(root_);
   root_ = node;
 }
 
-template <typename T> void ThinHeap<T>::ReduceKey(T new_key, int id) {
-  auto *node = id_to_node_[id];
-  node->set_key(new_key);
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  auto *node = *id_to_node_.Find(id);
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::reduce_keys);
 
-  if (new_key < min_root_->key()) {
+  if (Less_(node->key(), min_root_->key())) {
     min_root_ = node;
   }
 
   if (!node->is_root()) {
+    this->AddStat_(&HeapStats::cuts);
+    CutAndMoveToRoot_(node);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  ThinHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  CHECK(!Less_(new_key, node->key()));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Move the node and its children to the
+  // roots.
+  if (!node->is_root()) {
+    this->AddStat_(&HeapStats::cuts);
+    CutAndMoveToRoot_(node);
+  }
+  ThinHeapNode<T, Id, Compare> *next_tree;
+  for (auto *tree = node->TakeChildren(); tree != nullptr; tree = next_tree) {
+    next_tree = tree->right();
+    tree->clear_left();
+    tree->MakeThick();
+    tree->set_right(root_);
+    root_ = tree;
+    this->AddStat_(&HeapStats::cuts);
+  }
+
+  // Find the new minimum if it was the minimum.
+  if (node == min_root_) {
+    for (auto *root = root_; root != nullptr; root = root->right()) {
+      if (Less_(root->key(), min_root_->key())) {
+        min_root_ = root;
+      }
+    }
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::Remove(Id id) {
+  ThinHeapNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  this->AddStat_(&HeapStats::removes);
+
+  if (!node->is_root()) {
+    this->AddStat_(&HeapStats::cuts);
     CutAndMoveToRoot_(node);
   }
+  RemoveRoot_(node);
 }
 
-template <typename T>
-void ThinHeap<T>::CutAndMoveToRoot_(ThinHeapNode<T> *tree) {
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::CutAndMoveToRoot_(
+    ThinHeapNode<T, Id, Compare> *tree) {
   DCHECK(!tree->is_root());
 
   // Lower the ranks of the left siblings first.
@@ -328,7 +431,8 @@ void ThinHeap<T>::CutAndMoveToRoot_(ThinHeapNode<T> *tree) {
   root_ = tree;
 }
 
-template <typename T> void ThinHeap<T>::LowerRank_(ThinHeapNode<T> *tree) {
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::LowerRank_(ThinHeapNode<T, Id, Compare> *tree) {
   int rank = tree->rank();
   auto *left = tree->left();
 
@@ -363,38 +467,51 @@ template <typename T> void ThinHeap<T>::LowerRank_(ThinHeapNode<T> *tree) {
   }
 
   // Cut it, and drop the rank.
+  this->AddStat_(&HeapStats::cascading_cuts);
   CutAndMoveToRoot_(left);
   left->set_rank(rank);
 }
 
-template <typename T> const T *ThinHeap<T>::LookUp(int id) const {
-  const auto it = id_to_node_.find(id);
-  if (it == id_to_node_.end()) {
+template <typename T, typename Ids, typename Compare>
+const T *ThinHeap<T, Ids, Compare>::LookUp(Id id) const {
+  auto *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
     return nullptr;
   }
-  return &it->second->key();
+  return &(*node)->key();
 }
 
-template <typename T> HeapElement<T> ThinHeap<T>::Min() const {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> ThinHeap<T, Ids, Compare>::Min() const {
   DCHECK(size() > 0);
   return std::make_pair(min_root_->key(), min_root_->id());
 }
 
-template <typename T> HeapElement<T> ThinHeap<T>::PopMinimum() {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> ThinHeap<T, Ids, Compare>::PopMinimum() {
   DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  return RemoveRoot_(min_root_);
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id>
+ThinHeap<T, Ids, Compare>::RemoveRoot_(ThinHeapNode<T, Id, Compare> *node) {
+  DCHECK(node->is_root());
+  this->AddStat_(&HeapStats::consolidations);
 
   // Merge roots into `roots_by_rank_`.
-  ThinHeapNode<T> *next_tree;
+  ThinHeapNode<T, Id, Compare> *next_tree;
   for (auto *tree = root_; tree != nullptr; tree = next_tree) {
     next_tree = tree->right();
     tree->clear_right();
-    if (tree != min_root_) {
+    if (tree != node) {
       MergeRoot_(tree);
     }
   }
 
   // Sort the children of the root by rank.
-  for (auto *tree = min_root_->child(); tree != nullptr; tree = next_tree) {
+  for (auto *tree = node->child(); tree != nullptr; tree = next_tree) {
     next_tree = tree->right();
     tree->clear_left();
     tree->clear_right();
@@ -402,50 +519,45 @@ template <typename T> HeapElement<T> ThinHeap<T>::PopMinimum() {
     MergeRoot_(tree);
   }
 
-  id_to_node_.erase(min_root_->id());
-  auto result = std::make_pair(min_root_->key(), min_root_->id());
-  delete min_root_;
+  id_to_node_.Erase(node->id());
+  auto result = std::make_pair(node->take_key(), node->id());
+  delete node;
 
   // Link up the roots, with min root being the first root.
   min_root_ = nullptr;
   root_ = nullptr;
-  for (int i = 0; i < roots_by_rank_.size(); i++) {
-    auto *tree = roots_by_rank_[i];
-    if (tree != nullptr) {
-      roots_by_rank_[i] = nullptr;
-
-      if (min_root_ == nullptr || tree->key() < min_root_->key()) {
-        min_root_ = tree;
-      }
-      tree->set_right(root_);
-      root_ = tree;
+  while (!roots_by_rank_.empty()) {
+    auto *tree = roots_by_rank_.PopLowest();
+    if (min_root_ == nullptr || Less_(tree->key(), min_root_->key())) {
+      min_root_ = tree;
     }
+    tree->set_right(root_);
+    root_ = tree;
   }
 
   return result;
 }
 
-template <typename T> void ThinHeap<T>::MergeRoot_(ThinHeapNode<T> *root) {
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::MergeRoot_(ThinHeapNode<T, Id, Compare> *root) {
   auto rank = root->rank();
   while (true) {
-    auto *root2 = roots_by_rank_[rank];
+    auto *root2 = roots_by_rank_.Take(rank);
     if (root2 == nullptr) {
-      roots_by_rank_[rank] = root;
+      roots_by_rank_.Put(rank, root);
       break;
     }
-    roots_by_rank_[rank] = nullptr;
+    this->AddStat_(&HeapStats::links);
 
     // The merged root has a higher rank.
-    root = ThinHeapNode<T>::MergeTrees(root, root2);
+    root = ThinHeapNode<T, Id, Compare>::MergeTrees(root, root2);
     rank++;
-    if (rank >= roots_by_rank_.size()) {
-      roots_by_rank_.resize(rank + 1, nullptr);
-    }
   }
 }
 
-template <typename T>
-void ThinHeap<T>::PrintTree(std::ostream &out, const std::string &label) const {
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::PrintTree(std::ostream &out,
+                                          const std::string &label) const {
   out << std::endl
       << "-- Heap (" << size() << ") " << label << " --" << std::endl;
   for (const auto *root = root_; root != nullptr; root = root->right()) {
@@ -458,22 +570,39 @@ void ThinHeap<T>::PrintTree(std::ostream &out, const std::string &label) const {
   out << std::endl;
 }
 
-template <typename T> void ThinHeap<T>::Validate() const {
-  std::unordered_set<int> seen_ids;
+template <typename T, typename Ids, typename Compare>
+HeapStats ThinHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  std::vector<std::pair<const ThinHeapNode<T, Id, Compare> *, int>> stack;
+  for (const auto *root = root_; root != nullptr; root = root->right()) {
+    stats.num_trees++;
+    stack.emplace_back(root, 1);
+  }
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    stats.max_height = std::max(stats.max_height, entry.second);
+    for (const auto *child = entry.first->child(); child != nullptr;
+         child = child->right()) {
+      stack.emplace_back(child, entry.second + 1);
+    }
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void ThinHeap<T, Ids, Compare>::Validate() const {
+  std::unordered_set<Id> seen_ids;
   for (const auto *root = root_; root != nullptr; root = root->right()) {
     CHECK(root->is_root());
-    CHECK(!(root->key() < min_root_->key()));
+    CHECK(!Less_(root->key(), min_root_->key()));
     CHECK(root->rank() >= 0);
     root->Validate(&seen_ids);
   }
 
-  if (seen_ids.size() != size()) {
-    for (const auto &entry : id_to_node_) {
-      if (seen_ids.find(entry.first) == seen_ids.end()) {
-        LOG(ERROR) << "Id not seen: " << entry.first << std::endl;
-      }
-    }
-    LOG(FATAL) << "Some ids are missing";
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
   }
 }
 
@@ -1,12 +1,18 @@
 #ifndef HEAPS_TWO_THREE_HEAP_H_
 #define HEAPS_TWO_THREE_HEAP_H_
 
+#include <cstdint>
+#include <functional>
 #include <sstream>
 #include <unordered_set>
+#include <vector>
 
 #include "absl/log/check.h"
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
+#include "heaps/node_arena.h"
 
 // Node class used in 2-3 Heaps.
 //
@@ -16,73 +22,66 @@
 //
 // A trunk has one or two nodes, one is primary, and the other secondary.
 // The partner_ field links the two nodes to each other.
-template <typename T> class TwoThreeNode {
+//
+// Nodes do not own each other; the heap allocates and frees them.
+template <typename T, typename Id = int,
+          typename Compare = std::less<T>>
+class TwoThreeNode {
 public:
-  TwoThreeNode(T key, int id)
-      : key_(key), id_(id), dimension_(0), is_secondary_(false),
+  TwoThreeNode(T key, Id id)
+      : key_(std::move(key)), id_(id), dimension_(0), is_secondary_(false),
         partner_(nullptr), parent_(nullptr), child_(nullptr), left_(this),
         right_(this) {}
 
   // For the root only.
   TwoThreeNode()
-      : id_(-1), dimension_(0), is_secondary_(false), partner_(nullptr),
+      : id_(), dimension_(0), is_secondary_(false), partner_(nullptr),
         parent_(nullptr), child_(nullptr), left_(this), right_(this) {}
 
-  ~TwoThreeNode() {
-    if (partner_ != nullptr) {
-      partner_->partner_ = nullptr;
-      delete partner_;
-    }
-    if (child_ != nullptr) {
-      auto *child = child_;
-      do {
-        auto *next = child->right_;
-        delete child;
-        child = next;
-      } while (child != child_);
-    }
-  }
-
   const T &key() const { return key_; }
-  void set_key(T key) { key_ = key; }
+  void set_key(T key) { key_ = std::move(key); }
 
-  int id() const { return id_; }
+  // Moves the key out of the node.
+  T take_key() { return std::move(key_); }
+
+  Id id() const { return id_; }
   short dimension() const { return dimension_; }
 
   bool is_root() const { return parent_->parent_ == nullptr; }
 
   bool has_siblings() const { return right_ != this; }
 
-  TwoThreeNode<T> *partner() const { return partner_; }
+  TwoThreeNode<T, Id, Compare> *partner() const { return partner_; }
   bool is_secondary() const { return is_secondary_; }
 
-  TwoThreeNode<T> *parent() const { return parent_; }
-  void set_parent(TwoThreeNode<T> *parent) { parent_ = parent; }
+  TwoThreeNode<T, Id, Compare> *parent() const { return parent_; }
+  void set_parent(TwoThreeNode<T, Id, Compare> *parent) { parent_ = parent; }
   void clear_parent() { parent_ = nullptr; }
 
-  TwoThreeNode<T> *child() const { return child_; }
-  void set_child(TwoThreeNode<T> *child) { child_ = child; }
+  TwoThreeNode<T, Id, Compare> *child() const { return child_; }
+  void set_child(TwoThreeNode<T, Id, Compare> *child) { child_ = child; }
   void clear_child() { child_ = nullptr; }
 
   // Sibling nodes that have the same parent, organized in a cyclic linked list.
-  TwoThreeNode<T> *left() const { return left_; }
-  TwoThreeNode<T> *right() const { return right_; }
+  TwoThreeNode<T, Id, Compare> *left() const { return left_; }
+  TwoThreeNode<T, Id, Compare> *right() const { return right_; }
 
   // Attach a secondary partner to this primary node.
-  void AttachPartner(TwoThreeNode<T> *partner);
+  void AttachPartner(TwoThreeNode<T, Id, Compare> *partner);
 
   // Detach this secondary node from the primary node, so it can be inserted
   // somewhere else.
   void DetachFromTrunk();
 
   // Add a new child tree (of same dimension).
-  void AddChild(TwoThreeNode<T> *new_child);
+  void AddChild(TwoThreeNode<T, Id, Compare> *new_child);
 
   // Detach this node from the parent.
   void DetachFromParent();
 
   // Replace a child of this node with another.
-  void ReplaceChild(TwoThreeNode<T> *old_child, TwoThreeNode<T> *new_child);
+  void ReplaceChild(TwoThreeNode<T, Id, Compare> *old_child,
+                    TwoThreeNode<T, Id, Compare> *new_child);
 
   // Swap this node with its partner. Update the links.
   void SwapPartner();
@@ -96,8 +95,9 @@ public:
   // Merges two trees of dimendion D, return a pair of
   // <merged_tree, carry_tree>, where merged_tree has dimension D and
   // carry_tree has dimension D + 1.
-  static std::pair<TwoThreeNode<T> *, TwoThreeNode<T> *>
-  MergeTrees(TwoThreeNode<T> *a, TwoThreeNode<T> *b);
+  static std::pair<TwoThreeNode<T, Id, Compare> *,
+                   TwoThreeNode<T, Id, Compare> *>
+  MergeTrees(TwoThreeNode<T, Id, Compare> *a, TwoThreeNode<T, Id, Compare> *b);
 
   // Debug information about this node.
   std::string DebugString() const;
@@ -109,13 +109,16 @@ public:
   void PrintTree(std::ostream &out, int level) const;
 
   // Validate the tree structure under this node.
-  void Validate(std::unordered_set<int> *seen_ids = nullptr) const;
+  void Validate(std::unordered_set<Id> *seen_ids = nullptr) const;
 
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   T key_;
 
   // An id that uniquely identifies this node.
-  int id_;
+  Id id_;
 
   // Dimension of the tree at this node.
   short dimension_;
@@ -126,24 +129,25 @@ private:
 
   // This points to other node in trunk; the other points back to this.
   // This may be nullptr.
-  TwoThreeNode<T> *partner_;
+  TwoThreeNode<T, Id, Compare> *partner_;
 
   // Points to the parent node.
   // This should not be a nullptr unless it's a sentinel node.
-  TwoThreeNode<T> *parent_;
+  TwoThreeNode<T, Id, Compare> *parent_;
 
   // Points to the highest dimension child.
   // If this is a secondary node, this should be nullptr.
-  TwoThreeNode<T> *child_;
+  TwoThreeNode<T, Id, Compare> *child_;
 
   // Points to other second nodes, in a cyclic linked list.
   // If this is a secondary node, this should be nullptr.
-  TwoThreeNode<T> *left_;
-  TwoThreeNode<T> *right_;
+  TwoThreeNode<T, Id, Compare> *left_;
+  TwoThreeNode<T, Id, Compare> *right_;
 };
 
-template <typename T>
-void TwoThreeNode<T>::AttachPartner(TwoThreeNode<T> *partner) {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::AttachPartner(
+    TwoThreeNode<T, Id, Compare> *partner) {
   DCHECK(!is_secondary_);
 
   partner->partner_ = this;
@@ -152,7 +156,8 @@ void TwoThreeNode<T>::AttachPartner(TwoThreeNode<T> *partner) {
   partner_->is_secondary_ = true;
 }
 
-template <typename T> void TwoThreeNode<T>::DetachFromTrunk() {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::DetachFromTrunk() {
   DCHECK(is_secondary_);
   is_secondary_ = false;
   partner_->partner_ = nullptr;
@@ -160,10 +165,11 @@ template <typename T> void TwoThreeNode<T>::DetachFromTrunk() {
   parent_ = nullptr;
 }
 
-template <typename T>
-void TwoThreeNode<T>::AddChild(TwoThreeNode<T> *new_child) {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::AddChild(
+    TwoThreeNode<T, Id, Compare> *new_child) {
   DCHECK(!new_child->is_secondary_);
-  DCHECK(!(new_child->key_ < key_));
+  DCHECK(!Less_(new_child->key_, key_));
   DCHECK(new_child->dimension_ == dimension_);
 
   dimension_++;
@@ -184,7 +190,8 @@ void TwoThreeNode<T>::AddChild(TwoThreeNode<T> *new_child) {
   child_ = new_child;
 }
 
-template <typename T> void TwoThreeNode<T>::DetachFromParent() {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::DetachFromParent() {
   DCHECK(!is_secondary_);
 
   if (!has_siblings()) {
@@ -206,9 +213,10 @@ template <typename T> void TwoThreeNode<T>::DetachFromParent() {
   }
 }
 
-template <typename T>
-void TwoThreeNode<T>::ReplaceChild(TwoThreeNode<T> *old_child,
-                                   TwoThreeNode<T> *new_child) {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::ReplaceChild(
+    TwoThreeNode<T, Id, Compare> *old_child,
+    TwoThreeNode<T, Id, Compare> *new_child) {
   if (old_child->has_siblings()) {
     new_child->left_ = old_child->left_;
     new_child->right_ = old_child->right_;
@@ -237,7 +245,8 @@ void TwoThreeNode<T>::ReplaceChild(TwoThreeNode<T> *old_child,
   }
 }
 
-template <typename T> void TwoThreeNode<T>::SwapPartner() {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::SwapPartner() {
   DCHECK(!is_secondary_);
 
   // Update the sibling list so that it links to this node rather than the
@@ -260,28 +269,31 @@ template <typename T> void TwoThreeNode<T>::SwapPartner() {
   is_secondary_ = true;
 }
 
-template <typename T> void TwoThreeNode<T>::SwitchPartnerToChild() {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::SwitchPartnerToChild() {
   auto *partner = partner_;
   partner->DetachFromTrunk();
   AddChild(partner);
 }
 
-template <typename T> void TwoThreeNode<T>::SwitchChildToPartner() {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::SwitchChildToPartner() {
   DCHECK(partner_ == nullptr);
   auto *child = child_;
   child->DetachFromParent();
   AttachPartner(child);
 }
 
-template <typename T>
-std::pair<TwoThreeNode<T> *, TwoThreeNode<T> *>
-TwoThreeNode<T>::MergeTrees(TwoThreeNode<T> *a, TwoThreeNode<T> *b) {
+template <typename T, typename Id, typename Compare>
+std::pair<TwoThreeNode<T, Id, Compare> *, TwoThreeNode<T, Id, Compare> *>
+TwoThreeNode<T, Id, Compare>::MergeTrees(TwoThreeNode<T, Id, Compare> *a,
+                                         TwoThreeNode<T, Id, Compare> *b) {
   DCHECK(!a->has_siblings());
   DCHECK(!b->has_siblings());
   DCHECK(a->dimension_ == b->dimension_);
 
   // Make a the smaller tree.
-  if (b->key_ < a->key_) {
+  if (Less_(b->key_, a->key_)) {
     std::swap(a, b);
   }
 
@@ -308,7 +320,7 @@ TwoThreeNode<T>::MergeTrees(TwoThreeNode<T> *a, TwoThreeNode<T> *b) {
   if (b_partner == nullptr) {
     a_partner->DetachFromTrunk();
 
-    if (a_partner->key_ < b->key_) {
+    if (Less_(a_partner->key_, b->key_)) {
       a_partner->AttachPartner(b);
       a->AddChild(a_partner);
     } else {
@@ -327,7 +339,8 @@ TwoThreeNode<T>::MergeTrees(TwoThreeNode<T> *a, TwoThreeNode<T> *b) {
 }
 
 // Debug information about this node.
-template <typename T> std::string TwoThreeNode<T>::DebugString() const {
+template <typename T, typename Id, typename Compare>
+std::string TwoThreeNode<T, Id, Compare>::DebugString() const {
   std::stringstream out;
   out << key_ << " [id:" << id_ << "][dim:" << dimension_ << "]";
 
@@ -363,17 +376,18 @@ template <typename T> std::string TwoThreeNode<T>::DebugString() const {
   return out.str();
 }
 
-template <typename T>
-void TwoThreeNode<T>::PrintTree(std::ostream &out,
-                                const std::string &label) const {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::PrintTree(std::ostream &out,
+                                             const std::string &label) const {
   out << label << ":" << std::endl;
   PrintTree(out, 0);
   out << std::endl;
 }
 
 // Print out node information recursively.
-template <typename T>
-void TwoThreeNode<T>::PrintTree(std::ostream &out, int level) const {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::PrintTree(std::ostream &out,
+                                             int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -394,8 +408,9 @@ void TwoThreeNode<T>::PrintTree(std::ostream &out, int level) const {
   }
 }
 
-template <typename T>
-void TwoThreeNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
+template <typename T, typename Id, typename Compare>
+void TwoThreeNode<T, Id, Compare>::Validate(
+    std::unordered_set<Id> *seen_ids) const {
   if (seen_ids != nullptr) {
     CHECK(seen_ids->insert(id_).second);
   }
@@ -409,7 +424,7 @@ void TwoThreeNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
   }
 
   if (!is_secondary_ && partner_ != nullptr) {
-    CHECK(!(partner_->key_ < key_));
+    CHECK(!Less_(partner_->key_, key_));
     CHECK(partner_->partner_ == this);
     CHECK(partner_->parent_ == parent_);
     CHECK(partner_->dimension_ == dimension_);
@@ -424,7 +439,7 @@ void TwoThreeNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
       CHECK(child != nullptr);
       CHECK(child_dim >= 0);
 
-      CHECK(!(child->key_ < key_));
+      CHECK(!Less_(child->key_, key_));
       CHECK(!child->is_secondary_);
       CHECK(child->dimension() == child_dim);
       CHECK(child->right_->left_ == child);
@@ -440,19 +455,19 @@ void TwoThreeNode<T>::Validate(std::unordered_set<int> *seen_ids) const {
 // 2-3 Heap is a heap data structure that allows the min key to be
 // computed in O(log n) time, and a key to be decreased in O(1)
 // amortized time.
-template <typename T> class TwoThreeHeap : public Heap<T> {
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class TwoThreeHeap : public Heap<T, typename Ids::Id> {
 public:
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("2-3 Heap", []() { return new TwoThreeHeap<T>(); });
+  using Id = typename Ids::Id;
+
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "2-3 Heap", []() { return new TwoThreeHeap<T, Ids, Compare>(); });
   }
 
-  TwoThreeHeap() : max_root_dim_(-1) {}
+  TwoThreeHeap() : root_dims_(0) {}
 
-  virtual ~TwoThreeHeap() {
-    for (auto *sentinel : sentinels_) {
-      delete sentinel;
-    }
-  }
+  virtual ~TwoThreeHeap();
 
   // Number of nodes in the heap.
   virtual int size() const override {
@@ -460,20 +475,26 @@ public:
   }
 
   // Add an element with the given key and unique id.
-  virtual void Add(T key, int id) override;
+  virtual void Add(T key, Id id) override;
 
   // Returns the element as a (key, id) pair.
-  virtual std::pair<T, int> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Remove the min element and return its (key, id).
   // Amortized code: O(log n).
-  virtual std::pair<T, int> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Decrease the key of a node.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Increase the key of a node.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Remove a node by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Print the heap in tree format.
   virtual void PrintTree(std::ostream &out,
@@ -482,62 +503,113 @@ public:
   // Validate the structure of the heap.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return nodes_.MemoryUsage() + id_to_node_.MemoryUsage();
+  }
+
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
   // Returns the node with the min key.
-  TwoThreeNode<T> *Min_() const;
+  TwoThreeNode<T, Id, Compare> *Min_() const;
 
   // Inserts a new tree to the heap.
-  void InsertRoot_(TwoThreeNode<T> *tree);
+  void InsertRoot_(TwoThreeNode<T, Id, Compare> *tree);
 
   // Remove a subtree from the heap and make the necessary adjustments to
   // neighboring nodes to keep the structure.
-  void RemoveTree_(TwoThreeNode<T> *tree);
+  void RemoveTree_(TwoThreeNode<T, Id, Compare> *tree);
+
+  // Detach the children of a tree, and insert them as roots.
+  void InsertChildren_(TwoThreeNode<T, Id, Compare> *tree);
 
   // Make a trunk from the given subtrees.
-  TwoThreeNode<T> *MakeTrunk_(TwoThreeNode<T> *a, TwoThreeNode<T> *b);
+  TwoThreeNode<T, Id, Compare> *MakeTrunk_(TwoThreeNode<T, Id, Compare> *a,
+                                           TwoThreeNode<T, Id, Compare> *b);
 
   // Returns the root node for the given dimension.
-  TwoThreeNode<T> *Root_(short dim);
+  TwoThreeNode<T, Id, Compare> *Root_(short dim);
 
   // Sets the given node as a root for that dimension.
-  void SetRoot_(TwoThreeNode<T> *root);
+  void SetRoot_(TwoThreeNode<T, Id, Compare> *root);
 
   // Remove the root for the given dimension.
   void ClearRoot_(short dim);
 
-  // Increase the number of sentinel nodes if necessary.
-  void ExtendSentinels_(short dim);
+  // A tree of dimension d has at least 2^d nodes, so with int sizes,
+  // dimensions are below 31.
+  static const int kMaxDimensions = 32;
 
   // Sentinel nodes for each dimension.
-  // sentinels_[dimension]->child() gives the root of the tree for that
+  // sentinels_[dimension].child() gives the root of the tree for that
   // dimension.
-  std::vector<TwoThreeNode<T> *> sentinels_;
+  TwoThreeNode<T, Id, Compare> sentinels_[kMaxDimensions];
 
-  // Highest dimension of the roots.
-  int max_root_dim_;
+  // Bit d is set if there is a root of dimension d.
+  uint32_t root_dims_;
+
+  NodeArena<TwoThreeNode<T, Id, Compare>> nodes_;
 
   // Map of each id to the node.
-  std::unordered_map<int, TwoThreeNode<T> *> id_to_node_;
+  typename Ids::template Index<TwoThreeNode<T, Id, Compare> *> id_to_node_;
 };
 
-template <typename T> void TwoThreeHeap<T>::Add(T key, int id) {
-  TwoThreeNode<T> *node = new TwoThreeNode<T>{key, id};
+template <typename T, typename Ids, typename Compare>
+TwoThreeHeap<T, Ids, Compare>::~TwoThreeHeap() {
+  // Walk the trees to delete the nodes, as the id index may not list them.
+  std::vector<TwoThreeNode<T, Id, Compare> *> stack;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    if (sentinels_[i].child() != nullptr) {
+      stack.push_back(sentinels_[i].child());
+    }
+  }
+  while (!stack.empty()) {
+    auto *node = stack.back();
+    stack.pop_back();
+    if (!node->is_secondary() && node->partner() != nullptr) {
+      stack.push_back(node->partner());
+    }
+    auto *first_child = node->child();
+    if (first_child != nullptr) {
+      auto *child = first_child;
+      do {
+        stack.push_back(child);
+        child = child->right();
+      } while (child != first_child);
+    }
+    nodes_.Delete(node);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::Add(T key, Id id) {
+  auto *node = nodes_.New(std::move(key), id);
   InsertRoot_(node);
-  CHECK(id_to_node_.emplace(id, node).second);
+  CHECK(id_to_node_.Insert(id, node));
+  this->AddStat_(&HeapStats::adds);
 }
 
-template <typename T> std::pair<T, int> TwoThreeHeap<T>::Min() const {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> TwoThreeHeap<T, Ids, Compare>::Min() const {
   const auto *min_node = Min_();
   return std::make_pair(min_node->key(), min_node->id());
 }
 
-template <typename T> std::pair<T, int> TwoThreeHeap<T>::PopMinimum() {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> TwoThreeHeap<T, Ids, Compare>::PopMinimum() {
   DCHECK(size() > 0);
+  this->AddStat_(&HeapStats::pops);
+  this->AddStat_(&HeapStats::consolidations);
 
-  TwoThreeNode<T> *min_root = Min_();
+  TwoThreeNode<T, Id, Compare> *min_root = Min_();
 
   // Take care of the partner node.
-  TwoThreeNode<T> *partner = min_root->partner();
+  TwoThreeNode<T, Id, Compare> *partner = min_root->partner();
   if (partner != nullptr) {
     partner->DetachFromTrunk();
     SetRoot_(partner);
@@ -546,34 +618,33 @@ template <typename T> std::pair<T, int> TwoThreeHeap<T>::PopMinimum() {
   }
 
   // Re-insert the child nodes.
-  TwoThreeNode<T> *child;
-  while ((child = min_root->child()) != nullptr) {
-    child->DetachFromParent();
-    InsertRoot_(child);
-  }
+  InsertChildren_(min_root);
 
-  auto result = std::make_pair(min_root->key(), min_root->id());
-  id_to_node_.erase(min_root->id());
-  delete min_root;
+  auto result = std::make_pair(min_root->take_key(), min_root->id());
+  id_to_node_.Erase(min_root->id());
+  nodes_.Delete(min_root);
   return result;
 }
 
-template <typename T> void TwoThreeHeap<T>::ReduceKey(T new_key, int id) {
-  auto *node = id_to_node_[id];
-  node->set_key(new_key);
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  auto *node = *id_to_node_.Find(id);
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::reduce_keys);
 
   // Check if we need to reparent.
-  if (node->is_root() || !(new_key < node->parent()->key())) {
+  if (node->is_root() || !Less_(node->key(), node->parent()->key())) {
 
     // If the node is secondary and is now smaller, make it primary.
     auto *partner = node->partner();
-    if (node->is_secondary() && new_key < partner->key()) {
+    if (node->is_secondary() && Less_(node->key(), partner->key())) {
       partner->SwapPartner();
     }
     return;
   }
 
   // Detach the node and re-insert it to the appropriate root node.
+  this->AddStat_(&HeapStats::cuts);
   RemoveTree_(node);
 
   DCHECK(node->parent() == nullptr);
@@ -582,22 +653,54 @@ template <typename T> void TwoThreeHeap<T>::ReduceKey(T new_key, int id) {
   InsertRoot_(node);
 }
 
-template <typename T> const T *TwoThreeHeap<T>::LookUp(int id) const {
-  const auto it = id_to_node_.find(id);
-  if (it == id_to_node_.end()) {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  TwoThreeNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  CHECK(!Less_(new_key, node->key()));
+  node->set_key(std::move(new_key));
+  this->AddStat_(&HeapStats::increase_keys);
+
+  // The children may now be smaller. Detach the node, re-insert its children,
+  // and re-insert it alone.
+  this->AddStat_(&HeapStats::cuts);
+  RemoveTree_(node);
+  InsertChildren_(node);
+  InsertRoot_(node);
+}
+
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::Remove(Id id) {
+  TwoThreeNode<T, Id, Compare> **found = id_to_node_.Find(id);
+  CHECK(found != nullptr);
+  auto *node = *found;
+  id_to_node_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Detach the node, and re-insert its children.
+  this->AddStat_(&HeapStats::cuts);
+  RemoveTree_(node);
+  InsertChildren_(node);
+  nodes_.Delete(node);
+}
+
+template <typename T, typename Ids, typename Compare>
+const T *TwoThreeHeap<T, Ids, Compare>::LookUp(Id id) const {
+  auto *const *node = id_to_node_.Find(id);
+  if (node == nullptr) {
     return nullptr;
   }
-  return &it->second->key();
+  return &(*node)->key();
 }
 
-template <typename T>
-void TwoThreeHeap<T>::PrintTree(std::ostream &out,
-                                const std::string &label) const {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::PrintTree(std::ostream &out,
+                                              const std::string &label) const {
   out << std::endl
       << "-- Heap (" << size() << ") " << label << " --" << std::endl;
-  for (int i = 0; i <= max_root_dim_; ++i) {
-    const auto *sentinel = sentinels_[i];
-    const auto *root = sentinel->child();
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    const auto *root = sentinels_[i].child();
     if (root != nullptr) {
       out << "Tree #" << root->dimension() << std::endl;
       root->PrintTree(out, 1);
@@ -606,12 +709,14 @@ void TwoThreeHeap<T>::PrintTree(std::ostream &out,
   out << std::endl;
 }
 
-template <typename T> void TwoThreeHeap<T>::Validate() const {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::Validate() const {
   int dimension = 0;
-  std::unordered_set<int> seen_ids;
-  for (int i = 0; i <= max_root_dim_; ++i) {
-    const auto *sentinel = sentinels_[i];
+  std::unordered_set<Id> seen_ids;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    const auto *sentinel = &sentinels_[i];
     const auto *root = sentinel->child();
+    CHECK(((root_dims_ >> i) & 1) == (root != nullptr));
     if (root != nullptr) {
       CHECK(root->parent() == sentinel);
       CHECK(root->dimension() == dimension);
@@ -620,46 +725,81 @@ template <typename T> void TwoThreeHeap<T>::Validate() const {
     dimension++;
   }
 
-  if (seen_ids.size() != size()) {
-    for (const auto &entry : id_to_node_) {
-      if (seen_ids.find(entry.first) == seen_ids.end()) {
-        LOG(ERROR) << "Id not seen: " << entry.first;
-      }
+  CHECK(seen_ids.size() == size()) << "Some ids are missing";
+  for (const auto &id : seen_ids) {
+    CHECK(id_to_node_.Find(id) != nullptr) << "Id not indexed: " << id;
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats TwoThreeHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  std::vector<std::pair<const TwoThreeNode<T, Id, Compare> *, int>> stack;
+  for (int i = 0; i < kMaxDimensions; ++i) {
+    const auto *root = sentinels_[i].child();
+    if (root != nullptr) {
+      stats.num_trees++;
+      stack.emplace_back(root, 1);
     }
-    LOG(FATAL) << "Some ids are missing";
   }
+  while (!stack.empty()) {
+    auto entry = stack.back();
+    stack.pop_back();
+    const auto *node = entry.first;
+    stats.max_height = std::max(stats.max_height, entry.second);
+
+    // The secondary node of a trunk hangs one level below its primary.
+    if (!node->is_secondary() && node->partner() != nullptr) {
+      stack.emplace_back(node->partner(), entry.second + 1);
+    }
+    const auto *first_child = node->child();
+    if (first_child != nullptr) {
+      const auto *child = first_child;
+      do {
+        stack.emplace_back(child, entry.second + 1);
+        child = child->right();
+      } while (child != first_child);
+    }
+  }
+  return stats;
 }
 
-template <typename T> TwoThreeNode<T> *TwoThreeHeap<T>::Min_() const {
+template <typename T, typename Ids, typename Compare>
+TwoThreeNode<T, typename Ids::Id, Compare> *
+TwoThreeHeap<T, Ids, Compare>::Min_() const {
   DCHECK(size() > 0);
 
   // Find the min amongst the tree roots.
-  TwoThreeNode<T> *min_node = nullptr;
-  for (auto *sentinel : sentinels_) {
-    auto *root = sentinel->child();
-    if (root == nullptr) {
-      continue;
-    }
-    if (min_node == nullptr || root->key() < min_node->key()) {
+  uint32_t dims = root_dims_;
+  TwoThreeNode<T, Id, Compare> *min_node =
+      sentinels_[__builtin_ctz(dims)].child();
+  dims &= dims - 1;
+  while (dims != 0) {
+    auto *root = sentinels_[__builtin_ctz(dims)].child();
+    dims &= dims - 1;
+    if (Less_(root->key(), min_node->key())) {
       min_node = root;
     }
   }
   return min_node;
 }
 
-template <typename T> void TwoThreeHeap<T>::InsertRoot_(TwoThreeNode<T> *tree) {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::InsertRoot_(
+    TwoThreeNode<T, Id, Compare> *tree) {
   DCHECK(tree->parent() == nullptr);
   DCHECK(!tree->has_siblings());
 
   // If no root. Make this the root.
   short dim = tree->dimension();
-  TwoThreeNode<T> *root = Root_(dim);
+  TwoThreeNode<T, Id, Compare> *root = Root_(dim);
   if (root == nullptr) {
     SetRoot_(tree);
     return;
   }
 
-  auto result = TwoThreeNode<T>::MergeTrees(root, tree);
+  auto result = TwoThreeNode<T, Id, Compare>::MergeTrees(root, tree);
+  this->AddStat_(&HeapStats::links);
   if (result.first != nullptr) {
     SetRoot_(result.first);
   } else {
@@ -670,7 +810,9 @@ template <typename T> void TwoThreeHeap<T>::InsertRoot_(TwoThreeNode<T> *tree) {
   }
 }
 
-template <typename T> void TwoThreeHeap<T>::RemoveTree_(TwoThreeNode<T> *tree) {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::RemoveTree_(
+    TwoThreeNode<T, Id, Compare> *tree) {
   auto *parent = tree->parent();
   int dim = tree->dimension();
 
@@ -724,7 +866,7 @@ template <typename T> void TwoThreeHeap<T>::RemoveTree_(TwoThreeNode<T> *tree) {
       tree->DetachFromParent();
       parent->DetachFromTrunk();
       pp_child->AttachPartner(parent);
-      if (parent->key() < pp_child->key()) {
+      if (Less_(parent->key(), pp_child->key())) {
         pp_child->SwapPartner();
       }
     }
@@ -793,14 +935,25 @@ template <typename T> void TwoThreeHeap<T>::RemoveTree_(TwoThreeNode<T> *tree) {
   InsertRoot_(parent);
 }
 
-template <typename T>
-TwoThreeNode<T> *TwoThreeHeap<T>::MakeTrunk_(TwoThreeNode<T> *a,
-                                             TwoThreeNode<T> *b) {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::InsertChildren_(
+    TwoThreeNode<T, Id, Compare> *tree) {
+  TwoThreeNode<T, Id, Compare> *child;
+  while ((child = tree->child()) != nullptr) {
+    child->DetachFromParent();
+    InsertRoot_(child);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+TwoThreeNode<T, typename Ids::Id, Compare> *
+TwoThreeHeap<T, Ids, Compare>::MakeTrunk_(TwoThreeNode<T, Id, Compare> *a,
+                                          TwoThreeNode<T, Id, Compare> *b) {
   if (b == nullptr) {
     DCHECK(a->partner() == nullptr);
     return a;
   }
-  if (b->key() < a->key()) {
+  if (Less_(b->key(), a->key())) {
     b->AttachPartner(a);
     return b;
   }
@@ -808,15 +961,19 @@ TwoThreeNode<T> *TwoThreeHeap<T>::MakeTrunk_(TwoThreeNode<T> *a,
   return a;
 }
 
-template <typename T> TwoThreeNode<T> *TwoThreeHeap<T>::Root_(short dim) {
-  ExtendSentinels_(dim);
-  return sentinels_[dim]->child();
+template <typename T, typename Ids, typename Compare>
+TwoThreeNode<T, typename Ids::Id, Compare> *
+TwoThreeHeap<T, Ids, Compare>::Root_(short dim) {
+  DCHECK(dim < kMaxDimensions);
+  return sentinels_[dim].child();
 }
 
-template <typename T> void TwoThreeHeap<T>::SetRoot_(TwoThreeNode<T> *root) {
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::SetRoot_(
+    TwoThreeNode<T, Id, Compare> *root) {
   short dim = root->dimension();
-  ExtendSentinels_(dim);
-  auto *sentinel = sentinels_[dim];
+  DCHECK(dim < kMaxDimensions);
+  auto *sentinel = &sentinels_[dim];
   sentinel->set_child(root);
 
   root->set_parent(sentinel);
@@ -824,26 +981,13 @@ template <typename T> void TwoThreeHeap<T>::SetRoot_(TwoThreeNode<T> *root) {
   if (root_partner != nullptr) {
     root_partner->set_parent(sentinel);
   }
-
-  if (dim > max_root_dim_) {
-    max_root_dim_ = dim;
-  }
+  root_dims_ |= uint32_t{1} << dim;
 }
 
-template <typename T> void TwoThreeHeap<T>::ClearRoot_(short dim) {
-  sentinels_[dim]->clear_child();
-  if (dim == max_root_dim_) {
-    do {
-      max_root_dim_--;
-    } while (max_root_dim_ >= 0 &&
-             sentinels_[max_root_dim_]->child() == nullptr);
-  }
-}
-
-template <typename T> void TwoThreeHeap<T>::ExtendSentinels_(short dim) {
-  for (int size = sentinels_.size(); size <= dim; size++) {
-    sentinels_.push_back(new TwoThreeNode<T>());
-  }
+template <typename T, typename Ids, typename Compare>
+void TwoThreeHeap<T, Ids, Compare>::ClearRoot_(short dim) {
+  sentinels_[dim].clear_child();
+  root_dims_ &= ~(uint32_t{1} << dim);
 }
 
 #endif /* HEAPS_TWO_THREE_HEAP_H_ */
@@ -5,20 +5,26 @@
 #ifndef HEAPS_WEAK_HEAP_H_
 #define HEAPS_WEAK_HEAP_H_
 
+#include <functional>
 #include <iostream>
-#include <unordered_map>
 #include <vector>
 
 #include "base/factory.h"
+#include "base/memory.h"
 #include "heaps/heap.h"
+#include "heaps/id_index.h"
 
 // WeakHeap is a multi-way tree stored as a binary tree using the
 // "right-child left-sibling" convention.
-template <typename T> class WeakHeap : public Heap<T> {
+template <typename T, typename Ids = HeapIds<>, typename Compare = std::less<T>>
+class WeakHeap : public Heap<T, typename Ids::Id> {
 public:
+  using Id = typename Ids::Id;
+
   // A factory for this heap.
-  static Factory<Heap<T>> factory() {
-    return Factory<Heap<T>>("Weak Heap", []() { return new WeakHeap<T>{}; });
+  static Factory<Heap<T, Id>> factory() {
+    return Factory<Heap<T, Id>>(
+        "Weak Heap", []() { return new WeakHeap<T, Ids, Compare>{}; });
   };
 
   // Returns number of elements.
@@ -26,20 +32,26 @@ public:
     return static_cast<int>(elements_.size());
   }
 
-  // Adds an element with key and unique int id.
-  virtual void Add(T key, int id) override;
+  // Adds an element with key and unique id.
+  virtual void Add(T key, Id id) override;
 
   // Updates an element with a lower key.
-  virtual void ReduceKey(T new_key, int id) override;
+  virtual void ReduceKey(T new_key, Id id) override;
+
+  // Updates an element with a higher key.
+  virtual void IncreaseKey(T new_key, Id id) override;
+
+  // Removes an element by its id.
+  virtual void Remove(Id id) override;
 
   // Looks up a key by its id. Returns nullptr if not found.
-  virtual const T *LookUp(int id) const override;
+  virtual const T *LookUp(Id id) const override;
 
   // Returns the minimum element.
-  virtual HeapElement<T> Min() const override;
+  virtual HeapElement<T, Id> Min() const override;
 
   // Pops and returns the minimum key.
-  virtual HeapElement<T> PopMinimum() override;
+  virtual HeapElement<T, Id> PopMinimum() override;
 
   // Print the subtree under this node.
   void PrintTree(std::ostream &out, const std::string &label) const override;
@@ -47,15 +59,38 @@ public:
   // Validate the structure of the heap.
   virtual void Validate() const override;
 
+  // Returns the operation counters and shape of the heap.
+  virtual HeapStats Stats() const override;
+
+  // Returns the approximate bytes allocated by the heap.
+  virtual long MemoryUsage() const override {
+    return ContainerMemoryUsage(elements_) +
+           ContainerMemoryUsage(reverse_children_) +
+           id_to_index_.MemoryUsage();
+  }
+
 private:
+  // Returns true if key `a` goes above key `b` in the heap.
+  static bool Less_(const T &a, const T &b) { return Compare()(a, b); }
+
+  // Returns the position of the ancestor parent of the element at `pos`.
+  int Ancestor_(int pos) const {
+    int is_right_child;
+    do {
+      is_right_child = pos & 1;
+      pos /= 2;
+    } while (reverse_children_[pos] == is_right_child);
+    return pos;
+  }
+
   // Move element at `pos` upwards until its parent is smaller.
   void SiftUp_(int pos);
 
-  // Move the top element downwards until the constraints are satisfied.
-  void SiftDown_();
+  // Move the element at `pos` downwards until the constraints are satisfied.
+  void SiftDown_(int pos);
 
   // Set an element at particular position and update index.
-  void SetElement_(int pos, HeapElement<T> &&element);
+  void SetElement_(int pos, HeapElement<T, Id> &&element);
 
   // Print the heap.
   void Print_(int pos, std::ostream &out, int level) const;
@@ -64,45 +99,42 @@ private:
   void PrintTree_(int pos, std::ostream &out, int level) const;
 
   // Vector containing HeapElements.
-  std::vector<HeapElement<T>> elements_;
+  std::vector<HeapElement<T, Id>> elements_;
 
   // Vector of ints indicating whether to reverse the left/right child.
   // If reverse_children_[i] = 0, then element at (i * 2) is its sibling and
   // the element at (i * 2 + 1) is the child. If 1, it's the reverse.
   std::vector<char> reverse_children_;
 
-  // A map from the element int id to its index in `elements_` vector.
-  std::unordered_map<int, int> id_to_index_;
+  // A map from the element id to its index in `elements_` vector.
+  typename Ids::template Index<int> id_to_index_;
 };
 
-template <typename T> void WeakHeap<T>::Add(T key, int id) {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::Add(T key, Id id) {
   int pos = static_cast<int>(elements_.size());
-  CHECK(id_to_index_.emplace(id, pos).second);
-  elements_.emplace_back(key, id);
+  CHECK(id_to_index_.Insert(id, pos));
+  elements_.emplace_back(std::move(key), id);
   reverse_children_.push_back(0);
+  this->AddStat_(&HeapStats::adds);
   SiftUp_(pos);
 }
 
-template <typename T> void WeakHeap<T>::SiftUp_(int pos) {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::SiftUp_(int pos) {
   auto element = std::move(elements_[pos]);
 
   while (pos > 0) {
-    // Get to the ancestor parent.
-    int ancestor = pos;
-    int is_right_child;
-    do {
-      is_right_child = ancestor & 1;
-      ancestor /= 2;
-    } while (reverse_children_[ancestor] == is_right_child);
-
     // Done if parent is smaller.
+    int ancestor = Ancestor_(pos);
     auto &ancestor_element = elements_[ancestor];
-    if (!(element.first < ancestor_element.first)) {
+    if (!Less_(element.first, ancestor_element.first)) {
       break;
     }
 
     // Move the parent down.
     SetElement_(pos, std::move(ancestor_element));
+    this->AddStat_(&HeapStats::sift_steps);
     pos = ancestor;
   }
 
@@ -110,81 +142,139 @@ template <typename T> void WeakHeap<T>::SiftUp_(int pos) {
   SetElement_(pos, std::move(element));
 }
 
-template <typename T> void WeakHeap<T>::SiftDown_() {
-  if (elements_.size() <= 1) {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::SiftDown_(int pos) {
+  int child = pos * 2 + 1 - reverse_children_[pos];
+  if (child >= elements_.size()) {
     return;
   }
-  auto top_element = std::move(elements_[0]);
+  auto top_element = std::move(elements_[pos]);
 
-  // Traverse to the last child of root.
-  int pos = 1;
+  // Traverse to the last child of pos.
   do {
-    pos = pos * 2 + reverse_children_[pos];
-  } while (pos < elements_.size());
+    child = child * 2 + reverse_children_[child];
+  } while (child < elements_.size());
 
-  // Traverse the siblings up to the root.
-  for (pos /= 2; pos > 0; pos /= 2) {
-    if (!(elements_[pos].first < top_element.first)) {
+  // Traverse the siblings up to pos, joining each with pos.
+  for (child /= 2; child != pos; child /= 2) {
+    this->AddStat_(&HeapStats::links);
+    if (!Less_(elements_[child].first, top_element.first)) {
       continue;
     }
 
-    // Swap elements_[pos] and top_element.
-    auto temp = std::move(elements_[pos]);
-    SetElement_(pos, std::move(top_element));
+    // Swap elements_[child] and top_element.
+    auto temp = std::move(elements_[child]);
+    SetElement_(child, std::move(top_element));
     top_element = std::move(temp);
 
     // Reverse the left/right children.
-    reverse_children_[pos] = 1 - reverse_children_[pos];
+    reverse_children_[child] = 1 - reverse_children_[child];
+    this->AddStat_(&HeapStats::sift_steps);
   }
 
-  SetElement_(0, std::move(top_element));
+  SetElement_(pos, std::move(top_element));
 }
 
-template <typename T> const T *WeakHeap<T>::LookUp(int id) const {
-  const auto it = id_to_index_.find(id);
-  if (it == id_to_index_.end()) {
+template <typename T, typename Ids, typename Compare>
+const T *WeakHeap<T, Ids, Compare>::LookUp(Id id) const {
+  const int *found = id_to_index_.Find(id);
+  if (found == nullptr) {
     return nullptr;
   }
-  return &elements_[it->second].first;
+  return &elements_[*found].first;
 }
 
-template <typename T> HeapElement<T> WeakHeap<T>::Min() const {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> WeakHeap<T, Ids, Compare>::Min() const {
   return elements_.front();
 }
 
-template <typename T> HeapElement<T> WeakHeap<T>::PopMinimum() {
+template <typename T, typename Ids, typename Compare>
+HeapElement<T, typename Ids::Id> WeakHeap<T, Ids, Compare>::PopMinimum() {
   DCHECK(!elements_.empty());
-  id_to_index_.erase(elements_[0].second);
+  this->AddStat_(&HeapStats::pops);
+  id_to_index_.Erase(elements_[0].second);
   auto min_element = std::move(elements_[0]);
 
   if (elements_.size() == 1) {
     elements_.pop_back();
+    reverse_children_.pop_back();
   } else {
     // Move last element to the head of the heap and sift down.
     SetElement_(0, std::move(elements_.back()));
     elements_.pop_back();
-    SiftDown_();
+    reverse_children_.pop_back();
+    SiftDown_(0);
   }
   return std::move(min_element);
 }
 
-template <typename T> void WeakHeap<T>::ReduceKey(T new_key, int id) {
-  auto it = id_to_index_.find(id);
-  CHECK(it != id_to_index_.end());
-  int index = it->second;
-  CHECK(!(elements_[index].first < new_key));
-  elements_[index].first = new_key;
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::ReduceKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(elements_[index].first, new_key));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::reduce_keys);
   SiftUp_(index);
 }
 
-template <typename T>
-void WeakHeap<T>::SetElement_(int pos, HeapElement<T> &&element) {
-  id_to_index_[element.second] = pos;
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::IncreaseKey(T new_key, Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  CHECK(!Less_(new_key, elements_[index].first));
+  elements_[index].first = std::move(new_key);
+  this->AddStat_(&HeapStats::increase_keys);
+  SiftDown_(index);
+}
+
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::Remove(Id id) {
+  int *found = id_to_index_.Find(id);
+  CHECK(found != nullptr);
+  int index = *found;
+  id_to_index_.Erase(id);
+  this->AddStat_(&HeapStats::removes);
+
+  // Move the last element into the hole, and sift it up or down.
+  auto last = std::move(elements_.back());
+  elements_.pop_back();
+  reverse_children_.pop_back();
+  if (index == size()) {
+    return;
+  }
+  SetElement_(index, std::move(last));
+  if (index > 0 &&
+      Less_(elements_[index].first, elements_[Ancestor_(index)].first)) {
+    SiftUp_(index);
+  } else {
+    SiftDown_(index);
+  }
+}
+
+template <typename T, typename Ids, typename Compare>
+HeapStats WeakHeap<T, Ids, Compare>::Stats() const {
+  HeapStats stats = this->stats_;
+  stats.num_trees = elements_.empty() ? 0 : 1;
+  for (int n = size(); n > 0; n /= 2) {
+    stats.max_height++;
+  }
+  return stats;
+}
+
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::SetElement_(
+    int pos, HeapElement<T, Id> &&element) {
+  id_to_index_.Set(element.second, pos);
   elements_[pos] = std::move(element);
 }
 
-template <typename T>
-void WeakHeap<T>::PrintTree(std::ostream &out, const std::string &label) const {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::PrintTree(std::ostream &out,
+                                          const std::string &label) const {
   out << std::endl
       << "-- Heap (" << size() << ") " << label << " --" << std::endl;
 
@@ -197,8 +287,9 @@ void WeakHeap<T>::PrintTree(std::ostream &out, const std::string &label) const {
   out << std::endl;
 }
 
-template <typename T>
-void WeakHeap<T>::Print_(int pos, std::ostream &out, int level) const {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::Print_(
+    int pos, std::ostream &out, int level) const {
   for (int i = 0; i < level; ++i) {
     out << "| ";
   }
@@ -208,8 +299,9 @@ void WeakHeap<T>::Print_(int pos, std::ostream &out, int level) const {
       << std::endl;
 }
 
-template <typename T>
-void WeakHeap<T>::PrintTree_(int pos, std::ostream &out, int level) const {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::PrintTree_(
+    int pos, std::ostream &out, int level) const {
   Print_(pos, out, level);
 
   int child_pos = pos * 2;
@@ -228,24 +320,17 @@ void WeakHeap<T>::PrintTree_(int pos, std::ostream &out, int level) const {
   }
 }
 
-template <typename T> void WeakHeap<T>::Validate() const {
+template <typename T, typename Ids, typename Compare>
+void WeakHeap<T, Ids, Compare>::Validate() const {
   if (elements_.size() > 0) {
     CHECK(reverse_children_[0] == 0);
   }
 
   for (int pos = 1; pos < elements_.size(); ++pos) {
-    // Get the ancestor parent.
-    int ancestor = pos;
-    int is_right_child;
-    do {
-      is_right_child = ancestor & 1;
-      ancestor /= 2;
-    } while (reverse_children_[ancestor] == is_right_child);
-
-    CHECK(!(elements_[pos].first < elements_[ancestor].first));
+    CHECK(!Less_(elements_[pos].first, elements_[Ancestor_(pos)].first));
   }
   for (int pos = 0; pos < elements_.size(); ++pos) {
-    CHECK(id_to_index_.find(elements_[pos].second)->second == pos);
+    CHECK(*id_to_index_.Find(elements_[pos].second) == pos);
   }
 
   CHECK(id_to_index_.size() == elements_.size());
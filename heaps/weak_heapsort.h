@@ -0,0 +1,121 @@
+// Weak-heapsort.
+//
+// Sorts an array in place with at most n ceil(log n) - 2^ceil(log n) + n - 1
+// comparisons, that is at most n log n + 0.1 n, using one extra bit per
+// element. Building the heap takes n - 1 of them. See Dutton, "Weak-heap
+// sort" (1993), and Edelkamp and Wegener, "On the performance of
+// weak-heapsort" (2000).
+
+#ifndef HEAPS_WEAK_HEAPSORT_H_
+#define HEAPS_WEAK_HEAPSORT_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "base/memory.h"
+
+// The reverse bits of a weak heap, packed 64 to a word.
+//
+// If bit i is 0, then the element at (i * 2) is the sibling of element i,
+// and the element at (i * 2 + 1) is its child. If 1, it's the reverse.
+class WeakHeapBits {
+public:
+  WeakHeapBits() : size_(0) {}
+
+  int size() const { return size_; }
+
+  int operator[](int i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+
+  void Flip(int i) { words_[i >> 6] ^= uint64_t{1} << (i & 63); }
+
+  // Appends a 0 bit.
+  void PushBack() {
+    if ((size_ & 63) == 0) {
+      words_.push_back(0);
+    }
+    size_++;
+  }
+
+  void PopBack() {
+    size_--;
+    words_[size_ >> 6] &= ~(uint64_t{1} << (size_ & 63));
+    if ((size_ & 63) == 0) {
+      words_.pop_back();
+    }
+  }
+
+  // Sets `size` bits, all 0.
+  void Reset(int size) {
+    size_ = size;
+    words_.assign((size + 63) / 64, 0);
+  }
+
+  long MemoryUsage() const { return ContainerMemoryUsage(words_); }
+
+private:
+  int size_;
+  std::vector<uint64_t> words_;
+};
+
+// Returns the distinguished ancestor of element `i` > 0: the parent of the
+// first ancestor, from `i` up, that is a child rather than a sibling.
+inline int WeakHeapAncestor(const WeakHeapBits &bits, int i) {
+  int is_right_child;
+  do {
+    is_right_child = i & 1;
+    i >>= 1;
+  } while (bits[i] == is_right_child);
+  return i;
+}
+
+// Builds a weak heap of `n` elements bottom-up with n - 1 comparisons.
+// `before(i, j)` returns whether element i belongs above element j, and
+// `swap(i, j)` swaps them. Resets `bits`.
+template <typename Before, typename Swap>
+void WeakHeapify(int n, WeakHeapBits *bits, Before before, Swap swap) {
+  bits->Reset(n);
+  for (int i = n - 1; i > 0; --i) {
+    int ancestor = WeakHeapAncestor(*bits, i);
+    if (before(i, ancestor)) {
+      swap(ancestor, i);
+      bits->Flip(i);
+    }
+  }
+}
+
+// Sorts [begin, end) in ascending order by operator<.
+template <typename T> void WeakHeapSort(T *begin, T *end) {
+  const int n = static_cast<int>(end - begin);
+  if (n < 2) {
+    return;
+  }
+
+  // Build a weak max-heap.
+  WeakHeapBits bits;
+  auto join = [begin, &bits](int ancestor, int i) {
+    if (begin[ancestor] < begin[i]) {
+      std::swap(begin[ancestor], begin[i]);
+      bits.Flip(i);
+    }
+  };
+  WeakHeapify(
+      n, &bits, [begin](int i, int j) { return begin[j] < begin[i]; },
+      [begin](int i, int j) { std::swap(begin[i], begin[j]); });
+
+  // Move the max to the end, then join the root with each node on the path
+  // of siblings from its child down, bottom-up.
+  for (int last = n - 1; last >= 2; --last) {
+    std::swap(begin[0], begin[last]);
+    int pos = 1;
+    for (int next; (next = 2 * pos + bits[pos]) < last;) {
+      pos = next;
+    }
+    for (; pos > 0; pos >>= 1) {
+      join(0, pos);
+    }
+  }
+  std::swap(begin[0], begin[1]);
+}
+
+#endif /* HEAPS_WEAK_HEAPSORT_H_ */
@@ -1,46 +1,41 @@
 #ifndef SHORTEST_PATH_DIJKSTRA_SHORTEST_PATH_H_
 #define SHORTEST_PATH_DIJKSTRA_SHORTEST_PATH_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "graph/weighted_graph.h"
+#include "heaps/heap.h"
 #include "shortest_path/shortest_path.h"
 
 namespace {
-// Print number of Heap operations.
+// Print the heap's operation counters after each search. These are only
+// counted, and printed, when built with HEAPS_ENABLE_STATS.
 const bool kDebugPrintStats = false;
 } // namespace
 
-// Distance from start vertex to this vertex.
-// Used by DijkstraShortestPath to keep track of min distance to the vertex.
-template <typename T> struct DistanceNode {
-  DistanceNode() {}
-  DistanceNode(VertexId vertex_id, T distance)
-      : vertex_id(vertex_id), distance(distance) {}
-
-  VertexId vertex_id;
-  T distance;
-
-  bool operator<(const DistanceNode<T> &other) const {
-    return distance < other.distance;
-  };
-};
-
-template <typename T>
-std::ostream &operator<<(std::ostream &out, const DistanceNode<T> &node) {
-  out << "[" << node.distance << "]";
-  return out;
-}
-
 // An implementation of the Dijktra's Shortest Path algorithm.
+//
+// The heap holds each reached vertex that is not settled yet, keyed by its
+// distance, with the vertex as its id. The distances themselves are kept in
+// an array indexed by vertex id, which is what the search reads; the heap is
+// only asked for the next closest vertex.
+//
+// The arrays are kept between searches, and a search only resets the
+// vertices reached by the one before, so repeated point-to-point queries
+// cost the vertices they reach rather than the size of the graph.
 template <typename T> class DijkstraShortestPath : public ShortestPath<T> {
 public:
-  DijkstraShortestPath(Factory<Heap<DistanceNode<T>>> heap_factory)
-      : heap_factory_(heap_factory) {}
+  DijkstraShortestPath(Factory<Heap<T>> heap_factory)
+      : heap_factory_(heap_factory), num_settled_(0) {}
 
   // Factory to create an instance.
-  static Factory<ShortestPath<T>>
-  factory(Factory<Heap<DistanceNode<T>>> heap_factory) {
+  static Factory<ShortestPath<T>> factory(Factory<Heap<T>> heap_factory) {
     return Factory<ShortestPath<T>>(
         "Dijkstra's Shortest Path (" + heap_factory.name() + ")",
         [heap_factory]() { return new DijkstraShortestPath<T>{heap_factory}; });
@@ -50,95 +45,181 @@ public:
   virtual std::unordered_map<VertexId, Path<T>>
   Run(const WeightedGraph<T> &graph, VertexId start_vertex_index) override;
 
+  // Find the shortest path to one node, stopping as soon as it is settled.
+  virtual bool RunToTarget(const WeightedGraph<T> &graph,
+                           VertexId start_vertex_id, VertexId target_vertex_id,
+                           Path<T> *path, int *num_settled) override;
+
+  // Returns the operation counters of the heaps of all the searches so far,
+  // and the largest heap shape. They are all zero unless built with
+  // HEAPS_ENABLE_STATS.
+  const HeapStats &heap_stats() const { return heap_stats_; }
+
 private:
-  Factory<Heap<DistanceNode<T>>> heap_factory_;
+  // The state of a vertex in the current search.
+  enum VertexState : uint8_t { kUnreached, kInHeap, kSettled };
+
+  // Settles vertices in order of distance from `start_vertex_id`, until all
+  // reachable vertices are settled or `target_vertex_id` is settled. Pass
+  // kNoTargetVertex to settle all.
+  void Search_(const WeightedGraph<T> &weighted_graph,
+               VertexId start_vertex_id, VertexId target_vertex_id);
+
+  // Fills in the vertices of `path` to `vertex_id`, by tracing
+  // `prev_vertices_` backwards to `start_vertex_id`.
+  void TracePath_(VertexId start_vertex_id, VertexId vertex_id,
+                  Path<T> *path) const;
+
+  static const VertexId kNoTargetVertex = -1;
+
+  Factory<Heap<T>> heap_factory_;
+
+  // The shortest distance found so far from the start vertex to each reached
+  // vertex. For the vertices in the heap, this is also their key.
+  std::vector<T> distances_;
+
+  // The previous vertex in the shortest path found so far to each reached
+  // vertex.
+  std::vector<VertexId> prev_vertices_;
+
+  // The state of each vertex.
+  std::vector<VertexState> states_;
+
+  // The vertices reached by the last search, in the order they were reached.
+  std::vector<VertexId> reached_vertices_;
+
+  // The number of vertices settled by the last search.
+  int num_settled_;
+
+  // The operation counters of the heaps of all the searches.
+  HeapStats heap_stats_;
 };
 
 template <typename T>
 std::unordered_map<VertexId, Path<T>>
 DijkstraShortestPath<T>::Run(const WeightedGraph<T> &weighted_graph,
                              VertexId start_vertex_id) {
-  int num_adds = 0;
-  int num_pops = 0;
-  int num_reduce_keys = 0;
+  Search_(weighted_graph, start_vertex_id, kNoTargetVertex);
+
+  // Construct the shortest path for each node.
+  std::unordered_map<VertexId, Path<T>> results;
+  results.reserve(num_settled_);
+  for (VertexId vertex_id : reached_vertices_) {
+    if (states_[vertex_id] == kSettled) {
+      auto it = results.emplace(vertex_id, Path<T>{distances_[vertex_id]});
+      TracePath_(start_vertex_id, vertex_id, &it.first->second);
+    }
+  }
 
-  // Maps a vertex to previous vertex in its shortest path.
-  std::unordered_map<VertexId, VertexId> prev_vertex_map;
+  return results;
+}
 
-  // Set up a heap containing vertices that need to be visited. This is ordered
-  // by distance.
-  std::unique_ptr<Heap<DistanceNode<T>>> heap(heap_factory_());
+template <typename T>
+bool DijkstraShortestPath<T>::RunToTarget(
+    const WeightedGraph<T> &weighted_graph, VertexId start_vertex_id,
+    VertexId target_vertex_id, Path<T> *path, int *num_settled) {
+  Search_(weighted_graph, start_vertex_id, target_vertex_id);
 
-  // Initial distance = 0.
-  heap->Add(DistanceNode<T>(start_vertex_id, 0), start_vertex_id);
-  num_adds++;
+  if (num_settled != nullptr) {
+    *num_settled = num_settled_;
+  }
+  if (states_[target_vertex_id] != kSettled) {
+    return false;
+  }
+  *path = Path<T>(distances_[target_vertex_id]);
+  TracePath_(start_vertex_id, target_vertex_id, path);
+  return true;
+}
+
+template <typename T>
+void DijkstraShortestPath<T>::Search_(const WeightedGraph<T> &weighted_graph,
+                                      VertexId start_vertex_id,
+                                      VertexId target_vertex_id) {
+  // Forget the vertices reached by the previous search.
+  for (VertexId vertex_id : reached_vertices_) {
+    states_[vertex_id] = kUnreached;
+  }
+  reached_vertices_.clear();
+  num_settled_ = 0;
 
   const auto *graph = weighted_graph.graph.get();
   const auto *distances = weighted_graph.edge_weights.get();
+  const int num_vertices = graph->num_vertices();
+  if (static_cast<int>(states_.size()) != num_vertices) {
+    distances_.resize(num_vertices);
+    prev_vertices_.resize(num_vertices);
+    states_.assign(num_vertices, kUnreached);
+  }
+
+  // Set up a heap containing vertices that need to be visited. This is ordered
+  // by distance.
+  std::unique_ptr<Heap<T>> heap(heap_factory_());
+
+  // Initial distance = 0.
+  distances_[start_vertex_id] = 0;
+  states_[start_vertex_id] = kInHeap;
+  reached_vertices_.push_back(start_vertex_id);
+  heap->Add(0, start_vertex_id);
 
-  std::unordered_map<VertexId, Path<T>> results;
   while (!heap->empty()) {
-    // Pop the node with shortest distance and add to result.
-    DistanceNode<T> min_distance_node = heap->PopMinimum().first;
-    num_pops++;
-
-    // Skip if the shortest path is already found.
-    if (!results
-             .insert(std::make_pair(min_distance_node.vertex_id,
-                                    Path<T>{min_distance_node.distance}))
-             .second) {
-      continue;
+    // Pop the vertex with shortest distance. Its distance is final.
+    const VertexId vertex_id = heap->PopMinimum().second;
+    states_[vertex_id] = kSettled;
+    num_settled_++;
+
+    // The target's distance is final once it is popped.
+    if (vertex_id == target_vertex_id) {
+      break;
     }
 
-    const Vertex &from_vertex = graph->GetVertex(min_distance_node.vertex_id);
+    const T vertex_distance = distances_[vertex_id];
+    const Vertex &from_vertex = graph->GetVertex(vertex_id);
     for (const Edge &edge : from_vertex.edges()) {
       VertexId to_id = edge.to_vertex_id();
 
-      // If it's already in results, then there's already a shorter path.
-      if (results.find(to_id) != results.end()) {
+      // If it's already settled, then there's already a shorter path.
+      const VertexState to_state = states_[to_id];
+      if (to_state == kSettled) {
         continue;
       }
 
-      // Create new node and add to heap.
-      const auto distance = distances->Get(edge.id());
-      T total_distance = min_distance_node.distance + distance;
+      T total_distance = vertex_distance + distances->Get(edge.id());
       CHECK(total_distance >= 0);
 
-      const DistanceNode<T> *to_node = heap->LookUp(to_id);
-      if (to_node == nullptr) {
-        heap->Add(DistanceNode<T>{to_id, total_distance}, to_id);
-        num_adds++;
-        prev_vertex_map[to_id] = min_distance_node.vertex_id;
-      } else if (total_distance < to_node->distance) {
-        // Update the DistanceNode with a shorter distance.
-        heap->ReduceKey(DistanceNode<T>{to_id, total_distance}, to_id);
-        num_reduce_keys++;
-        prev_vertex_map[to_id] = min_distance_node.vertex_id;
+      if (to_state == kUnreached) {
+        distances_[to_id] = total_distance;
+        prev_vertices_[to_id] = vertex_id;
+        states_[to_id] = kInHeap;
+        reached_vertices_.push_back(to_id);
+        heap->Add(total_distance, to_id);
+      } else if (total_distance < distances_[to_id]) {
+        distances_[to_id] = total_distance;
+        prev_vertices_[to_id] = vertex_id;
+        heap->ReduceKey(total_distance, to_id);
       }
     }
   }
 
-  // Construct the shortest path for each node.
-  for (auto &result : results) {
-    VertexId vertex_id = result.first;
-    Path<T> &path = result.second;
-
-    // Trace the path backwards by looking up the prev_vertex_map.
-    while (vertex_id != start_vertex_id) {
-      path.vertices.push_back(vertex_id);
-      vertex_id = prev_vertex_map[vertex_id];
+  if (kEnableHeapStats) {
+    heap_stats_.Add(heap->Stats());
+    if (kDebugPrintStats) {
+      LOG(INFO) << heap_factory_.name() << ": " << heap->Stats();
     }
-    path.vertices.push_back(start_vertex_id);
-
-    std::reverse(path.vertices.begin(), path.vertices.end());
   }
+}
 
-  if (kDebugPrintStats) {
-    LOG(INFO) << "Heap operations: Adds: " << num_adds << " Pops: " << num_pops
-              << " ReduceKeys: " << num_reduce_keys;
+template <typename T>
+void DijkstraShortestPath<T>::TracePath_(VertexId start_vertex_id,
+                                         VertexId vertex_id,
+                                         Path<T> *path) const {
+  // Trace the path backwards through prev_vertices_.
+  while (vertex_id != start_vertex_id) {
+    path->vertices.push_back(vertex_id);
+    vertex_id = prev_vertices_[vertex_id];
   }
+  path->vertices.push_back(start_vertex_id);
 
-  return std::move(results);
+  std::reverse(path->vertices.begin(), path->vertices.end());
 }
 
 #endif /* SHORTEST_PATH_DIJKSTRA_SHORTEST_PATH_H_ */
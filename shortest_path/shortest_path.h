@@ -45,6 +45,25 @@ public:
   // `start_vertex_index` to all the vertices.
   virtual std::unordered_map<VertexId, Path<T>>
   Run(const WeightedGraph<T> &graph, VertexId start_vertex_index) = 0;
+
+  // Computes the shortest path from `start_vertex_id` to `target_vertex_id`.
+  // Returns false if the target can't be reached. If `num_settled` is not
+  // null, it is set to the number of vertices whose shortest path was found.
+  // The default implementation computes the paths to all the vertices.
+  virtual bool RunToTarget(const WeightedGraph<T> &graph,
+                           VertexId start_vertex_id, VertexId target_vertex_id,
+                           Path<T> *path, int *num_settled) {
+    auto results = Run(graph, start_vertex_id);
+    if (num_settled != nullptr) {
+      *num_settled = static_cast<int>(results.size());
+    }
+    auto it = results.find(target_vertex_id);
+    if (it == results.end()) {
+      return false;
+    }
+    *path = std::move(it->second);
+    return true;
+  }
 };
 
 #endif /* SHORTEST_PATH_SHORTEST_PATH_H_ */
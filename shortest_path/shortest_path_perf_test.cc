@@ -0,0 +1,446 @@
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/check.h"
+#include "absl/log/flags.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+#include "absl/strings/str_split.h"
+
+#include "base/factory.h"
+#include "base/memory.h"
+#include "base/perf.h"
+#include "base/perf_report.h"
+#include "graph/graph_generators.h"
+#include "graph/weighted_graph.h"
+#include "heaps/adaptive_heap.h"
+#include "heaps/b_heap.h"
+#include "heaps/binary_heap.h"
+#include "heaps/binomial_heap.h"
+#include "heaps/compact_pairing_heap.h"
+#include "heaps/compact_weak_heap.h"
+#include "heaps/dary_heap.h"
+#include "heaps/fibonacci_heap.h"
+#include "heaps/flat_two_three_heap.h"
+#include "heaps/heap.h"
+#include "heaps/indirect_binomial_heap.h"
+#include "heaps/pairing_heap.h"
+#include "heaps/thin_heap.h"
+#include "heaps/two_three_heap.h"
+#include "heaps/weak_heap.h"
+#include "shortest_path/bfs_shortest_path.h"
+#include "shortest_path/dijkstra_shortest_path.h"
+
+ABSL_FLAG(std::string, graph, "",
+          "DIMACS .gr file to load; if empty, a graph is generated");
+ABSL_FLAG(std::string, generator, "grid", "one of {grid, random}");
+ABSL_FLAG(int, num_vertices, 250000, "number of vertices to generate");
+ABSL_FLAG(int, edges_per_vertex, 8, "edges per vertex for random graphs");
+ABSL_FLAG(int, max_weight, 10000, "maximum generated edge weight");
+ABSL_FLAG(int, seed, 12345, "seed for the graph and the queries");
+ABSL_FLAG(std::string, query_sets, "random_pairs,dijkstra_rank,one_to_all",
+          "comma separated subset of {random_pairs, dijkstra_rank, "
+          "one_to_all}");
+ABSL_FLAG(int, num_queries, 200,
+          "queries per random_pairs set, and sources for dijkstra_rank");
+ABSL_FLAG(int, num_one_to_all, 5, "queries in the one_to_all set");
+ABSL_FLAG(std::string, engines,
+          "adaptive_heap,b_heap,binary_heap,binary_heap_bottom_up,"
+          "binomial_heap,compact_pairing_heap,compact_weak_heap,dary_heap_4,"
+          "dary_heap_8,dary_heap_16,fibonacci_heap,flat_two_three_heap,"
+          "indirect_binomial_heap,lazy_binomial_heap,pairing_heap,"
+          "pairing_heap_auxiliary,pairing_heap_back_to_front,"
+          "pairing_heap_front_to_back,pairing_heap_multipass,thin_heap,"
+          "two_three_heap,weak_heap",
+          "comma separated subset of {bfs, adaptive_heap, b_heap, "
+          "binary_heap, binary_heap_bottom_up, binomial_heap, "
+          "compact_pairing_heap, compact_weak_heap, dary_heap_4, dary_heap_8, "
+          "dary_heap_16, fibonacci_heap, flat_two_three_heap, "
+          "indirect_binomial_heap, lazy_binomial_heap, pairing_heap, "
+          "pairing_heap_auxiliary, pairing_heap_back_to_front, "
+          "pairing_heap_front_to_back, pairing_heap_multipass, thin_heap, "
+          "two_three_heap, weak_heap}; bfs is slow on large graphs");
+ABSL_FLAG(int, num_runs, 5, "number of timed runs of each query set");
+ABSL_FLAG(std::string, output_json, "",
+          "if set, write the results as JSON to this file");
+ABSL_FLAG(std::string, output_csv, "",
+          "if set, write the results as CSV to this file");
+
+namespace {
+
+// A shortest path query. A one-to-all query has no target.
+struct Query {
+  VertexId source;
+  VertexId target;
+};
+
+// A named set of queries, with the parameters that identify it in the report.
+struct QuerySet {
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> params;
+  std::vector<Query> queries;
+  bool one_to_all = false;
+};
+
+const VertexId kNoTarget = -1;
+
+// Returns the vertices reachable from `source` in the order Dijkstra's
+// algorithm settles them. The i-th vertex has Dijkstra rank i.
+std::vector<VertexId> SettleOrder(const WeightedGraph<int> &weighted_graph,
+                                  VertexId source) {
+  const Graph &graph = *weighted_graph.graph;
+  std::vector<int> distances(graph.num_vertices(), -1);
+  std::vector<bool> settled(graph.num_vertices(), false);
+  std::priority_queue<std::pair<int, VertexId>,
+                      std::vector<std::pair<int, VertexId>>,
+                      std::greater<std::pair<int, VertexId>>>
+      queue;
+
+  std::vector<VertexId> order;
+  distances[source] = 0;
+  queue.emplace(0, source);
+  while (!queue.empty()) {
+    VertexId vertex_id = queue.top().second;
+    queue.pop();
+    if (settled[vertex_id]) {
+      continue;
+    }
+    settled[vertex_id] = true;
+    order.push_back(vertex_id);
+
+    for (const Edge &edge : graph.GetVertex(vertex_id).edges()) {
+      int distance =
+          distances[vertex_id] + weighted_graph.edge_weights->Get(edge.id());
+      int &to_distance = distances[edge.to_vertex_id()];
+      if (to_distance < 0 || distance < to_distance) {
+        to_distance = distance;
+        queue.emplace(distance, edge.to_vertex_id());
+      }
+    }
+  }
+  return order;
+}
+
+// Builds the query sets named in --query_sets.
+std::vector<QuerySet> BuildQuerySets(const WeightedGraph<int> &graph) {
+  std::mt19937 random(absl::GetFlag(FLAGS_seed));
+  std::uniform_int_distribution<VertexId> random_vertex(
+      0, graph.graph->num_vertices() - 1);
+  const int num_queries = absl::GetFlag(FLAGS_num_queries);
+
+  std::vector<QuerySet> query_sets;
+  for (absl::string_view name :
+       absl::StrSplit(absl::GetFlag(FLAGS_query_sets), ',')) {
+    if (name == "random_pairs") {
+      QuerySet query_set;
+      query_set.name = std::string(name);
+      for (int i = 0; i < num_queries; ++i) {
+        query_set.queries.push_back({random_vertex(random),
+                                     random_vertex(random)});
+      }
+      query_sets.push_back(std::move(query_set));
+    } else if (name == "dijkstra_rank") {
+      // One set per rank 2^r, each with a query from every source to the
+      // vertex it settles 2^r-th, as in Sanders and Schultes.
+      std::map<int, QuerySet> sets_by_rank;
+      for (int i = 0; i < num_queries; ++i) {
+        VertexId source = random_vertex(random);
+        std::vector<VertexId> order = SettleOrder(graph, source);
+        for (int rank = 2; rank < order.size(); rank *= 2) {
+          sets_by_rank[rank].queries.push_back({source, order[rank]});
+        }
+      }
+      for (auto &entry : sets_by_rank) {
+        QuerySet &query_set = entry.second;
+        query_set.name = std::string(name);
+        query_set.params.emplace_back("rank", std::to_string(entry.first));
+        query_sets.push_back(std::move(query_set));
+      }
+    } else if (name == "one_to_all") {
+      QuerySet query_set;
+      query_set.name = std::string(name);
+      query_set.one_to_all = true;
+      for (int i = 0; i < absl::GetFlag(FLAGS_num_one_to_all); ++i) {
+        query_set.queries.push_back({random_vertex(random), kNoTarget});
+      }
+      query_sets.push_back(std::move(query_set));
+    } else {
+      LOG(FATAL) << "Unknown query set: " << name;
+    }
+  }
+  return query_sets;
+}
+
+// Loads the graph from --graph, or generates one.
+std::unique_ptr<WeightedGraph<int>> LoadGraph() {
+  const std::string path = absl::GetFlag(FLAGS_graph);
+  if (!path.empty()) {
+    std::unique_ptr<WeightedGraph<int>> graph = ReadDimacsGraph(path);
+    if (graph == nullptr) {
+      LOG(FATAL) << "Failed to read graph " << path;
+    }
+    return graph;
+  }
+
+  const std::string generator = absl::GetFlag(FLAGS_generator);
+  const int num_vertices = absl::GetFlag(FLAGS_num_vertices);
+  const int max_weight = absl::GetFlag(FLAGS_max_weight);
+  const unsigned seed = absl::GetFlag(FLAGS_seed);
+  if (generator == "grid") {
+    int width = static_cast<int>(std::sqrt(num_vertices));
+    return GenerateGridGraph(width, num_vertices / width, max_weight, seed);
+  } else if (generator == "random") {
+    return GenerateRandomGraph(num_vertices,
+                               absl::GetFlag(FLAGS_edges_per_vertex),
+                               max_weight, seed);
+  }
+  LOG(FATAL) << "Unknown generator: " << generator;
+  return nullptr;
+}
+
+// Runs every query of the set once, recording per-query latencies, and the
+// operation counters of a Dijkstra engine's heaps when they are counted.
+// Returns the total number of settled vertices. The distance found by each
+// query is stored in `distances`: -1 if the target is unreachable, and the sum
+// of all distances for one-to-all queries.
+long RunQueries(const Factory<ShortestPath<int>> &factory,
+                const WeightedGraph<int> &graph, const QuerySet &query_set,
+                PerfTimer *timer, std::vector<long> *distances) {
+  std::unique_ptr<ShortestPath<int>> shortest_path = factory();
+  LatencyHistogram *latency = timer->OperationLatency("Query");
+  distances->clear();
+  long total_settled = 0;
+
+  timer->Start();
+  for (const Query &query : query_set.queries) {
+    ScopedLatency scoped_latency(latency);
+    int num_settled = 0;
+    long distance = -1;
+    if (query_set.one_to_all) {
+      auto results = shortest_path->Run(graph, query.source);
+      num_settled = static_cast<int>(results.size());
+      distance = 0;
+      for (const auto &result : results) {
+        distance += result.second.distance;
+      }
+    } else {
+      Path<int> path(0);
+      if (shortest_path->RunToTarget(graph, query.source, query.target, &path,
+                                     &num_settled)) {
+        distance = path.distance;
+      }
+    }
+    total_settled += num_settled;
+    distances->push_back(distance);
+  }
+  timer->Stop();
+  const auto *dijkstra =
+      dynamic_cast<const DijkstraShortestPath<int> *>(shortest_path.get());
+  if (kEnableHeapStats && dijkstra != nullptr) {
+    for (const auto &stat : dijkstra->heap_stats().ToList()) {
+      timer->AddStat(stat.first, stat.second);
+    }
+  }
+  return total_settled;
+}
+
+// Runs the query set `num_runs` times with one engine, and adds the result to
+// `report`. The distances found are checked against `expected_distances`, or
+// stored there if it's empty.
+void RunQuerySet(const Factory<ShortestPath<int>> &factory,
+                 const WeightedGraph<int> &graph, const QuerySet &query_set,
+                 int num_runs, std::vector<long> *expected_distances,
+                 PerfReport *report) {
+  PerfResult result;
+  result.binary = "shortest_path_perf_test";
+  result.benchmark = query_set.name;
+  result.implementation = factory.name();
+  result.params = {{"graph", graph.graph->name()},
+                   {"num_queries", std::to_string(query_set.queries.size())}};
+  result.params.insert(result.params.end(), query_set.params.begin(),
+                       query_set.params.end());
+
+  long total_time_us = 0;
+  long total_settled = 0;
+  long peak_query_bytes = 0;
+  std::vector<long> distances;
+  std::vector<std::pair<std::string, double>> heap_stats;
+  for (int i = 0; i < num_runs; ++i) {
+    PerfTimer timer;
+    const long allocated_before = AllocatedBytes();
+    ResetPeakAllocatedBytes();
+    total_settled += RunQueries(factory, graph, query_set, &timer, &distances);
+    peak_query_bytes = std::max(peak_query_bytes,
+                                PeakAllocatedBytes() - allocated_before);
+    total_time_us += timer.TotalDurationUs();
+    result.run_times_us.push_back(timer.TotalDurationUs());
+    result.num_operations += timer.NumOperations();
+    for (const auto &entry : timer.operation_latencies()) {
+      result.operation_latencies[entry.first].Merge(entry.second);
+    }
+    result.counter_values.Add(timer.counter_values());
+    heap_stats = timer.stats();
+  }
+
+  if (expected_distances->empty()) {
+    *expected_distances = distances;
+  } else {
+    CHECK(distances == *expected_distances)
+        << factory.name() << " disagrees on " << query_set.name << " results";
+  }
+
+  const double ave_time_us = static_cast<double>(total_time_us) / num_runs;
+  const double queries_per_sec =
+      ave_time_us > 0 ? query_set.queries.size() * 1e6 / ave_time_us : 0;
+  const double settled_per_query =
+      static_cast<double>(total_settled) / result.num_operations;
+  result.stats = {{"queries_per_sec", queries_per_sec},
+                  {"settled_per_query", settled_per_query},
+                  {"peak_rss_bytes", static_cast<double>(PeakRssBytes())}};
+  if (AllocatedBytes() >= 0) {
+    // Memory allocated by the engine while running one query.
+    result.stats.emplace_back("peak_query_bytes",
+                              static_cast<double>(peak_query_bytes));
+  }
+  result.stats.insert(result.stats.end(), heap_stats.begin(),
+                      heap_stats.end());
+
+  std::cout << factory.name() << ": " << query_set.name;
+  for (const auto &param : query_set.params) {
+    std::cout << " " << param.first << "=" << param.second;
+  }
+  std::cout << " (" << num_runs << " runs) "
+            << static_cast<long>(ave_time_us / 1000) << " ms, "
+            << queries_per_sec << " queries/s, "
+            << static_cast<long>(settled_per_query) << " settled/query";
+  if (AllocatedBytes() >= 0) {
+    std::cout << ", " << peak_query_bytes / 1024 << " KB/query";
+  }
+  std::cout << std::endl;
+  PrintOperationLatencies(result.operation_latencies, std::cout);
+  result.counter_values.PrintPerOperation(result.num_operations, std::cout);
+  if (!heap_stats.empty()) {
+    std::cout << "  Heap stats (last run):";
+    for (const auto &stat : heap_stats) {
+      std::cout << " " << stat.first << " " << stat.second;
+    }
+    std::cout << std::endl;
+  }
+  report->Add(std::move(result));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  absl::InitializeLog();
+
+  std::map<std::string, Factory<ShortestPath<int>>> engine_factories{
+      {"bfs", BfsShortestPath<int>::factory()},
+      {"adaptive_heap",
+       DijkstraShortestPath<int>::factory(AdaptiveHeap<int>::factory())},
+      {"b_heap", DijkstraShortestPath<int>::factory(BHeap<int>::factory())},
+      {"binary_heap",
+       DijkstraShortestPath<int>::factory(BinaryHeap<int>::factory())},
+      {"binary_heap_bottom_up",
+       DijkstraShortestPath<int>::factory(BinaryHeap<int, true>::factory())},
+      {"binomial_heap",
+       DijkstraShortestPath<int>::factory(BinomialHeap<int>::factory())},
+      {"compact_pairing_heap",
+       DijkstraShortestPath<int>::factory(CompactPairingHeap<int>::factory())},
+      {"compact_weak_heap",
+       DijkstraShortestPath<int>::factory(CompactWeakHeap<int>::factory())},
+      {"dary_heap_4",
+       DijkstraShortestPath<int>::factory(DaryHeap<int, 4>::factory())},
+      {"dary_heap_8",
+       DijkstraShortestPath<int>::factory(DaryHeap<int, 8>::factory())},
+      {"dary_heap_16",
+       DijkstraShortestPath<int>::factory(DaryHeap<int, 16>::factory())},
+      {"fibonacci_heap",
+       DijkstraShortestPath<int>::factory(FibonacciHeap<int>::factory())},
+      {"flat_two_three_heap",
+       DijkstraShortestPath<int>::factory(FlatTwoThreeHeap<int>::factory())},
+      {"indirect_binomial_heap",
+       DijkstraShortestPath<int>::factory(
+           IndirectBinomialHeap<int>::factory())},
+      {"lazy_binomial_heap",
+       DijkstraShortestPath<int>::factory(
+           IndirectBinomialHeap<int, true>::factory())},
+      {"pairing_heap",
+       DijkstraShortestPath<int>::factory(PairingHeap<int>::factory())},
+      {"pairing_heap_auxiliary",
+       DijkstraShortestPath<int>::factory(
+           PairingHeap<int, TwoPassPairing, true>::factory())},
+      {"pairing_heap_back_to_front",
+       DijkstraShortestPath<int>::factory(
+           PairingHeap<int, BackToFrontPairing>::factory())},
+      {"pairing_heap_front_to_back",
+       DijkstraShortestPath<int>::factory(
+           PairingHeap<int, FrontToBackPairing>::factory())},
+      {"pairing_heap_multipass",
+       DijkstraShortestPath<int>::factory(
+           PairingHeap<int, MultipassPairing>::factory())},
+      {"thin_heap",
+       DijkstraShortestPath<int>::factory(ThinHeap<int>::factory())},
+      {"two_three_heap",
+       DijkstraShortestPath<int>::factory(TwoThreeHeap<int>::factory())},
+      {"weak_heap",
+       DijkstraShortestPath<int>::factory(WeakHeap<int>::factory())}};
+
+  std::vector<Factory<ShortestPath<int>>> factories;
+  for (absl::string_view name :
+       absl::StrSplit(absl::GetFlag(FLAGS_engines), ',')) {
+    auto it = engine_factories.find(std::string(name));
+    if (it == engine_factories.end()) {
+      LOG(FATAL) << "Unknown engine: " << name;
+    }
+    factories.push_back(it->second);
+  }
+
+  const long allocated_before_graph = AllocatedBytes();
+  std::unique_ptr<WeightedGraph<int>> graph = LoadGraph();
+  const int num_edges = graph->graph->num_edges();
+  std::cout << "Graph " << graph->graph->name() << ": "
+            << graph->graph->num_vertices() << " vertices, " << num_edges
+            << " edges, "
+            << static_cast<double>(graph->MemoryUsage()) / num_edges
+            << " bytes/edge";
+  if (allocated_before_graph >= 0) {
+    std::cout << " ("
+              << static_cast<double>(AllocatedBytes() -
+                                     allocated_before_graph) /
+                     num_edges
+              << " allocated)";
+  }
+  std::cout << ", peak RSS " << PeakRssBytes() / (1024 * 1024) << " MB"
+            << std::endl;
+
+  std::vector<QuerySet> query_sets = BuildQuerySets(*graph);
+  std::vector<std::vector<long>> expected_distances(query_sets.size());
+  const int num_runs = absl::GetFlag(FLAGS_num_runs);
+
+  PerfReport report;
+  for (const auto &factory : factories) {
+    std::cout << std::endl << "Perf Testing " << factory.name() << std::endl;
+    for (int i = 0; i < query_sets.size(); ++i) {
+      RunQuerySet(factory, *graph, query_sets[i], num_runs,
+                  &expected_distances[i], &report);
+    }
+  }
+  std::cout << "Peak RSS " << PeakRssBytes() / (1024 * 1024) << " MB"
+            << std::endl;
+
+  if (!report.WriteFiles(absl::GetFlag(FLAGS_output_json),
+                         absl::GetFlag(FLAGS_output_csv))) {
+    LOG(FATAL) << "Failed to write the results";
+  }
+
+  return 0;
+}
@@ -9,10 +9,17 @@
 #include "absl/log/log.h"
 
 #include "graph/weighted_graph.h"
+#include "heaps/adaptive_heap.h"
+#include "heaps/b_heap.h"
 #include "heaps/binary_heap.h"
 #include "heaps/binomial_heap.h"
+#include "heaps/compact_pairing_heap.h"
+#include "heaps/compact_weak_heap.h"
+#include "heaps/dary_heap.h"
 #include "heaps/fibonacci_heap.h"
+#include "heaps/flat_two_three_heap.h"
 #include "heaps/heap.h"
+#include "heaps/indirect_binomial_heap.h"
 #include "heaps/pairing_heap.h"
 #include "heaps/thin_heap.h"
 #include "heaps/two_three_heap.h"
@@ -87,6 +94,37 @@ public:
     Run(weighted_graph, 0);
   }
 
+  // Checks point-to-point queries against the paths to all the vertices,
+  // reusing one instance of each implementation for all the queries.
+  void TestRunToTarget() {
+    LOG(INFO) << "Testing point-to-point queries";
+    WeightedGraph<int> weighted_graph = BuildRandomGraph_();
+    const int num_vertices = weighted_graph.graph->num_vertices();
+    for (const auto &factory : factories_) {
+      std::unique_ptr<ShortestPath<int>> shortest_path{factory()};
+      for (int i = 0; i < 5; i++) {
+        const VertexId start_vertex_id = rand() % num_vertices;
+        auto results = shortest_path->Run(weighted_graph, start_vertex_id);
+        for (int j = 0; j < 20; j++) {
+          const VertexId target_vertex_id = rand() % num_vertices;
+          Path<int> path(0);
+          int num_settled = 0;
+          const bool found =
+              shortest_path->RunToTarget(weighted_graph, start_vertex_id,
+                                         target_vertex_id, &path, &num_settled);
+          auto it = results.find(target_vertex_id);
+          CHECK(found == (it != results.end())) << factory.name();
+          CHECK(num_settled <= results.size()) << factory.name();
+          if (found) {
+            CHECK(path.distance == it->second.distance) << factory.name();
+            CHECK(path.vertices.front() == start_vertex_id);
+            CHECK(path.vertices.back() == target_vertex_id);
+          }
+        }
+      }
+    }
+  }
+
 private:
   static WeightedGraph<int> BuildSimpleGraph_() {
     std::unique_ptr<GraphBuilder> builder = GraphBuilder::Builder("simple");
@@ -149,30 +187,55 @@ private:
   const std::vector<Factory<ShortestPath<int>>> &factories_;
 };
 
+// Thresholds with small samples, so that an AdaptiveHeap switches between
+// its heaps during a search.
+AdaptiveHeapThresholds SwitchingAdaptiveHeapThresholds() {
+  AdaptiveHeapThresholds thresholds;
+  thresholds.sample_interval = 20;
+  thresholds.samples_to_switch = 1;
+  thresholds.pairing_reduce_key_fractions = {{1, 2}, {100, 0.1}};
+  return thresholds;
+}
+
 void RunShortestPathTests() {
-  Factory<ShortestPath<int>> f1 = DijkstraShortestPath<int>::factory(
-      BinaryHeap<DistanceNode<int>>::factory());
+  Factory<ShortestPath<int>> f1 =
+      DijkstraShortestPath<int>::factory(BinaryHeap<int>::factory());
 
   std::vector<Factory<ShortestPath<int>>> factories{
       BfsShortestPath<int>::factory(),
+      DijkstraShortestPath<int>::factory(BinaryHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(BinaryHeap<int, true>::factory()),
+      DijkstraShortestPath<int>::factory(BHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(DaryHeap<int, 4>::factory()),
+      DijkstraShortestPath<int>::factory(DaryHeap<int, 8>::factory()),
+      DijkstraShortestPath<int>::factory(BinomialHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(IndirectBinomialHeap<int>::factory()),
       DijkstraShortestPath<int>::factory(
-          BinaryHeap<DistanceNode<int>>::factory()),
-      DijkstraShortestPath<int>::factory(
-          BinomialHeap<DistanceNode<int>>::factory()),
+          IndirectBinomialHeap<int, true>::factory()),
+      DijkstraShortestPath<int>::factory(WeakHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(CompactWeakHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(PairingHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(CompactPairingHeap<int>::factory()),
       DijkstraShortestPath<int>::factory(
-          WeakHeap<DistanceNode<int>>::factory()),
+          PairingHeap<int, MultipassPairing>::factory()),
       DijkstraShortestPath<int>::factory(
-          PairingHeap<DistanceNode<int>>::factory()),
+          PairingHeap<int, FrontToBackPairing>::factory()),
       DijkstraShortestPath<int>::factory(
-          TwoThreeHeap<DistanceNode<int>>::factory()),
+          PairingHeap<int, BackToFrontPairing>::factory()),
       DijkstraShortestPath<int>::factory(
-          FibonacciHeap<DistanceNode<int>>::factory()),
+          PairingHeap<int, TwoPassPairing, true>::factory()),
+      DijkstraShortestPath<int>::factory(TwoThreeHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(FlatTwoThreeHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(FibonacciHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(ThinHeap<int>::factory()),
+      DijkstraShortestPath<int>::factory(AdaptiveHeap<int>::factory()),
       DijkstraShortestPath<int>::factory(
-          ThinHeap<DistanceNode<int>>::factory()),
+          AdaptiveHeap<int>::factory(SwitchingAdaptiveHeapThresholds())),
   };
   ShortestPathTester tester{factories};
   tester.TestSimpleGraph();
   tester.TestRandomGraph();
+  tester.TestRunToTarget();
 }
 
 } // namespace